@@ -0,0 +1,206 @@
+#include "blocking_set.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <unordered_set>
+
+#include "linear.h"
+#include "z3_utils.h"
+
+void BlockingSet::start() { solver.push(); }
+
+bool BlockingSet::contains(const Bounds& a, const Bounds& b) {
+  auto it = b.begin();
+  for (const auto& varinterval : a) {
+    const unsigned int id = varinterval.first.id();
+    while (it != b.end() && it->first.id() < id) ++it;
+    if (it == b.end() || it->first.id() != id) return false;
+    if (it->second.get_low() < varinterval.second.get_low() ||
+        it->second.get_high() > varinterval.second.get_high())
+      return false;
+  }
+  return true;
+}
+
+bool BlockingSet::join(const Bounds& a, const Bounds& b, Bounds& joined) {
+  if (a.size() != b.size()) return false;
+  size_t differing = a.size();
+  for (size_t k = 0; k < a.size(); k++) {
+    if (a[k].first.id() != b[k].first.id()) return false;
+    const Interval& i = a[k].second;
+    const Interval& j = b[k].second;
+    if (i.get_low() == j.get_low() && i.get_high() == j.get_high()) continue;
+    if (differing < a.size()) return false;
+    // overlapping or adjacent
+    if ((int128_t)i.get_high() + 1 < j.get_low() ||
+        (int128_t)j.get_high() + 1 < i.get_low())
+      return false;
+    differing = k;
+  }
+  joined = a;
+  if (differing == a.size()) return true;
+  const Interval& i = a[differing].second;
+  const Interval& j = b[differing].second;
+  const Interval u(std::min(i.get_low(), j.get_low()),
+                   std::max(i.get_high(), j.get_high()));
+  // a free bool or an unbounded variable is no longer blocked
+  if ((a[differing].first.is_bool() && u.get_low() != u.get_high()) ||
+      u.is_top())
+    joined.erase(joined.begin() + differing);
+  else
+    joined[differing].second = u;
+  return true;
+}
+
+z3::expr BlockingSet::to_expr(const Block& block) const {
+  z3::expr_vector bounds(c);
+  for (const auto& varinterval : block.bounds) {
+    const z3::expr& var = varinterval.first;
+    const Interval& interval = varinterval.second;
+    if (var.is_bool()) {
+      bounds.push_back(interval.get_low() ? var : !var);
+    } else if (var.is_bv()) {
+      // for 64 bits, the infinities are the ends of the domain
+      const unsigned int width = var.get_sort().bv_size();
+      if (!interval.is_low_minf())
+        bounds.push_back(z3::uge(
+            var, c.bv_val(bv_from_box(interval.get_low(), width), width)));
+      if (!interval.is_high_inf())
+        bounds.push_back(z3::ule(
+            var, c.bv_val(bv_from_box(interval.get_high(), width), width)));
+    } else {
+      if (!interval.is_low_minf())
+        bounds.push_back(var >= c.int_val(interval.get_low()));
+      if (!interval.is_high_inf())
+        bounds.push_back(var <= c.int_val(interval.get_high()));
+    }
+  }
+  if (block.extra) bounds.push_back(block.extra);
+  return z3::mk_and(bounds);
+}
+
+void BlockingSet::assert_block(const Block& block) {
+  solver.add(z3::implies(block.guard, !to_expr(block)));
+}
+
+void BlockingSet::push_block(Bounds bounds, const z3::expr& extra) {
+  const std::string name = "mega!block!" + std::to_string(next_guard++);
+  active.push_back(
+      Block{std::move(bounds), extra, c.bool_const(name.c_str())});
+  assert_block(active.back());
+}
+
+std::list<BlockingSet::Block>::iterator BlockingSet::disable(
+    std::list<Block>::iterator it) {
+  solver.add(!it->guard);
+  retired_in_scope++;
+  return active.erase(it);
+}
+
+void BlockingSet::add(const IntervalMap& i_map, const z3::expr& extra) {
+  Bounds box;
+  for (const auto& varinterval : i_map) {
+    const Interval& interval = varinterval.second;
+    if (varinterval.first.is_bool()
+            ? interval.get_low() == interval.get_high()
+            : !interval.is_top())
+      box.push_back(varinterval);
+  }
+  std::sort(box.begin(), box.end(), [](const auto& a, const auto& b) {
+    return a.first.id() < b.first.id();
+  });
+  if (box.empty() && !bool(extra)) return;  // would block everything
+  added++;
+  if (!bool(extra)) {
+    for (const auto& block : active) {
+      if (!bool(block.extra) && contains(block.bounds, box)) {
+        subsumed++;
+        return;
+      }
+    }
+    for (auto it = active.begin(); it != active.end();) {
+      if (!bool(it->extra) && contains(box, it->bounds)) {
+        it = disable(it);
+        subsumed++;
+      } else {
+        ++it;
+      }
+    }
+  }
+  push_block(std::move(box), extra);
+  while (active.size() > max_active) {
+    disable(active.begin());  // the oldest
+    retired++;
+  }
+  if (added % MERGE_PERIOD == 0) merge();
+  if (retired_in_scope >= max_active) rebuild();
+}
+
+void BlockingSet::merge() {
+  // one pass; the unions go to the end and are joined by later boxes
+  for (auto a = active.begin(); a != active.end();) {
+    Bounds joined;
+    auto b = std::next(a);
+    if (!bool(a->extra)) {
+      while (b != active.end() &&
+             (bool(b->extra) || !join(a->bounds, b->bounds, joined)))
+        ++b;
+    }
+    if (bool(a->extra) || b == active.end()) {
+      ++a;
+      continue;
+    }
+    disable(b);
+    a = disable(a);
+    merged++;
+    if (!joined.empty()) push_block(std::move(joined), z3::expr(c));
+  }
+}
+
+void BlockingSet::rebuild() {
+  solver.pop();
+  solver.push();
+  for (const auto& block : active) assert_block(block);
+  retired_in_scope = 0;
+  rebuilds++;
+}
+
+z3::expr_vector BlockingSet::assumptions() const {
+  z3::expr_vector guards(c);
+  for (const auto& block : active) guards.push_back(block.guard);
+  return guards;
+}
+
+bool BlockingSet::retire_core() {
+  if (active.empty()) return false;
+  std::unordered_set<unsigned int> core;
+  const z3::expr_vector unsat_core = solver.unsat_core();
+  for (unsigned int i = 0; i < unsat_core.size(); i++)
+    core.insert(unsat_core[i].id());
+  const size_t before = active.size();
+  for (auto it = active.begin(); it != active.end();) {
+    if (core.count(it->guard.id())) {
+      it = disable(it);
+    } else {
+      ++it;
+    }
+  }
+  if (active.size() == before) {
+    while (!active.empty()) disable(active.begin());
+  }
+  retired += before - active.size();
+  if (retired_in_scope >= max_active) rebuild();
+  return true;
+}
+
+Json::Value BlockingSet::to_json() const {
+  Json::Value stats;
+  stats["active clauses"] = (Json::UInt64)active.size();
+  stats["added"] = (Json::UInt64)added;
+  stats["subsumed"] = (Json::UInt64)subsumed;
+  stats["merged"] = (Json::UInt64)merged;
+  stats["retired"] = (Json::UInt64)retired;
+  stats["rebuilds"] = (Json::UInt64)rebuilds;
+  return stats;
+}
@@ -0,0 +1,91 @@
+#ifndef MEGASAMPLER_BLOCKING_SET_H
+#define MEGASAMPLER_BLOCKING_SET_H
+
+#include <jsoncpp/json/json.h>
+#include <z3++.h>
+
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "intervalmap.h"
+
+/*
+ * The blocking clauses of MeGAb. Every clause !(box) is guarded by a fresh
+ * bool constant, guard -> !(box), and is only enforced while its guard is
+ * passed to the solver as an assumption. Clauses can thus be retired one by
+ * one: those in the unsat core when everything is blocked, the oldest ones
+ * over max_active, and boxes subsumed by or merged into a larger box. The
+ * guarded clauses live in a scope of their own, which is rebuilt with only
+ * the active clauses once enough of them are retired, so the solver does not
+ * keep growing.
+ */
+class BlockingSet {
+ public:
+  BlockingSet(z3::context& c, z3::solver& solver, size_t max_active)
+      : c(c), solver(solver), max_active(max_active) {}
+
+  /* opens the scope of the clauses, after the formula is asserted */
+  void start();
+  /*
+   * Blocks the box of i_map and extra, a formula over other variables (real
+   * bounds, a region) or null for none. Boxes with an extra are never
+   * subsumed or merged.
+   */
+  void add(const IntervalMap& i_map, const z3::expr& extra);
+  /* the guards of the active clauses, to assume in solver.check */
+  [[nodiscard]] z3::expr_vector assumptions() const;
+  /*
+   * After the solver returned unsat under the assumptions, retires the
+   * clauses of its unsat core (all of them if the core is empty). Returns
+   * false if no clause was active.
+   */
+  bool retire_core();
+
+  [[nodiscard]] size_t size() const { return active.size(); }
+  [[nodiscard]] Json::Value to_json() const;
+
+ private:
+  static constexpr unsigned int MERGE_PERIOD = 16;  // adds between merges
+  // only the bounds that block something, sorted by the ids of the variables
+  typedef std::vector<std::pair<z3::expr, Interval>> Bounds;
+  struct Block {
+    Bounds bounds;
+    z3::expr extra;
+    z3::expr guard;
+  };
+  z3::context& c;
+  z3::solver& solver;
+  const size_t max_active;
+  std::list<Block> active;
+  unsigned long next_guard = 0;
+  unsigned long retired_in_scope = 0;  // disabled clauses still in the solver
+
+  unsigned long added = 0;
+  unsigned long subsumed = 0;
+  unsigned long merged = 0;
+  unsigned long retired = 0;
+  unsigned long rebuilds = 0;
+
+  /* asserts guard -> !(box) */
+  void assert_block(const Block& block);
+  /* adds an active clause with a fresh guard */
+  void push_block(Bounds bounds, const z3::expr& extra);
+  /* turns the guard off for good and drops the clause */
+  std::list<Block>::iterator disable(std::list<Block>::iterator it);
+  /* merges pairs of boxes that differ in a single overlapping interval */
+  void merge();
+  /* pops the scope and asserts again only the active clauses */
+  void rebuild();
+  [[nodiscard]] z3::expr to_expr(const Block& block) const;
+  /* whether the box of a contains the box of b */
+  [[nodiscard]] static bool contains(const Bounds& a, const Bounds& b);
+  /*
+   * If a and b have the same intervals but on one variable, where they
+   * overlap or touch, sets joined to their union and returns true.
+   */
+  [[nodiscard]] static bool join(const Bounds& a, const Bounds& b,
+                                 Bounds& joined);
+};
+
+#endif  // MEGASAMPLER_BLOCKING_SET_H
@@ -0,0 +1,92 @@
+#include "box_registry.h"
+
+#include <algorithm>
+
+#include "z3_utils.h"
+
+bool BoxRegistry::same_box(const IntervalMap& a, const IntervalMap& b) {
+  if (a.size() != b.size()) return false;
+  for (const auto& varinterval : a) {
+    const auto it = b.find(varinterval.first);
+    if (it == b.end()) return false;
+    if (it->second.get_low() != varinterval.second.get_low() ||
+        it->second.get_high() != varinterval.second.get_high())
+      return false;
+  }
+  return true;
+}
+
+bool BoxRegistry::add(const IntervalMap& i_map,
+                      const std::list<z3::expr>& select_terms) {
+  uint128_t volume;
+  if (!intervals_volume(i_map, volume)) return false;
+  for (const auto& box : boxes) {
+    if (same_box(box.i_map, i_map)) return false;
+  }
+  if (boxes.size() >= max_boxes) {
+    auto smallest = std::min_element(
+        boxes.begin(), boxes.end(),
+        [](const Box& a, const Box& b) { return a.volume < b.volume; });
+    if (smallest->volume >= volume) return false;
+    *smallest = Box{i_map, select_terms, volume};
+  } else {
+    boxes.push_back(Box{i_map, select_terms, volume});
+  }
+  distribution_outdated = true;
+  return true;
+}
+
+const BoxRegistry::Box& BoxRegistry::choose(std::mt19937& g) {
+  assert(!boxes.empty());
+  if (distribution_outdated) {
+    std::vector<double> weights;
+    weights.reserve(boxes.size());
+    for (const auto& box : boxes) weights.push_back((double)box.volume);
+    box_distribution =
+        std::discrete_distribution<size_t>(weights.begin(), weights.end());
+    distribution_outdated = false;
+  }
+  return boxes[box_distribution(g)];
+}
+
+bool BoxRegistry::contains(const Box& box, Model& sample) {
+  for (const auto& varinterval : box.i_map) {
+    const z3::expr& var = varinterval.first;
+    std::pair<int64_t, bool> value;
+    if (var.is_bool()) {
+      value = sample.evalBoolVar(var.to_string());
+    } else if (var.is_bv()) {
+      const auto bv_value = sample.evalBvVar(var.to_string());
+      value = {bv_to_box(bv_value.first, var.get_sort().bv_size()),
+               bv_value.second};
+    } else if (var.is_const()) {
+      value = sample.evalIntVar(var.to_string());
+    } else {
+      assert(is_op_select(get_op(var)));
+      const auto index = sample.evalIntExpr(var.arg(1));
+      if (!index.second) return false;
+      value = sample.evalArrayVar(var.arg(0).to_string(), index.first);
+    }
+    if (!value.second || !varinterval.second.is_in_range(value.first))
+      return false;
+  }
+  return true;
+}
+
+bool BoxRegistry::accept(Model& sample, std::mt19937& g) {
+  unsigned int containing = 0;
+  for (const auto& box : boxes) {
+    if (contains(box, sample)) containing++;
+  }
+  if (containing <= 1) return true;
+  if (std::uniform_int_distribution<unsigned int>(1, containing)(g) == 1)
+    return true;
+  rejected++;
+  return false;
+}
+
+long double BoxRegistry::get_total_volume() const {
+  long double total = 0.0;
+  for (const auto& box : boxes) total += (long double)box.volume;
+  return total;
+}
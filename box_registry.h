@@ -0,0 +1,60 @@
+#ifndef MEGASAMPLER_BOX_REGISTRY_H
+#define MEGASAMPLER_BOX_REGISTRY_H
+
+#include <z3++.h>
+
+#include <list>
+#include <random>
+#include <vector>
+
+#include "intervalmap.h"
+#include "model.h"
+
+/*
+ * The finite boxes found so far, for sampling across all of them with
+ * probability proportional to their volume. Points in the overlap of k boxes
+ * are accepted with probability 1/k, so the accepted points are uniform over
+ * the union of the boxes.
+ */
+class BoxRegistry {
+ public:
+  struct Box {
+    IntervalMap i_map;
+    std::list<z3::expr> select_terms;  // sorted, as in MEGASampler
+    uint128_t volume;
+  };
+
+  explicit BoxRegistry(size_t max_boxes) : max_boxes(max_boxes) {}
+
+  /*
+   * Registers a box. Returns false if the box is infinite, too large to count
+   * or already registered. When the registry is full, the smallest box is
+   * replaced if the new one is larger.
+   */
+  bool add(const IntervalMap& i_map, const std::list<z3::expr>& select_terms);
+  /* Picks a box with probability proportional to its volume */
+  const Box& choose(std::mt19937& g);
+  /*
+   * Overlap correction: returns true with probability 1/k, where k is the
+   * number of registered boxes containing the sample.
+   */
+  bool accept(Model& sample, std::mt19937& g);
+
+  [[nodiscard]] size_t size() const { return boxes.size(); }
+  [[nodiscard]] bool empty() const { return boxes.empty(); }
+  [[nodiscard]] long double get_total_volume() const;
+  [[nodiscard]] unsigned long get_rejected() const { return rejected; }
+
+ private:
+  const size_t max_boxes;
+  std::vector<Box> boxes;
+  std::discrete_distribution<size_t> box_distribution;
+  bool distribution_outdated = true;
+  unsigned long rejected = 0;
+
+  [[nodiscard]] static bool contains(const Box& box, Model& sample);
+  [[nodiscard]] static bool same_box(const IntervalMap& a,
+                                     const IntervalMap& b);
+};
+
+#endif  // MEGASAMPLER_BOX_REGISTRY_H
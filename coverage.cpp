@@ -0,0 +1,814 @@
+#include "coverage.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+
+/* Parses a decimal integer, saturating at the int64 limits like to_integer */
+static inline int64_t parse_int64(const std::string& s, size_t begin,
+                                  size_t end) {
+  return std::strtoll(s.substr(begin, end - begin).c_str(), nullptr, 10);
+}
+
+/* Parses a value of a Bool, Int or bit-vector, which samples write in hex */
+static inline int64_t parse_value(const std::string& s, size_t begin,
+                                  size_t end, bool bv) {
+  if (!bv) return parse_int64(s, begin, end);
+  return (int64_t)std::strtoull(s.substr(begin, end - begin).c_str(), nullptr,
+                                16);
+}
+
+/* Parses n or n/d, returns false if it doesn't fit in a Rational */
+static bool parse_rational(const std::string& s, size_t begin, size_t end,
+                           Rational& value) {
+  const size_t slash = s.find('/', begin);
+  const bool fraction = slash < end;
+  errno = 0;
+  const int64_t num = parse_int64(s, begin, fraction ? slash : end);
+  const int64_t den = fraction ? parse_int64(s, slash + 1, end) : 1;
+  if (errno == ERANGE || den == 0) return false;
+  try {
+    value = Rational((int128_t)num, (int128_t)den);
+  } catch (const RationalOverflow&) {
+    return false;
+  }
+  return true;
+}
+
+static inline int64_t wrap_add(int64_t a, int64_t b) {
+  return (int64_t)((uint64_t)a + (uint64_t)b);
+}
+
+static inline int64_t wrap_mul(int64_t a, int64_t b) {
+  return (int64_t)((uint64_t)a * (uint64_t)b);
+}
+
+/* SMT-LIB integer division: the remainder is always non-negative */
+static inline bool euclidean_div(int64_t a, int64_t b, int64_t& q,
+                                 int64_t& r) {
+  if (b == 0 || (a == INT64_MIN && b == -1)) return false;
+  q = a / b;
+  r = a % b;
+  if (r < 0) {
+    if (b > 0) {
+      q--;
+      r += b;
+    } else {
+      q++;
+      r -= b;
+    }
+  }
+  return true;
+}
+
+static inline uint64_t bv_mask(unsigned int width) {
+  return width >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << width) - 1;
+}
+
+static inline bool bv_negative(uint64_t v, unsigned int width) {
+  return (v >> (width - 1)) & 1;
+}
+
+static inline int64_t bv_signed(uint64_t v, unsigned int width) {
+  return (int64_t)(bv_negative(v, width) ? v | ~bv_mask(width) : v);
+}
+
+/* bvudiv and bvurem, which SMT-LIB defines for a zero divisor too */
+static inline uint64_t bv_udiv(uint64_t a, uint64_t b, unsigned int width) {
+  return b == 0 ? bv_mask(width) : a / b;
+}
+
+static inline uint64_t bv_urem(uint64_t a, uint64_t b) {
+  return b == 0 ? a : a % b;
+}
+
+WireCoverage::WireCoverage(const z3::expr& formula) { compile(formula); }
+
+void WireCoverage::compile(const z3::expr& formula) {
+  std::unordered_map<unsigned int, unsigned int> node_index;
+  std::vector<std::pair<z3::expr, bool>> stack;
+  stack.emplace_back(formula, false);
+  while (!stack.empty()) {
+    const z3::expr e = stack.back().first;
+    const bool children_done = stack.back().second;
+    stack.pop_back();
+    if (node_index.count(e.id())) continue;
+    if (!children_done) {
+      stack.emplace_back(e, true);
+      for (unsigned int i = 0; i < e.num_args(); i++) {
+        stack.emplace_back(e.arg(i), false);
+      }
+      continue;
+    }
+
+    Node n;
+    n.op = e.decl().decl_kind();
+    if (e.is_bool()) {
+      n.sort = SORT_BOOL;
+    } else if (e.is_int()) {
+      n.sort = SORT_INT;
+    } else if (e.is_real()) {
+      n.sort = SORT_REAL;
+    } else if (e.is_bv() && e.get_sort().bv_size() <= 64) {
+      n.sort = SORT_BV;
+      n.width = e.get_sort().bv_size();
+    } else if (e.is_array()) {
+      n.sort = SORT_ARRAY;
+    } else {
+      n.sort = SORT_OTHER;
+    }
+    for (unsigned int i = 0; i < e.num_args(); i++) {
+      n.args.push_back(node_index.at(e.arg(i).id()));
+    }
+    uint64_t bits;
+    if (n.sort == SORT_BV && e.is_numeral() && e.is_numeral_u64(bits)) {
+      n.numeral = (int64_t)bits;
+    } else if (n.sort == SORT_REAL && e.is_numeral()) {
+      if (!numeral_to_rational(e, n.real_numeral)) n.sort = SORT_OTHER;
+    } else if (e.is_numeral() && !e.is_numeral_i64(n.numeral)) {
+      n.sort = SORT_OTHER;  // doesn't fit in 64 bits, not evaluated
+    }
+    if (n.op == Z3_OP_EXTRACT) {
+      n.low = Z3_get_decl_int_parameter(e.ctx(), e.decl(), 1);
+    }
+    bool function = !e.is_const() && n.op == Z3_OP_UNINTERPRETED &&
+                    is_function_sort(n.sort);
+    for (const auto arg : n.args) {
+      function = function && is_function_sort(nodes[arg].sort);
+    }
+    if ((e.is_const() && n.op == Z3_OP_UNINTERPRETED) || function) {
+      const std::string name = e.decl().name().str();
+      const auto res = var_index.emplace(name, var_names.size());
+      if (res.second) {
+        var_names.push_back(name);
+        var_sorts.push_back(n.sort);
+        var_arg_sorts.emplace_back();
+        for (const auto arg : n.args) {
+          var_arg_sorts.back().push_back(nodes[arg].sort);
+        }
+      }
+      n.var = res.first->second;
+    }
+    if (n.sort != SORT_OTHER && !is_evaluable(n)) n.sort = SORT_OTHER;
+    if (n.sort == SORT_BOOL) total += 1;
+    if (n.sort == SORT_INT) total += 64;
+    if (n.sort == SORT_BV) total += n.width;
+    node_index[e.id()] = nodes.size();
+    nodes.push_back(std::move(n));
+  }
+
+  seen_one.assign(nodes.size(), 0);
+  seen_zero.assign(nodes.size(), 0);
+  values.assign(nodes.size(), 0);
+  reals.resize(nodes.size());
+  valid.assign(nodes.size(), false);
+  reached.assign(nodes.size(), false);
+  arrays.resize(nodes.size());
+  var_values.assign(var_names.size(), 0);
+  var_reals.resize(var_names.size());
+  var_assigned.assign(var_names.size(), false);
+  var_fits.assign(var_names.size(), true);
+  var_arrays.resize(var_names.size());
+  var_functions.resize(var_names.size());
+}
+
+/* the sorts of the arguments and values of the functions evaluated */
+bool WireCoverage::is_function_sort(node_sort sort) {
+  return sort == SORT_BOOL || sort == SORT_INT || sort == SORT_BV;
+}
+
+/* whether evaluate_node can ever give n a value: the cases it handles */
+bool WireCoverage::is_evaluable(const Node& n) const {
+  bool real = n.sort == SORT_REAL;
+  for (const auto arg : n.args) {
+    if (nodes[arg].sort == SORT_OTHER) return false;
+    real = real || nodes[arg].sort == SORT_REAL;
+  }
+  if (real) return is_real_evaluable(n);
+  switch (n.op) {
+    case Z3_OP_UNINTERPRETED:
+      return n.var >= 0;
+    case Z3_OP_EQ:
+    case Z3_OP_DISTINCT:
+      return nodes[n.args[0]].sort != SORT_ARRAY;
+    case Z3_OP_TRUE:
+    case Z3_OP_FALSE:
+    case Z3_OP_ANUM:
+    case Z3_OP_AND:
+    case Z3_OP_OR:
+    case Z3_OP_NOT:
+    case Z3_OP_IMPLIES:
+    case Z3_OP_XOR:
+    case Z3_OP_IFF:
+    case Z3_OP_LE:
+    case Z3_OP_LT:
+    case Z3_OP_GE:
+    case Z3_OP_GT:
+    case Z3_OP_ITE:
+    case Z3_OP_ADD:
+    case Z3_OP_SUB:
+    case Z3_OP_UMINUS:
+    case Z3_OP_MUL:
+    case Z3_OP_IDIV:
+    case Z3_OP_MOD:
+    case Z3_OP_REM:
+    case Z3_OP_SELECT:
+    case Z3_OP_STORE:
+    case Z3_OP_CONST_ARRAY:
+    case Z3_OP_BNUM:
+    case Z3_OP_BADD:
+    case Z3_OP_BSUB:
+    case Z3_OP_BNEG:
+    case Z3_OP_BMUL:
+    case Z3_OP_BUDIV:
+    case Z3_OP_BUREM:
+    case Z3_OP_BSDIV:
+    case Z3_OP_BSREM:
+    case Z3_OP_BSMOD:
+    case Z3_OP_BAND:
+    case Z3_OP_BOR:
+    case Z3_OP_BXOR:
+    case Z3_OP_BNOT:
+    case Z3_OP_BSHL:
+    case Z3_OP_BLSHR:
+    case Z3_OP_BASHR:
+    case Z3_OP_ULEQ:
+    case Z3_OP_ULT:
+    case Z3_OP_UGEQ:
+    case Z3_OP_UGT:
+    case Z3_OP_SLEQ:
+    case Z3_OP_SLT:
+    case Z3_OP_SGEQ:
+    case Z3_OP_SGT:
+    case Z3_OP_CONCAT:
+    case Z3_OP_EXTRACT:
+    case Z3_OP_ZERO_EXT:
+    case Z3_OP_SIGN_EXT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/* the cases of evaluate_real_node */
+bool WireCoverage::is_real_evaluable(const Node& n) const {
+  switch (n.op) {
+    case Z3_OP_UNINTERPRETED:
+      return n.var >= 0;
+    case Z3_OP_ANUM:
+    case Z3_OP_ADD:
+    case Z3_OP_SUB:
+    case Z3_OP_UMINUS:
+    case Z3_OP_MUL:
+    case Z3_OP_DIV:
+    case Z3_OP_ITE:
+    case Z3_OP_TO_REAL:
+    case Z3_OP_TO_INT:
+    case Z3_OP_IS_INT:
+    case Z3_OP_LE:
+    case Z3_OP_LT:
+    case Z3_OP_GE:
+    case Z3_OP_GT:
+    case Z3_OP_EQ:
+    case Z3_OP_DISTINCT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+double WireCoverage::get_ratio() const {
+  if (total == 0) return 0.0;
+  return (double)covered / total;
+}
+
+/*
+ * Sample format: "x:3;b:1;v:ff;r:-1/3;a:[2,0,1->5,3->7,];f:(1;0;2:4,);",
+ * bit-vectors in hex. Variables missing from the sample get the
+ * model-completion value (0, false, constant 0 array or function).
+ */
+void WireCoverage::parse_sample(const std::string& sample) {
+  var_assigned.assign(var_names.size(), false);
+  var_fits.assign(var_names.size(), true);
+  size_t pos = 0;
+  while (pos < sample.size()) {
+    const size_t colon = sample.find(':', pos);
+    if (colon == std::string::npos) break;
+    const auto it = var_index.find(sample.substr(pos, colon - pos));
+    const int var = (it == var_index.end()) ? -1 : it->second;
+    size_t end;
+    if (colon + 1 < sample.size() && sample[colon + 1] == '[') {
+      end = sample.find("];", colon);
+      if (end == std::string::npos) break;
+      if (var >= 0) {
+        ArrayValue& array = var_arrays[var];
+        array.entries.clear();
+        // skip the number of entries, then read the default value
+        size_t item = sample.find(',', colon) + 1;
+        size_t item_end = sample.find(',', item);
+        array.default_value = parse_int64(sample, item, item_end);
+        item = item_end + 1;
+        while (item < end) {
+          item_end = sample.find(',', item);
+          const size_t arrow = sample.find("->", item);
+          if (item_end == std::string::npos || item_end > end ||
+              arrow == std::string::npos || arrow > item_end)
+            break;
+          array.entries[parse_int64(sample, item, arrow)] =
+              parse_int64(sample, arrow + 2, item_end);
+          item = item_end + 1;
+        }
+        var_assigned[var] = true;
+      }
+      end += 1;
+    } else if (colon + 1 < sample.size() && sample[colon + 1] == '(') {
+      end = sample.find(");", colon);
+      if (end == std::string::npos) break;
+      if (var >= 0 && !var_arg_sorts[var].empty()) {
+        parse_function(sample, colon + 2, end, var);
+        var_assigned[var] = true;
+      }
+      end += 1;
+    } else {
+      end = sample.find(';', colon);
+      if (end == std::string::npos) end = sample.size();
+      if (var >= 0 && var_sorts[var] == SORT_REAL) {
+        var_fits[var] = parse_rational(sample, colon + 1, end, var_reals[var]);
+        var_assigned[var] = true;
+      } else if (var >= 0) {
+        var_values[var] =
+            parse_value(sample, colon + 1, end, var_sorts[var] == SORT_BV);
+        var_assigned[var] = true;
+      }
+    }
+    pos = end + 1;
+  }
+}
+
+/*
+ * Table format, between the parentheses: "2;0;1:5:7,3:4:9,", the number of
+ * entries, the default value, then the arguments and value of each entry.
+ */
+void WireCoverage::parse_function(const std::string& sample, size_t begin,
+                                  size_t end, int var) {
+  FunctionValue& function = var_functions[var];
+  const std::vector<node_sort>& arg_sorts = var_arg_sorts[var];
+  function.entries.clear();
+  // skip the number of entries, then read the default value
+  size_t item = sample.find(';', begin) + 1;
+  size_t item_end = sample.find(';', item);
+  if (item_end == std::string::npos || item_end > end) return;
+  function.default_value =
+      parse_value(sample, item, item_end, var_sorts[var] == SORT_BV);
+  item = item_end + 1;
+  std::vector<int64_t> args(arg_sorts.size());
+  while (item < end) {
+    for (unsigned int k = 0; k < args.size(); k++) {
+      item_end = sample.find(':', item);
+      if (item_end == std::string::npos || item_end > end) return;
+      args[k] = parse_value(sample, item, item_end, arg_sorts[k] == SORT_BV);
+      item = item_end + 1;
+    }
+    item_end = sample.find(',', item);
+    if (item_end == std::string::npos || item_end > end) return;
+    function.entries[args] =
+        parse_value(sample, item, item_end, var_sorts[var] == SORT_BV);
+    item = item_end + 1;
+  }
+}
+
+bool WireCoverage::evaluate_node(unsigned int i) {
+  const Node& n = nodes[i];
+  if (n.sort == SORT_OTHER) return false;
+  const auto& a = n.args;
+  for (const auto arg : a) {
+    if (!valid[arg]) return false;
+  }
+  if (n.sort == SORT_REAL || (!a.empty() && nodes[a[0]].sort == SORT_REAL)) {
+    return evaluate_real_node(i);
+  }
+  int64_t& v = values[i];
+  switch (n.op) {
+    case Z3_OP_TRUE:
+      v = 1;
+      return true;
+    case Z3_OP_FALSE:
+      v = 0;
+      return true;
+    case Z3_OP_ANUM:
+      v = n.numeral;
+      return n.sort == SORT_INT;
+    case Z3_OP_UNINTERPRETED:
+      if (n.var < 0) return false;
+      if (!a.empty()) {
+        // missing from the sample, the function is the constant 0
+        if (!var_assigned[n.var]) {
+          v = 0;
+          return true;
+        }
+        const FunctionValue& function = var_functions[n.var];
+        key.clear();
+        for (const auto arg : a) key.push_back(values[arg]);
+        const auto it = function.entries.find(key);
+        v = (it == function.entries.end()) ? function.default_value
+                                           : it->second;
+        if (n.sort == SORT_BOOL) v = (v != 0);
+        return true;
+      }
+      if (n.sort == SORT_ARRAY) {
+        if (var_assigned[n.var]) {
+          arrays[i] = var_arrays[n.var];
+        } else {
+          arrays[i] = ArrayValue();
+        }
+      } else {
+        v = var_assigned[n.var] ? var_values[n.var] : 0;
+        if (n.sort == SORT_BOOL) v = (v != 0);
+      }
+      return n.sort != SORT_OTHER;
+    case Z3_OP_AND:
+      v = 1;
+      for (const auto arg : a) v = v && values[arg];
+      return true;
+    case Z3_OP_OR:
+      v = 0;
+      for (const auto arg : a) v = v || values[arg];
+      return true;
+    case Z3_OP_NOT:
+      v = !values[a[0]];
+      return true;
+    case Z3_OP_IMPLIES:
+      v = !values[a[0]] || values[a[1]];
+      return true;
+    case Z3_OP_XOR:
+      v = (values[a[0]] != 0) != (values[a[1]] != 0);
+      return true;
+    case Z3_OP_IFF:
+    case Z3_OP_EQ:
+      if (nodes[a[0]].sort == SORT_ARRAY) return false;
+      v = values[a[0]] == values[a[1]];
+      return true;
+    case Z3_OP_DISTINCT:
+      if (nodes[a[0]].sort == SORT_ARRAY) return false;
+      v = 1;
+      for (unsigned int j = 0; j < a.size() && v; j++) {
+        for (unsigned int k = j + 1; k < a.size(); k++) {
+          if (values[a[j]] == values[a[k]]) {
+            v = 0;
+            break;
+          }
+        }
+      }
+      return true;
+    case Z3_OP_LE:
+      v = values[a[0]] <= values[a[1]];
+      return true;
+    case Z3_OP_LT:
+      v = values[a[0]] < values[a[1]];
+      return true;
+    case Z3_OP_GE:
+      v = values[a[0]] >= values[a[1]];
+      return true;
+    case Z3_OP_GT:
+      v = values[a[0]] > values[a[1]];
+      return true;
+    case Z3_OP_ITE:
+      if (n.sort == SORT_ARRAY) {
+        arrays[i] = arrays[values[a[0]] ? a[1] : a[2]];
+      } else {
+        v = values[a[0]] ? values[a[1]] : values[a[2]];
+      }
+      return true;
+    case Z3_OP_ADD:
+      v = 0;
+      for (const auto arg : a) v = wrap_add(v, values[arg]);
+      return true;
+    case Z3_OP_SUB:
+      v = values[a[0]];
+      for (unsigned int j = 1; j < a.size(); j++) {
+        v = wrap_add(v, wrap_mul(-1, values[a[j]]));
+      }
+      return true;
+    case Z3_OP_UMINUS:
+      v = wrap_mul(-1, values[a[0]]);
+      return true;
+    case Z3_OP_MUL:
+      v = 1;
+      for (const auto arg : a) v = wrap_mul(v, values[arg]);
+      return true;
+    case Z3_OP_IDIV:
+    case Z3_OP_MOD: {
+      int64_t q, r;
+      if (!euclidean_div(values[a[0]], values[a[1]], q, r)) return false;
+      v = (n.op == Z3_OP_IDIV) ? q : r;
+      return true;
+    }
+    case Z3_OP_REM: {
+      int64_t q, r;
+      if (!euclidean_div(values[a[0]], values[a[1]], q, r)) return false;
+      v = (values[a[1]] < 0) ? -r : r;
+      return true;
+    }
+    case Z3_OP_SELECT: {
+      const ArrayValue& array = arrays[a[0]];
+      const auto it = array.entries.find(values[a[1]]);
+      v = (it == array.entries.end()) ? array.default_value : it->second;
+      return true;
+    }
+    case Z3_OP_STORE:
+      arrays[i] = arrays[a[0]];
+      arrays[i].entries[values[a[1]]] = values[a[2]];
+      return true;
+    case Z3_OP_CONST_ARRAY:
+      arrays[i] = ArrayValue();
+      arrays[i].default_value = values[a[0]];
+      return true;
+    default:
+      return evaluate_bv_node(i);
+  }
+}
+
+/*
+ * Bit-vector operators: values hold the bits zero-extended to 64, and the
+ * results wrap around at the width
+ */
+bool WireCoverage::evaluate_bv_node(unsigned int i) {
+  const Node& n = nodes[i];
+  const auto& a = n.args;
+  const unsigned int w = n.op == Z3_OP_BNUM || a.empty() ? n.width
+                                                          : nodes[a[0]].width;
+  const uint64_t mask = bv_mask(n.width);
+  const auto arg = [this, &a](unsigned int j) { return (uint64_t)values[a[j]]; };
+  uint64_t r;
+  switch (n.op) {
+    case Z3_OP_BNUM:
+      r = n.numeral;
+      break;
+    case Z3_OP_BADD:
+      r = 0;
+      for (unsigned int j = 0; j < a.size(); j++) r += arg(j);
+      break;
+    case Z3_OP_BSUB:
+      r = arg(0);
+      for (unsigned int j = 1; j < a.size(); j++) r -= arg(j);
+      break;
+    case Z3_OP_BNEG:
+      r = -arg(0);
+      break;
+    case Z3_OP_BMUL:
+      r = 1;
+      for (unsigned int j = 0; j < a.size(); j++) r *= arg(j);
+      break;
+    case Z3_OP_BUDIV:
+      r = bv_udiv(arg(0), arg(1), w);
+      break;
+    case Z3_OP_BUREM:
+      r = bv_urem(arg(0), arg(1));
+      break;
+    case Z3_OP_BSDIV:
+    case Z3_OP_BSREM:
+    case Z3_OP_BSMOD: {
+      // on the magnitudes, with the signs put back as SMT-LIB defines them
+      const bool s_negative = bv_negative(arg(0), w);
+      const bool t_negative = bv_negative(arg(1), w);
+      const uint64_t s = (s_negative ? -arg(0) : arg(0)) & mask;
+      const uint64_t t = (t_negative ? -arg(1) : arg(1)) & mask;
+      if (n.op == Z3_OP_BSDIV) {
+        r = bv_udiv(s, t, w);
+        if (s_negative != t_negative) r = -r;
+      } else if (n.op == Z3_OP_BSREM) {
+        r = bv_urem(s, t);
+        if (s_negative) r = -r;
+      } else {
+        const uint64_t u = bv_urem(s, t);
+        if (u == 0 || (!s_negative && !t_negative)) {
+          r = u;
+        } else if (s_negative && !t_negative) {
+          r = -u + arg(1);
+        } else if (!s_negative && t_negative) {
+          r = u + arg(1);
+        } else {
+          r = -u;
+        }
+      }
+      break;
+    }
+    case Z3_OP_BAND:
+      r = mask;
+      for (unsigned int j = 0; j < a.size(); j++) r &= arg(j);
+      break;
+    case Z3_OP_BOR:
+      r = 0;
+      for (unsigned int j = 0; j < a.size(); j++) r |= arg(j);
+      break;
+    case Z3_OP_BXOR:
+      r = 0;
+      for (unsigned int j = 0; j < a.size(); j++) r ^= arg(j);
+      break;
+    case Z3_OP_BNOT:
+      r = ~arg(0);
+      break;
+    case Z3_OP_BSHL:
+      r = arg(1) >= w ? 0 : arg(0) << arg(1);
+      break;
+    case Z3_OP_BLSHR:
+      r = arg(1) >= w ? 0 : arg(0) >> arg(1);
+      break;
+    case Z3_OP_BASHR:
+      r = (uint64_t)(bv_signed(arg(0), w) >> std::min<uint64_t>(arg(1), 63));
+      break;
+    case Z3_OP_ULEQ:
+      r = arg(0) <= arg(1);
+      break;
+    case Z3_OP_ULT:
+      r = arg(0) < arg(1);
+      break;
+    case Z3_OP_UGEQ:
+      r = arg(0) >= arg(1);
+      break;
+    case Z3_OP_UGT:
+      r = arg(0) > arg(1);
+      break;
+    case Z3_OP_SLEQ:
+      r = bv_signed(arg(0), w) <= bv_signed(arg(1), w);
+      break;
+    case Z3_OP_SLT:
+      r = bv_signed(arg(0), w) < bv_signed(arg(1), w);
+      break;
+    case Z3_OP_SGEQ:
+      r = bv_signed(arg(0), w) >= bv_signed(arg(1), w);
+      break;
+    case Z3_OP_SGT:
+      r = bv_signed(arg(0), w) > bv_signed(arg(1), w);
+      break;
+    case Z3_OP_CONCAT:
+      r = 0;
+      for (unsigned int j = 0; j < a.size(); j++) {
+        // a shift by 64 is undefined: only the first argument can be that wide
+        r = (nodes[a[j]].width >= 64 ? 0 : r << nodes[a[j]].width) | arg(j);
+      }
+      break;
+    case Z3_OP_EXTRACT:
+      r = arg(0) >> n.low;
+      break;
+    case Z3_OP_ZERO_EXT:
+      r = arg(0);
+      break;
+    case Z3_OP_SIGN_EXT:
+      r = (uint64_t)bv_signed(arg(0), w);
+      break;
+    default:
+      return false;
+  }
+  // comparisons are Bool wires, with one bit
+  values[i] = (int64_t)(n.sort == SORT_BOOL ? r : r & mask);
+  return true;
+}
+
+/*
+ * Real operators, and the Int and Bool ones over Reals: false when a value
+ * doesn't fit in a Rational, or on a division by zero, which z3 leaves to
+ * the model
+ */
+bool WireCoverage::evaluate_real_node(unsigned int i) {
+  const Node& n = nodes[i];
+  const auto& a = n.args;
+  Rational& r = reals[i];
+  int64_t& v = values[i];
+  try {
+    switch (n.op) {
+      case Z3_OP_ANUM:
+        r = n.real_numeral;
+        return true;
+      case Z3_OP_UNINTERPRETED:
+        r = var_assigned[n.var] ? var_reals[n.var] : Rational();
+        return var_fits[n.var];
+      case Z3_OP_ADD:
+        r = Rational();
+        for (const auto arg : a) r = r + reals[arg];
+        return true;
+      case Z3_OP_SUB:
+        r = reals[a[0]];
+        for (unsigned int j = 1; j < a.size(); j++) r = r - reals[a[j]];
+        return true;
+      case Z3_OP_UMINUS:
+        r = -reals[a[0]];
+        return true;
+      case Z3_OP_MUL:
+        r = Rational(1);
+        for (const auto arg : a) r = r * reals[arg];
+        return true;
+      case Z3_OP_DIV:
+        if (reals[a[1]] == Rational()) return false;
+        r = reals[a[0]] / reals[a[1]];
+        return true;
+      case Z3_OP_ITE:
+        r = reals[values[a[0]] ? a[1] : a[2]];
+        return true;
+      case Z3_OP_TO_REAL:
+        r = Rational(values[a[0]]);
+        return true;
+      case Z3_OP_TO_INT: {
+        const int128_t floor = reals[a[0]].floor();
+        v = (int64_t)floor;
+        return floor >= INT64_MIN && floor <= INT64_MAX;
+      }
+      case Z3_OP_IS_INT:
+        v = reals[a[0]].is_integer();
+        return true;
+      case Z3_OP_LE:
+        v = reals[a[0]] <= reals[a[1]];
+        return true;
+      case Z3_OP_LT:
+        v = reals[a[0]] < reals[a[1]];
+        return true;
+      case Z3_OP_GE:
+        v = reals[a[0]] >= reals[a[1]];
+        return true;
+      case Z3_OP_GT:
+        v = reals[a[0]] > reals[a[1]];
+        return true;
+      case Z3_OP_EQ:
+        v = reals[a[0]] == reals[a[1]];
+        return true;
+      case Z3_OP_DISTINCT:
+        v = 1;
+        for (unsigned int j = 0; j < a.size() && v; j++) {
+          for (unsigned int k = j + 1; k < a.size(); k++) {
+            if (reals[a[j]] == reals[a[k]]) {
+              v = 0;
+              break;
+            }
+          }
+        }
+        return true;
+      default:
+        return false;
+    }
+  } catch (const RationalOverflow&) {
+    return false;
+  }
+}
+
+void WireCoverage::evaluate() {
+  for (unsigned int i = 0; i < nodes.size(); i++) {
+    valid[i] = evaluate_node(i);
+  }
+}
+
+/*
+ * The root is reached, and a node reaches its arguments but those that and,
+ * or and ite skip. Parents come after their arguments, so this goes backward.
+ */
+void WireCoverage::mark_reached() {
+  reached.assign(nodes.size(), false);
+  if (nodes.empty()) return;
+  reached.back() = true;
+  for (unsigned int i = nodes.size(); i-- > 0;) {
+    if (!reached[i]) continue;
+    const Node& n = nodes[i];
+    const auto& a = n.args;
+    if (valid[i] && (n.op == Z3_OP_AND || n.op == Z3_OP_OR)) {
+      const bool stop = n.op == Z3_OP_OR;
+      for (const auto arg : a) {
+        reached[arg] = true;
+        if ((values[arg] != 0) == stop) break;
+      }
+    } else if (valid[i] && n.op == Z3_OP_ITE) {
+      reached[a[0]] = true;
+      reached[values[a[0]] ? a[1] : a[2]] = true;
+    } else {
+      for (const auto arg : a) reached[arg] = true;
+    }
+  }
+}
+
+bool WireCoverage::add_sample(const std::string& sample) {
+  num_samples++;
+  parse_sample(sample);
+  evaluate();
+  mark_reached();
+  const uint64_t old_covered = covered;
+  for (unsigned int i = 0; i < nodes.size(); i++) {
+    if (!valid[i] || !reached[i]) continue;
+    const uint64_t old_bits = seen_one[i] & seen_zero[i];
+    if (nodes[i].sort == SORT_BOOL) {
+      if (values[i]) {
+        seen_one[i] = 1;
+      } else {
+        seen_zero[i] = 1;
+      }
+    } else if (nodes[i].sort == SORT_INT) {
+      seen_one[i] |= (uint64_t)values[i];
+      seen_zero[i] |= ~(uint64_t)values[i];
+    } else if (nodes[i].sort == SORT_BV) {
+      seen_one[i] |= (uint64_t)values[i];
+      seen_zero[i] |= ~(uint64_t)values[i] & bv_mask(nodes[i].width);
+    } else {
+      continue;
+    }
+    const uint64_t new_bits = seen_one[i] & seen_zero[i];
+    covered += __builtin_popcountll(new_bits) - __builtin_popcountll(old_bits);
+  }
+  return covered > old_covered;
+}
@@ -0,0 +1,115 @@
+#ifndef MEGASAMPLER_COVERAGE_H
+#define MEGASAMPLER_COVERAGE_H
+
+#include <z3++.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "real_interval.h"
+
+/*
+ * Online version of WireCoverageStatistics (scripts/calc_metric.py).
+ * Every Bool, Int and bit-vector node ("wire") of the formula keeps a mask of
+ * the bits it was seen taking as 1 and a mask of the bits it was seen taking
+ * as 0. A bit is covered once it was seen both ways. Bool wires have one bit,
+ * Int wires 64 bits (two's complement), bit-vector wires their width (up to
+ * 64). Real and array wires are not counted, but are evaluated for the wires
+ * above them, Reals as int64 fractions. Nor are wires that can't be evaluated
+ * (an unsupported operator or sort, or one below them), which would never be
+ * covered.
+ * Applications of uninterpreted functions over Bool, Int and bit-vectors are
+ * wires too, evaluated through the tables of the sample.
+ * Like calc_metric, a sample only counts for the wires that its evaluation
+ * reaches: and and or stop at their first false and true argument, and ite
+ * only evaluates the branch that it takes.
+ */
+class WireCoverage {
+ public:
+  explicit WireCoverage(const z3::expr& formula);
+
+  /*
+   * Evaluates the formula on a sample, given in the format written to the
+   * samples file, and accumulates the wire masks.
+   * Returns true iff the number of covered wires grew.
+   */
+  bool add_sample(const std::string& sample);
+
+  [[nodiscard]] uint64_t get_covered() const { return covered; }
+  [[nodiscard]] uint64_t get_total() const { return total; }
+  [[nodiscard]] double get_ratio() const;
+  [[nodiscard]] unsigned long get_num_samples() const { return num_samples; }
+
+ private:
+  enum node_sort {
+    SORT_BOOL,
+    SORT_INT,
+    SORT_BV,
+    SORT_REAL,
+    SORT_ARRAY,
+    SORT_OTHER
+  };
+  struct ArrayValue {
+    std::map<int64_t, int64_t> entries;
+    int64_t default_value = 0;
+  };
+  struct FunctionValue {
+    std::map<std::vector<int64_t>, int64_t> entries;
+    int64_t default_value = 0;
+  };
+  struct Node {
+    Z3_decl_kind op;
+    node_sort sort;
+    std::vector<unsigned int> args;
+    int64_t numeral = 0;
+    Rational real_numeral;
+    int var = -1;  // index into var_names for uninterpreted constants and
+                   // functions
+    unsigned int width = 0;  // of bit-vectors, whose values are zero-extended
+    unsigned int low = 0;    // lowest bit of an extract
+  };
+
+  std::vector<Node> nodes;  // post-order: arguments come before their parent
+  std::vector<std::string> var_names;
+  std::vector<node_sort> var_sorts;  // of the range, for functions
+  std::vector<std::vector<node_sort>> var_arg_sorts;  // empty for constants
+  std::unordered_map<std::string, int> var_index;
+
+  std::vector<uint64_t> seen_one;
+  std::vector<uint64_t> seen_zero;
+  uint64_t covered = 0;
+  uint64_t total = 0;
+  unsigned long num_samples = 0;
+
+  // scratch space, reused between samples
+  std::vector<int64_t> var_values;
+  std::vector<Rational> var_reals;
+  std::vector<bool> var_assigned;
+  std::vector<bool> var_fits;  // false for Reals too large for a Rational
+  std::vector<ArrayValue> var_arrays;
+  std::vector<FunctionValue> var_functions;
+  std::vector<int64_t> key;
+  std::vector<int64_t> values;
+  std::vector<Rational> reals;
+  std::vector<bool> valid;
+  std::vector<bool> reached;
+  std::vector<ArrayValue> arrays;
+
+  void compile(const z3::expr& formula);
+  [[nodiscard]] bool is_evaluable(const Node& n) const;
+  [[nodiscard]] bool is_real_evaluable(const Node& n) const;
+  [[nodiscard]] static bool is_function_sort(node_sort sort);
+  void parse_sample(const std::string& sample);
+  void parse_function(const std::string& sample, size_t begin, size_t end,
+                      int var);
+  void evaluate();
+  bool evaluate_node(unsigned int i);
+  bool evaluate_bv_node(unsigned int i);
+  bool evaluate_real_node(unsigned int i);
+  void mark_reached();
+};
+
+#endif  // MEGASAMPLER_COVERAGE_H
@@ -0,0 +1,115 @@
+#include "disjunct_policy.h"
+
+#include <algorithm>
+#include <cmath>
+
+std::unique_ptr<DisjunctPolicy> DisjunctPolicy::create(
+    const MeGA::SamplerConfig& config) {
+  if (config.disjunct_policy == MeGA::DISJUNCT_POLICY_UCB)
+    return std::make_unique<UcbDisjunctPolicy>(config);
+  return std::make_unique<UniformDisjunctPolicy>(config);
+}
+
+Json::Value DisjunctPolicy::to_json() const {
+  Json::Value res;
+  res["policy"] = name();
+  return res;
+}
+
+unsigned int UniformDisjunctPolicy::choose(
+    __attribute__((unused)) const z3::expr& disjunction,
+    const std::vector<unsigned int>& satisfied, std::mt19937& g) {
+  return satisfied[g() % satisfied.size()];
+}
+
+unsigned int UcbDisjunctPolicy::choose(
+    const z3::expr& disjunction, const std::vector<unsigned int>& satisfied,
+    std::mt19937& g) {
+  if (satisfied.size() == 1) return satisfied[0];
+  auto it = disjunctions.find(disjunction.id());
+  if (it == disjunctions.end())
+    it = disjunctions.emplace(disjunction.id(), Disjunction(disjunction)).first;
+  const Disjunction& stats = it->second;
+  std::vector<unsigned int> untried;
+  for (const unsigned int child : satisfied) {
+    if (stats.arms[child].pulls == 0) untried.push_back(child);
+  }
+  unsigned int chosen;
+  if (!untried.empty()) {
+    chosen = untried[g() % untried.size()];
+  } else {
+    const double log_pulls = std::log((double)stats.pulls);
+    double best = -1.0;
+    unsigned int ties = 0;
+    chosen = satisfied[0];
+    for (const unsigned int child : satisfied) {
+      const Arm& arm = stats.arms[child];
+      const double ucb = arm.total_reward / arm.pulls +
+                         std::sqrt(2 * log_pulls / arm.pulls);
+      if (ucb > best) {
+        ties = 1;
+      } else if (ucb < best || g() % ++ties != 0) {
+        continue;
+      }
+      best = ucb;
+      chosen = child;
+    }
+  }
+  pending.emplace_back(disjunction.id(), chosen);
+  return chosen;
+}
+
+void UcbDisjunctPolicy::reward(double log2_volume, uint64_t unique_samples) {
+  const double samples_reward =
+      std::min(1.0, std::log2(1.0 + unique_samples) /
+                        std::log2(1.0 + config.max_epoch_samples));
+  max_log2_volume = std::max(max_log2_volume, log2_volume);
+  const double volume_reward =
+      max_log2_volume > 0.0 ? log2_volume / max_log2_volume : 0.0;
+  const double r = (samples_reward + volume_reward) / 2;
+  for (const auto& choice : pending) {
+    Disjunction& stats = disjunctions.at(choice.first);
+    Arm& arm = stats.arms[choice.second];
+    stats.pulls++;
+    arm.pulls++;
+    arm.total_reward += r;
+    arm.total_log2_volume += log2_volume;
+    arm.total_unique_samples += unique_samples;
+  }
+  pending.clear();
+}
+
+Json::Value UcbDisjunctPolicy::to_json() const {
+  Json::Value res = DisjunctPolicy::to_json();
+  std::vector<const Disjunction*> reported;
+  for (const auto& entry : disjunctions) {
+    if (entry.second.pulls > 0) reported.push_back(&entry.second);
+  }
+  res["learned disjunctions"] = (Json::UInt64)reported.size();
+  const size_t n = std::min<size_t>(MAX_REPORTED, reported.size());
+  std::partial_sort(reported.begin(), reported.begin() + n, reported.end(),
+                    [](const Disjunction* a, const Disjunction* b) {
+                      return a->pulls > b->pulls;
+                    });
+  Json::Value preferences(Json::arrayValue);
+  for (size_t i = 0; i < n; i++) {
+    const Disjunction& stats = *reported[i];
+    Json::Value disjunction;
+    disjunction["pulls"] = (Json::UInt64)stats.pulls;
+    for (unsigned int child = 0; child < stats.arms.size(); child++) {
+      const Arm& arm = stats.arms[child];
+      if (arm.pulls == 0) continue;
+      Json::Value choice;
+      choice["disjunct"] = stats.node.arg(child).to_string();
+      choice["pulls"] = (Json::UInt64)arm.pulls;
+      choice["average reward"] = arm.total_reward / arm.pulls;
+      choice["average log2 volume"] = arm.total_log2_volume / arm.pulls;
+      choice["average unique samples"] =
+          (double)arm.total_unique_samples / arm.pulls;
+      disjunction["disjuncts"].append(choice);
+    }
+    preferences.append(disjunction);
+  }
+  res["preferences"] = preferences;
+  return res;
+}
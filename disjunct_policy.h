@@ -0,0 +1,105 @@
+#ifndef MEGASAMPLER_DISJUNCT_POLICY_H
+#define MEGASAMPLER_DISJUNCT_POLICY_H
+
+#include <jsoncpp/json/json.h>
+#include <z3++.h>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "sampler_config.h"
+
+/*
+ * Decides which of the disjuncts the seed satisfies MEGASampler::remove_or
+ * keeps in the implicant. Choices are remembered until the box of the
+ * implicant has been sampled, and are then credited with that box.
+ */
+class DisjunctPolicy {
+ public:
+  explicit DisjunctPolicy(const MeGA::SamplerConfig& config)
+      : config(config) {}
+  virtual ~DisjunctPolicy() {}
+
+  /*
+   * Returns the index of the child of disjunction to keep, one of satisfied
+   * (which is not empty).
+   */
+  virtual unsigned int choose(const z3::expr& disjunction,
+                              const std::vector<unsigned int>& satisfied,
+                              std::mt19937& g) = 0;
+  /*
+   * Credits the choices since the last reward or discard with the box of
+   * their implicant: its log2 volume and the unique samples it gave.
+   */
+  virtual void reward(__attribute__((unused)) double log2_volume,
+                      __attribute__((unused)) uint64_t unique_samples) {}
+  /* forgets the choices since the last reward, whose box wasn't sampled */
+  virtual void discard() {}
+  [[nodiscard]] virtual std::string name() const = 0;
+  [[nodiscard]] virtual Json::Value to_json() const;
+
+  static std::unique_ptr<DisjunctPolicy> create(
+      const MeGA::SamplerConfig& config);
+
+ protected:
+  const MeGA::SamplerConfig& config;
+};
+
+/* The original choice: any satisfied disjunct, uniformly */
+class UniformDisjunctPolicy : public DisjunctPolicy {
+ public:
+  using DisjunctPolicy::DisjunctPolicy;
+  unsigned int choose(const z3::expr& disjunction,
+                      const std::vector<unsigned int>& satisfied,
+                      std::mt19937& g) override;
+  [[nodiscard]] std::string name() const override { return "uniform"; }
+};
+
+/*
+ * UCB1 over the children of every disjunction: a child is worth the average
+ * reward of its boxes plus an exploration bonus that shrinks as it is
+ * chosen. The reward of a box is the mean of log2(1 + unique samples),
+ * scaled to [0, 1] by the most an epoch may sample, and its log2 volume,
+ * scaled to [0, 1] by the largest seen so far, so boxes that both fill
+ * their epoch still differ. Children never chosen go first. Only
+ * disjunctions where the seed satisfied several children learn anything.
+ */
+class UcbDisjunctPolicy : public DisjunctPolicy {
+ public:
+  using DisjunctPolicy::DisjunctPolicy;
+  unsigned int choose(const z3::expr& disjunction,
+                      const std::vector<unsigned int>& satisfied,
+                      std::mt19937& g) override;
+  void reward(double log2_volume, uint64_t unique_samples) override;
+  void discard() override { pending.clear(); }
+  [[nodiscard]] std::string name() const override { return "ucb"; }
+  /* the statistics of the MAX_REPORTED most chosen disjunctions */
+  [[nodiscard]] Json::Value to_json() const override;
+
+ private:
+  static constexpr unsigned int MAX_REPORTED = 100;
+  struct Arm {
+    uint64_t pulls = 0;
+    double total_reward = 0.0;
+    double total_log2_volume = 0.0;
+    uint64_t total_unique_samples = 0;
+  };
+  struct Disjunction {
+    z3::expr node;
+    std::vector<Arm> arms;  // by child index
+    uint64_t pulls = 0;
+    explicit Disjunction(const z3::expr& node)
+        : node(node), arms(node.num_args()) {}
+  };
+  std::unordered_map<unsigned int, Disjunction> disjunctions;  // by expr id
+  double max_log2_volume = 0.0;  // of the boxes rewarded so far
+  // (disjunction id, child) chosen since the last reward
+  std::vector<std::pair<unsigned int, unsigned int>> pending;
+};
+
+#endif  // MEGASAMPLER_DISJUNCT_POLICY_H
@@ -0,0 +1,146 @@
+#include "epoch_scheduler.h"
+
+#include <algorithm>
+
+/* Computes the base-2 logarithm of an unsigned 64-bit integer. */
+static inline uint64_t ilog2(const uint64_t x) {
+  if (0 == x) return 1;  // undefined but useful for me here
+  return (63 - __builtin_clzll(x));
+}
+
+/**
+ * If the multiplication does not overflow,
+ * the result of the product is returned.
+ * If the multiplication overflows,
+ * the function returns a value indicating an integer overflow.
+ * If the result of the multiplication is positive,
+ * INT64_MAX is returned, otherwise INT64_MIN is returned.
+ */
+static inline int64_t safe_mul(const int64_t a, const int64_t b) {
+  int64_t ret;
+  if (!__builtin_mul_overflow(a, b, &ret)) return ret;
+  return ((a > 0) ^ (b > 0)) ? INT64_MIN : INT64_MAX;
+}
+
+std::unique_ptr<EpochScheduler> EpochScheduler::create(
+    const MeGA::SamplerConfig& config) {
+  if (config.epoch_policy == MeGA::EPOCH_POLICY_ADAPTIVE)
+    return std::make_unique<AdaptiveEpochScheduler>(config);
+  return std::make_unique<LegacyEpochScheduler>(config);
+}
+
+void EpochScheduler::start_box(__attribute__((unused))
+                               const IntervalMap& intervalmap,
+                               double _seed_cost) {
+  round = 0;
+  box_samples = 0;
+  box_time = 0.0;
+  last_rate = 1.0;
+  seed_cost = _seed_cost;
+  stop_reason = "";
+  last_decision = Json::Value(Json::objectValue);
+}
+
+void EpochScheduler::end_round(uint64_t new_samples, uint64_t round_samples,
+                               double round_time) {
+  round++;
+  box_samples += new_samples;
+  box_time += round_time;
+  last_rate = (double)new_samples / round_samples;
+}
+
+void EpochScheduler::end_box(int epoch) {
+  if (trace.size() >= MAX_TRACE_SIZE) {
+    dropped_decisions++;
+    return;
+  }
+  Json::Value decision = last_decision;
+  decision["epoch"] = epoch;
+  decision["rounds"] = (Json::UInt64)round;
+  decision["unique samples"] = (Json::UInt64)box_samples;
+  decision["sampling time"] = box_time;
+  decision["seed cost"] = seed_cost;
+  decision["last rate"] = last_rate;
+  decision["reason"] = stop_reason;
+  trace.append(decision);
+}
+
+Json::Value EpochScheduler::to_json() const {
+  Json::Value res;
+  res["policy"] = name();
+  res["decisions"] = trace;
+  res["dropped decisions"] = (Json::UInt64)dropped_decisions;
+  return res;
+}
+
+void LegacyEpochScheduler::start_box(const IntervalMap& intervalmap,
+                                     double _seed_cost) {
+  EpochScheduler::start_box(intervalmap, _seed_cost);
+  uint64_t coeff = 1;
+  for (const auto& imap : intervalmap) {
+    const auto& i = imap.second;
+    if (i.is_low_minf() || i.is_high_inf()) {
+      coeff *= 4;
+      continue;
+    }
+    coeff =
+        safe_mul(coeff, 1 + ilog2(1 + ilog2(1 + i.get_high() - i.get_low())));
+  }
+  if (config.blocking) coeff = coeff + intervalmap.size();
+  max_rounds =
+      std::min(std::max(config.num_rounds, coeff), config.max_samples >> 7UL);
+  last_decision["max rounds"] = (Json::UInt64)max_rounds;
+}
+
+bool LegacyEpochScheduler::continue_box() {
+  if (round >= max_rounds) {
+    stop_reason = "max rounds";
+    return false;
+  }
+  if (last_rate <= config.min_rate) {
+    stop_reason = "min rate";
+    return false;
+  }
+  return true;
+}
+
+void AdaptiveEpochScheduler::start_box(const IntervalMap& intervalmap,
+                                       double _seed_cost) {
+  EpochScheduler::start_box(intervalmap, _seed_cost);
+  box_rate = 0.0;
+}
+
+void AdaptiveEpochScheduler::end_round(uint64_t new_samples,
+                                       uint64_t round_samples,
+                                       double round_time) {
+  EpochScheduler::end_round(new_samples, round_samples, round_time);
+  round_time = std::max(round_time, 1e-9);
+  const double rate = new_samples / round_time;
+  if (round == 1) {
+    boxes++;
+    first_round_yield += (new_samples - first_round_yield) / boxes;
+    first_round_time += (round_time - first_round_time) / boxes;
+    box_rate = rate;
+  } else {
+    box_rate = SMOOTHING * rate + (1 - SMOOTHING) * box_rate;
+  }
+}
+
+double AdaptiveEpochScheduler::switch_rate() const {
+  return first_round_yield / (seed_cost + first_round_time);
+}
+
+bool AdaptiveEpochScheduler::continue_box() {
+  if (round == 0) return true;
+  last_decision["box rate"] = box_rate;
+  last_decision["switch rate"] = switch_rate();
+  if (last_rate == 0.0) {
+    stop_reason = "exhausted";
+    return false;
+  }
+  if (box_rate < switch_rate()) {
+    stop_reason = "new box expected to be better";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,102 @@
+#ifndef MEGASAMPLER_EPOCH_SCHEDULER_H
+#define MEGASAMPLER_EPOCH_SCHEDULER_H
+
+#include <jsoncpp/json/json.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "intervalmap.h"
+#include "sampler_config.h"
+
+/*
+ * Decides, after every sampling round of MEGASampler, whether to keep
+ * sampling the current box or to give up and start a new epoch.
+ * Every decision to abandon a box is recorded in the trace.
+ */
+class EpochScheduler {
+ public:
+  explicit EpochScheduler(const MeGA::SamplerConfig& config)
+      : config(config) {}
+  virtual ~EpochScheduler() {}
+
+  /*
+   * Called before the first round on a new box. seed_cost is the average time
+   * (seconds) spent so far to get a box: seed solving and strengthening.
+   */
+  virtual void start_box(const IntervalMap& intervalmap, double seed_cost);
+  /*
+   * Called after each round with the number of new unique samples, the number
+   * of draws and the time the round took.
+   */
+  virtual void end_round(uint64_t new_samples, uint64_t round_samples,
+                         double round_time);
+  /*
+   * Called before each round. Returns true to sample another round from the
+   * current box, otherwise sets stop_reason.
+   */
+  virtual bool continue_box() = 0;
+  [[nodiscard]] virtual std::string name() const = 0;
+  /*
+   * Records why the box was abandoned (the trace keeps at most
+   * MAX_TRACE_SIZE entries, the rest are only counted).
+   */
+  void end_box(int epoch);
+  std::string stop_reason;
+  [[nodiscard]] Json::Value to_json() const;
+
+  static std::unique_ptr<EpochScheduler> create(
+      const MeGA::SamplerConfig& config);
+
+ protected:
+  const MeGA::SamplerConfig& config;
+  uint64_t round = 0;
+  uint64_t box_samples = 0;
+  double box_time = 0.0;
+  double last_rate = 1.0;  // unique samples per draw in the last round
+  double seed_cost = 0.0;
+  Json::Value last_decision;  // extra fields for the trace entry
+
+ private:
+  static constexpr unsigned int MAX_TRACE_SIZE = 10000;
+  Json::Value trace{Json::arrayValue};
+  uint64_t dropped_decisions = 0;
+};
+
+/* The original heuristic: round budget from the box size and a minimal rate */
+class LegacyEpochScheduler : public EpochScheduler {
+  uint64_t max_rounds = 0;
+
+ public:
+  using EpochScheduler::EpochScheduler;
+  void start_box(const IntervalMap& intervalmap, double seed_cost) override;
+  bool continue_box() override;
+  [[nodiscard]] std::string name() const override { return "legacy"; }
+};
+
+/*
+ * Compares the marginal unique-sample yield of the current box (per second,
+ * smoothed over the last rounds) with the yield expected from paying the
+ * average seed cost for a fresh box, estimated from the first rounds of
+ * previous boxes. Sampling moves on once continuing is worth less.
+ */
+class AdaptiveEpochScheduler : public EpochScheduler {
+  static constexpr double SMOOTHING = 0.5;
+  double box_rate = 0.0;           // smoothed unique samples/sec in this box
+  double first_round_yield = 0.0;  // average unique samples in a first round
+  double first_round_time = 0.0;   // average duration of a first round
+  uint64_t boxes = 0;
+
+ public:
+  using EpochScheduler::EpochScheduler;
+  void start_box(const IntervalMap& intervalmap, double seed_cost) override;
+  void end_round(uint64_t new_samples, uint64_t round_samples,
+                 double round_time) override;
+  bool continue_box() override;
+  [[nodiscard]] std::string name() const override { return "adaptive"; }
+  /* expected unique samples per second of abandoning the box */
+  [[nodiscard]] double switch_rate() const;
+};
+
+#endif  // MEGASAMPLER_EPOCH_SCHEDULER_H
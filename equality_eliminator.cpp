@@ -0,0 +1,106 @@
+#include "equality_eliminator.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "linear.h"
+#include "z3_utils.h"
+
+bool EqualityEliminator::as_definition(const z3::expr& equality, z3::expr& var,
+                                       z3::expr& value) {
+  if (!equality.is_app() || !is_op_eq(get_op(equality)) ||
+      equality.num_args() != 2 || !equality.arg(0).is_int())
+    return false;
+  // sum(c_i * x_i) + constant = 0
+  std::unordered_map<z3::expr, int128_t> terms;
+  int128_t constant = 0;
+  if (!linearize(equality.arg(0), 1, terms, constant) ||
+      !linearize(equality.arg(1), -1, terms, constant))
+    return false;
+  const z3::expr* defined = nullptr;
+  int128_t sign = 0;
+  for (const auto& term : terms) {
+    if (term.second == 1 || term.second == -1) {
+      defined = &term.first;
+      sign = term.second;
+      break;
+    }
+  }
+  if (!defined) return false;
+  // x = -sign * (sum of the other terms + constant)
+  const int128_t offset = -sign * constant;
+  if (offset < INT64_MIN || offset > INT64_MAX) return false;
+  z3::context& c = equality.ctx();
+  z3::expr_vector summands(c);
+  for (const auto& term : terms) {
+    if (term.first.id() == defined->id() || term.second == 0) continue;
+    const int128_t coeff = -sign * term.second;  // |coeff| <= INT64_MAX
+    summands.push_back(coeff == 1 ? term.first
+                                  : c.int_val((int64_t)coeff) * term.first);
+  }
+  if (offset != 0 || summands.empty())
+    summands.push_back(c.int_val((int64_t)offset));
+  var = *defined;
+  value = z3::sum(summands);
+  return true;
+}
+
+z3::expr EqualityEliminator::eliminate(const z3::expr& formula,
+                                       const z3::params& simplify) {
+  z3::context& c = formula.ctx();
+  z3::expr reduced = formula;
+  for (unsigned int round = 0; round < MAX_ROUNDS; round++) {
+    // definitions that don't mention each other's variables are substituted
+    // together
+    z3::expr_vector from(c), to(c);
+    std::unordered_set<unsigned int> defined, used;
+    std::vector<z3::expr> conjuncts{reduced};
+    while (!conjuncts.empty()) {
+      const z3::expr e = conjuncts.back();
+      conjuncts.pop_back();
+      if (e.is_and()) {
+        for (unsigned int i = 0; i < e.num_args(); i++)
+          conjuncts.push_back(e.arg(i));
+        continue;
+      }
+      z3::expr var(c), value(c);
+      if (!as_definition(e, var, value) || defined.count(var.id()) ||
+          used.count(var.id()))
+        continue;
+      z3::expr_vector value_vars(c);
+      collect_vars(value, value_vars);
+      bool independent = true;
+      for (const auto& v : value_vars)
+        independent = independent && !defined.count(v.id());
+      if (!independent) continue;
+      defined.insert(var.id());
+      for (const auto& v : value_vars) used.insert(v.id());
+      from.push_back(var);
+      to.push_back(value);
+    }
+    if (from.empty()) break;
+    for (auto& definition : definitions)
+      definition.second = definition.second.substitute(from, to).simplify();
+    for (unsigned int i = 0; i < from.size(); i++)
+      definitions.emplace_back(from[i], to[i]);
+    reduced = reduced.substitute(from, to).simplify(simplify);
+  }
+  return reduced;
+}
+
+bool EqualityEliminator::reconstruct(Model& sample) const {
+  for (const auto& definition : definitions) {
+    const auto value = sample.evalIntExpr(definition.second, false, true);
+    if (!value.second) return false;
+    sample.addIntAssignment(definition.first.decl().name().str(), value.first);
+  }
+  return true;
+}
+
+void EqualityEliminator::reconstruct(z3::model& model) const {
+  for (const auto& definition : definitions) {
+    z3::func_decl var = definition.first.decl();
+    z3::expr value = model.eval(definition.second, true);
+    model.add_const_interp(var, value);
+  }
+}
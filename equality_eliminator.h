@@ -0,0 +1,45 @@
+#ifndef MEGASAMPLER_EQUALITY_ELIMINATOR_H
+#define MEGASAMPLER_EQUALITY_ELIMINATOR_H
+
+#include <z3++.h>
+
+#include <utility>
+#include <vector>
+
+#include "model.h"
+
+/*
+ * Eliminates the Int variables that a top-level linear equality defines,
+ * like x in x - y - 2z = -5. The strengthener pins every variable of an
+ * equality to its seed value, so the box of x, y and z would be a point;
+ * with x replaced by y + 2z - 5 the box spans y and z, and x is computed
+ * from them in every sample.
+ *
+ * Only variables with coefficient 1 or -1 are eliminated, so that their
+ * definitions are integral. Definitions are over the remaining variables
+ * only, and may be evaluated in any order.
+ */
+class EqualityEliminator {
+ public:
+  /* returns formula, a conjunction, with the variables it defines replaced */
+  z3::expr eliminate(const z3::expr& formula, const z3::params& simplify);
+  /*
+   * Sets the eliminated variables of sample. Variables of a definition that
+   * sample lacks get random values. False if a value overflows int64.
+   */
+  bool reconstruct(Model& sample) const;
+  /* adds the eliminated variables to a model of the reduced formula */
+  void reconstruct(z3::model& model) const;
+  [[nodiscard]] size_t size() const { return definitions.size(); }
+  [[nodiscard]] bool empty() const { return definitions.empty(); }
+
+ private:
+  static constexpr unsigned int MAX_ROUNDS = 16;
+  std::vector<std::pair<z3::expr, z3::expr>> definitions;  // variable, value
+
+  /* true if equality defines a variable, which is then set with its value */
+  static bool as_definition(const z3::expr& equality, z3::expr& var,
+                            z3::expr& value);
+};
+
+#endif  // MEGASAMPLER_EQUALITY_ELIMINATOR_H
@@ -0,0 +1,49 @@
+#ifndef MEGASAMPLER_EXPR_WALKER_H
+#define MEGASAMPLER_EXPR_WALKER_H
+
+#include <z3++.h>
+
+#include <vector>
+
+/*
+ * Iterative pre-order walk over the DAG of a formula. A subterm that many
+ * parents share is visited once, where a recursive walk would visit it once
+ * per path, and deep formulas don't grow the call stack. Visited subterms
+ * are marked by their AST id, which z3 keeps dense. A walker may walk
+ * several roots; what they share is visited once.
+ */
+class ExprWalker {
+ public:
+  /*
+   * Visits the subterms of root not visited yet, each before its children,
+   * and the children in order. visit(e) returns true to walk all the
+   * children of e; otherwise it may pick some of them with descend().
+   */
+  template <typename Visit>
+  void walk(const z3::expr& root, Visit&& visit) {
+    stack.push_back(root);
+    while (!stack.empty()) {
+      const z3::expr e = stack.back();
+      stack.pop_back();
+      if (!mark(e) || !visit(e) || !e.is_app()) continue;
+      for (unsigned int i = e.num_args(); i-- > 0;) stack.push_back(e.arg(i));
+    }
+  }
+  /* walks child next (the last one first); only from inside visit */
+  void descend(const z3::expr& child) { stack.push_back(child); }
+
+ private:
+  std::vector<bool> visited;  // by AST id
+  std::vector<z3::expr> stack;
+
+  /* true the first time e is seen */
+  bool mark(const z3::expr& e) {
+    const unsigned int id = e.id();
+    if (id >= visited.size()) visited.resize(2 * (size_t)id + 1, false);
+    if (visited[id]) return false;
+    visited[id] = true;
+    return true;
+  }
+};
+
+#endif  // MEGASAMPLER_EXPR_WALKER_H
@@ -51,6 +51,11 @@ bool Interval::is_top() const {
   return is_high_inf() && is_low_minf();
 }
 
+uint128_t Interval::width() const {
+  if (is_bottom()) return 0;
+  return (uint128_t)high - (uint128_t)low + 1;
+}
+
 bool Interval::is_in_range(int64_t val) const {
     return (val >= low && val <= high);
 }
@@ -5,6 +5,8 @@
 #include <iostream>
 #include <string>
 
+__extension__ typedef unsigned __int128 uint128_t;
+
 /* interval class */
 class Interval {
     int64_t low;
@@ -27,6 +29,8 @@ class Interval {
     /* one-sided infinite interval */
     [[nodiscard]] bool is_infinite() const;
     friend std::ostream& operator<<(std::ostream& os, const Interval& interval);
+    /* number of integers in the (finite) interval */
+    [[nodiscard]] uint128_t width() const;
     /* returns true if value is within the interval */
     [[nodiscard]] bool is_in_range(int64_t value) const;
     /* returns a random value in the interval */
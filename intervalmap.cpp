@@ -1,6 +1,8 @@
 
 #include "intervalmap.h"
 
+#include <cmath>
+
 bool is_inf(const IntervalMap& i_map) {
   for (const auto& varinterval : i_map) {
     const auto& interval = varinterval.second;
@@ -13,14 +15,42 @@ bool is_inf(const IntervalMap& i_map) {
  * Returns false if the interval is infinite, 
  * true if it is finite, 
  * and the size of the interval is returned by reference i_size
+ * (saturated to INT64_MAX if it doesn't fit)
 */
 bool intervals_size(const IntervalMap& i_map, int64_t& i_size) {
-  int64_t size = 1;
+  uint128_t volume;
+  if (is_inf(i_map)) return false;
+  if (!intervals_volume(i_map, volume) || volume > (uint128_t)INT64_MAX) {
+    i_size = INT64_MAX;
+  } else {
+    i_size = (int64_t)volume;
+  }
+  return true;
+}
+
+/**
+ * Returns true and the exact number of points in the box if the box is finite
+ * and the number fits in 128 bits, false otherwise
+ */
+bool intervals_volume(const IntervalMap& i_map, uint128_t& volume) {
+  uint128_t size = 1;
   for (const auto& varinterval : i_map) {
     const auto& interval = varinterval.second;
     if (interval.is_infinite()) return false;
-    size *= (interval.get_high() - interval.get_low()) + 1;  // TODO: safe_mul
+    if (__builtin_mul_overflow(size, interval.width(), &size)) return false;
   }
-  i_size = size;
+  volume = size;
   return true;
 }
+
+/**
+ * Returns log2 of the number of points in the box, an infinite side counting
+ * as the whole int64 range
+ */
+double intervals_log2_volume(const IntervalMap& i_map) {
+  double log_volume = 0.0;
+  for (const auto& varinterval : i_map) {
+    log_volume += std::log2((double)varinterval.second.width());
+  }
+  return log_volume;
+}
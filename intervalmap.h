@@ -27,5 +27,7 @@ typedef std::unordered_map<z3::expr, Interval> IntervalMap; // mapping Z3 expres
 
 bool is_inf(const IntervalMap& i_map);
 bool intervals_size(const IntervalMap& i_map, int64_t& i_size);
+bool intervals_volume(const IntervalMap& i_map, uint128_t& volume);
+double intervals_log2_volume(const IntervalMap& i_map);
 
 #endif  // MEGASAMPLER_INTERVALMAP_H
@@ -0,0 +1,132 @@
+#include "linear.h"
+
+#include <cassert>
+
+#include "z3_utils.h"
+
+static constexpr int128_t COEFF_LIMIT = INT64_MAX;
+
+bool linearize(const z3::expr& e, int128_t coeff,
+               std::unordered_map<z3::expr, int128_t>& terms,
+               int128_t& constant) {
+  if (coeff > COEFF_LIMIT || coeff < -COEFF_LIMIT) return false;
+  if (e.is_numeral()) {
+    int64_t value;
+    if (!e.is_numeral_i64(value)) return false;
+    return !__builtin_mul_overflow(coeff, (int128_t)value, &coeff) &&
+           !__builtin_add_overflow(constant, coeff, &constant);
+  }
+  if (!e.is_app()) return false;
+  const Z3_decl_kind op = get_op(e);
+  if (e.is_const() && is_op_uninterpreted(op)) {
+    if (!e.is_int()) return false;
+    int128_t& c_var = terms[e];
+    c_var += coeff;
+    return c_var <= COEFF_LIMIT && c_var >= -COEFF_LIMIT;
+  }
+  if (is_op_add(op)) {
+    for (unsigned int i = 0; i < e.num_args(); i++) {
+      if (!linearize(e.arg(i), coeff, terms, constant)) return false;
+    }
+    return true;
+  }
+  if (is_op_sub(op)) {
+    for (unsigned int i = 0; i < e.num_args(); i++) {
+      if (!linearize(e.arg(i), i == 0 ? coeff : -coeff, terms, constant))
+        return false;
+    }
+    return true;
+  }
+  if (is_op_uminus(op)) return linearize(e.arg(0), -coeff, terms, constant);
+  if (is_op_mul(op)) {
+    int non_constant = -1;
+    for (unsigned int i = 0; i < e.num_args(); i++) {
+      int64_t value;
+      if (e.arg(i).is_numeral_i64(value)) {
+        if (__builtin_mul_overflow(coeff, (int128_t)value, &coeff) ||
+            coeff > COEFF_LIMIT || coeff < -COEFF_LIMIT)
+          return false;
+      } else if (non_constant < 0) {
+        non_constant = i;
+      } else {
+        return false;  // product of variables
+      }
+    }
+    if (non_constant < 0) {
+      return !__builtin_add_overflow(constant, coeff, &constant);
+    }
+    return linearize(e.arg(non_constant), coeff, terms, constant);
+  }
+  return false;
+}
+
+bool to_linear_constraint(const z3::expr& literal, const z3::model& model,
+                          LinearConstraint& constraint) {
+  if (literal.is_not()) {
+    const z3::expr& argument = literal.arg(0);
+    if (argument.is_const() || !is_binary_boolean(argument)) return false;
+    return to_linear_constraint(negate_condition(argument), model,
+                                constraint);
+  }
+  if (!literal.is_app() || !is_binary_boolean(literal) ||
+      literal.num_args() != 2)
+    return false;
+  const z3::expr& lhs = literal.arg(0);
+  const z3::expr& rhs = literal.arg(1);
+  if (!lhs.is_int() || !rhs.is_int()) return false;
+  Z3_decl_kind op = get_op(literal);
+  if (is_op_distinct(op)) {
+    op = model_eval_to_bool(model, lhs < rhs) ? Z3_OP_LT : Z3_OP_GT;
+  }
+
+  std::unordered_map<z3::expr, int128_t> terms;
+  int128_t constant = 0;
+  if (!linearize(lhs, 1, terms, constant) ||
+      !linearize(rhs, -1, terms, constant))
+    return false;
+
+  // sum(c_i * x_i) + constant op 0
+  int128_t sign = 1;
+  constraint.is_eq = is_op_eq(op);
+  constraint.bound = -constant;
+  if (is_op_lt(op)) {
+    constraint.bound -= 1;
+  } else if (is_op_ge(op) || is_op_gt(op)) {
+    sign = -1;
+    constraint.bound = is_op_gt(op) ? constant - 1 : constant;
+  } else if (!is_op_le(op) && !constraint.is_eq) {
+    return false;
+  }
+  constraint.terms.clear();
+  for (const auto& term : terms) {
+    if (term.second != 0)
+      constraint.terms.emplace_back(term.first, sign * term.second);
+  }
+  return true;
+}
+
+int128_t floor_div(int128_t a, int128_t b) {
+  assert(b > 0);
+  int128_t q = a / b;
+  if (a % b != 0 && a < 0) q--;
+  return q;
+}
+
+int128_t clamp_to_int64(int128_t value) {
+  if (value < INT64_MIN) return INT64_MIN;
+  if (value > INT64_MAX) return INT64_MAX;
+  return value;
+}
+
+std::string int128_to_string(int128_t value) {
+  if (value == 0) return "0";
+  const bool negative = value < 0;
+  uint128_t magnitude = negative ? -(uint128_t)value : (uint128_t)value;
+  std::string digits;
+  while (magnitude > 0) {
+    digits.push_back('0' + (char)(magnitude % 10));
+    magnitude /= 10;
+  }
+  if (negative) digits.push_back('-');
+  return std::string(digits.rbegin(), digits.rend());
+}
@@ -0,0 +1,46 @@
+#ifndef MEGASAMPLER_LINEAR_H
+#define MEGASAMPLER_LINEAR_H
+
+#include <z3++.h>
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "intervalmap.h"
+
+__extension__ typedef __int128 int128_t;
+
+/*
+ * sum(c_i * x_i) <= bound (or = bound) over Int constants x_i, with non-zero
+ * coefficients that fit in int64.
+ */
+struct LinearConstraint {
+  std::vector<std::pair<z3::expr, int128_t>> terms;
+  int128_t bound = 0;
+  bool is_eq = false;
+};
+
+/*
+ * Adds coeff * e to terms and constant. Returns false if e isn't linear over
+ * Int constants or a coefficient doesn't fit in int64.
+ */
+bool linearize(const z3::expr& e, int128_t coeff,
+               std::unordered_map<z3::expr, int128_t>& terms,
+               int128_t& constant);
+
+/*
+ * Normalizes an integer comparison (or its negation) to a LinearConstraint.
+ * Strict comparisons are made non-strict and a distinct becomes the strict
+ * inequality that holds in the model. Returns false if it isn't linear.
+ */
+bool to_linear_constraint(const z3::expr& literal, const z3::model& model,
+                          LinearConstraint& constraint);
+
+/* division rounding towards minus infinity, b > 0 */
+int128_t floor_div(int128_t a, int128_t b);
+int128_t clamp_to_int64(int128_t value);
+std::string int128_to_string(int128_t value);
+
+#endif  // MEGASAMPLER_LINEAR_H
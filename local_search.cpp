@@ -0,0 +1,227 @@
+#include "local_search.h"
+
+#include <climits>
+
+#include "z3_utils.h"
+
+bool LocalSearch::compile(const z3::expr& formula) {
+  const z3::model model(formula.ctx());
+  std::vector<z3::expr> stack{formula};
+  while (!stack.empty()) {
+    const z3::expr e = stack.back();
+    stack.pop_back();
+    if (e.is_and()) {
+      for (unsigned int i = 0; i < e.num_args(); i++) stack.push_back(e.arg(i));
+      continue;
+    }
+    std::vector<z3::expr> disjuncts;
+    if (e.is_or()) {
+      for (unsigned int i = 0; i < e.num_args(); i++)
+        disjuncts.push_back(e.arg(i));
+    } else {
+      disjuncts.push_back(e);
+    }
+    if (!add_clause(disjuncts, model)) return false;
+  }
+  occurrences.assign(vars.size(), {});
+  for (unsigned int l = 0; l < literals.size(); l++) {
+    for (const auto& term : literals[l].terms)
+      occurrences[term.first].emplace_back(l, term.second);
+  }
+  return true;
+}
+
+bool LocalSearch::add_clause(const std::vector<z3::expr>& disjuncts,
+                             const z3::model& model) {
+  std::vector<Literal> clause_literals;
+  for (const auto& disjunct : disjuncts) {
+    if (disjunct.is_true()) return true;
+    if (disjunct.is_false()) continue;
+    if (!add_literal(disjunct, model, clause_literals)) return false;
+  }
+  std::vector<unsigned int> clause;
+  for (auto& literal : clause_literals) {
+    if (literal.terms.empty()) {
+      if (is_sat(literal, 0)) return true;  // the clause always holds
+      continue;
+    }
+    literal.clause = clauses.size();
+    clause.push_back(literals.size());
+    literals.push_back(std::move(literal));
+  }
+  if (clause.empty()) return false;  // the clause never holds
+  clauses.push_back(std::move(clause));
+  return true;
+}
+
+bool LocalSearch::add_literal(const z3::expr& literal, const z3::model& model,
+                              std::vector<Literal>& clause_literals) {
+  // a distinct is a disjunction of two strict inequalities
+  const bool is_distinct =
+      literal.is_app() && is_op_distinct(get_op(literal)) &&
+      literal.num_args() == 2;
+  const bool is_not_eq = literal.is_not() && literal.arg(0).is_app() &&
+                         is_op_eq(get_op(literal.arg(0)));
+  if (is_distinct || is_not_eq) {
+    const z3::expr& e = is_distinct ? literal : literal.arg(0);
+    if (!e.arg(0).is_int()) return false;
+    return add_literal(e.arg(0) < e.arg(1), model, clause_literals) &&
+           add_literal(e.arg(0) > e.arg(1), model, clause_literals);
+  }
+  LinearConstraint constraint;
+  if (!to_linear_constraint(literal, model, constraint)) return false;
+  Literal compiled;
+  compiled.bound = constraint.bound;
+  compiled.is_eq = constraint.is_eq;
+  for (const auto& term : constraint.terms) {
+    const auto it = var_index.emplace(term.first.id(), vars.size()).first;
+    if (it->second == vars.size()) vars.push_back(term.first);
+    compiled.terms.emplace_back(it->second, (int64_t)term.second);
+  }
+  clause_literals.push_back(std::move(compiled));
+  return true;
+}
+
+bool LocalSearch::critical_move(unsigned int literal, int64_t coeff,
+                                unsigned int var, int64_t& delta) const {
+  const int128_t r = literals[literal].bound - lhs[literal];
+  int128_t d;
+  if (literals[literal].is_eq) {
+    if (r % coeff != 0) return false;
+    d = r / coeff;
+  } else {
+    if (r >= 0) return false;  // already holds
+    d = coeff > 0 ? floor_div(r, coeff) : -floor_div(r, -(int128_t)coeff);
+  }
+  const int128_t value = values[var] + d;
+  if (d == 0 || value < INT64_MIN || value > INT64_MAX) return false;
+  delta = (int64_t)d;
+  return true;
+}
+
+long LocalSearch::score(unsigned int var, int64_t delta) {
+  for (const auto& occurrence : occurrences[var]) {
+    const Literal& literal = literals[occurrence.first];
+    const int128_t value = lhs[occurrence.first];
+    const bool before = is_sat(literal, value);
+    const bool after =
+        is_sat(literal, value + (int128_t)occurrence.second * delta);
+    if (before == after) continue;
+    if (clause_delta[literal.clause] == 0) touched.push_back(literal.clause);
+    clause_delta[literal.clause] += after ? 1 : -1;
+  }
+  long s = 0;
+  for (const unsigned int clause : touched) {
+    const long now = (long)num_sat[clause] + clause_delta[clause];
+    if (num_sat[clause] == 0 && now > 0) s += weights[clause];
+    if (num_sat[clause] > 0 && now == 0) s -= weights[clause];
+    clause_delta[clause] = 0;
+  }
+  touched.clear();
+  return s;
+}
+
+void LocalSearch::set_sat(unsigned int clause, bool sat) {
+  if (sat) {
+    const unsigned int last = unsat.back();
+    unsat[unsat_position[clause]] = last;
+    unsat_position[last] = unsat_position[clause];
+    unsat.pop_back();
+  } else {
+    unsat_position[clause] = unsat.size();
+    unsat.push_back(clause);
+  }
+}
+
+void LocalSearch::move(unsigned int var, int64_t delta, unsigned long step,
+                       std::mt19937& g) {
+  values[var] += delta;
+  for (const auto& occurrence : occurrences[var]) {
+    const Literal& literal = literals[occurrence.first];
+    int128_t& value = lhs[occurrence.first];
+    const bool before = is_sat(literal, value);
+    value += (int128_t)occurrence.second * delta;
+    const bool after = is_sat(literal, value);
+    if (before == after) continue;
+    if (after && num_sat[literal.clause]++ == 0) set_sat(literal.clause, true);
+    if (!after && --num_sat[literal.clause] == 0)
+      set_sat(literal.clause, false);
+  }
+  const unsigned long tenure = step + MIN_TABU + g() % TABU_RANGE;
+  if (delta > 0)
+    tabu_down[var] = tenure;
+  else
+    tabu_up[var] = tenure;
+}
+
+void LocalSearch::perturb(std::vector<int64_t>& point, std::mt19937& g) {
+  std::uniform_int_distribution<int64_t> perturbation(-PERTURBATION,
+                                                      PERTURBATION);
+  for (auto& value : point) {
+    if (g() % 2) continue;
+    const int64_t change = perturbation(g);
+    if ((change > 0 && value <= INT64_MAX - change) ||
+        (change < 0 && value >= INT64_MIN - change))
+      value += change;
+  }
+}
+
+bool LocalSearch::search(std::vector<int64_t>& point, std::mt19937& g,
+                         const std::atomic<bool>& stop) {
+  values = point;
+  lhs.assign(literals.size(), 0);
+  num_sat.assign(clauses.size(), 0);
+  weights.assign(clauses.size(), 1);
+  unsat.clear();
+  unsat_position.assign(clauses.size(), 0);
+  tabu_up.assign(vars.size(), 0);
+  tabu_down.assign(vars.size(), 0);
+  clause_delta.assign(clauses.size(), 0);
+  for (unsigned int l = 0; l < literals.size(); l++) {
+    for (const auto& term : literals[l].terms)
+      lhs[l] += (int128_t)term.second * values[term.first];
+    if (is_sat(literals[l], lhs[l])) num_sat[literals[l].clause]++;
+  }
+  for (unsigned int c = 0; c < clauses.size(); c++) {
+    if (num_sat[c] == 0) set_sat(c, false);
+  }
+
+  size_t best = unsat.size();
+  unsigned long since_best = 0;
+  for (unsigned long step = 1; !unsat.empty(); step++) {
+    if (since_best > MAX_STEPS || stop) return false;
+    const unsigned int clause = unsat[g() % unsat.size()];
+    long best_score = LONG_MIN;
+    unsigned int best_var = 0;
+    int64_t best_delta = 0;
+    unsigned int ties = 0;
+    for (const unsigned int l : clauses[clause]) {
+      for (const auto& term : literals[l].terms) {
+        int64_t delta;
+        if (!critical_move(l, term.second, term.first, delta)) continue;
+        if (step < (delta > 0 ? tabu_up : tabu_down)[term.first]) continue;
+        const long s = score(term.first, delta);
+        if (s > best_score) {
+          ties = 1;
+        } else if (s < best_score || g() % ++ties != 0) {
+          continue;
+        }
+        best_score = s;
+        best_var = term.first;
+        best_delta = delta;
+      }
+    }
+    if (best_score <= 0) {
+      for (const unsigned int c : unsat) weights[c]++;
+    }
+    if (best_score != LONG_MIN) move(best_var, best_delta, step, g);
+    if (unsat.size() < best) {
+      best = unsat.size();
+      since_best = 0;
+    } else {
+      since_best++;
+    }
+  }
+  point = values;
+  return true;
+}
@@ -0,0 +1,95 @@
+#ifndef MEGASAMPLER_LOCAL_SEARCH_H
+#define MEGASAMPLER_LOCAL_SEARCH_H
+
+#include <z3++.h>
+
+#include <atomic>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "linear.h"
+
+/*
+ * Local search for a model of a conjunction of clauses of linear Int
+ * literals, in the style of LS-LIA: from an unsatisfied clause, make the
+ * critical move (the smallest change of one variable that satisfies one of
+ * its literals) that most increases the weight of the satisfied clauses.
+ * A variable may not move back for a few steps after it moved (tabu). When
+ * no move improves, the weights of the unsatisfied clauses grow.
+ *
+ * compile() reads the formula with z3; search() only touches the compiled
+ * constraints, so it can run in another thread while z3 solves.
+ */
+class LocalSearch {
+ public:
+  /*
+   * Compiles a conjunction of disjunctions of linear Int literals. Returns
+   * false for any other formula.
+   */
+  bool compile(const z3::expr& formula);
+  /*
+   * Moves about half of the values of point (in the order of get_vars()) by
+   * up to PERTURBATION, so that a search from a model finds another one.
+   */
+  static void perturb(std::vector<int64_t>& point, std::mt19937& g);
+  /*
+   * Searches from point until every clause holds, stop is set or the search
+   * stalls: MAX_STEPS steps without fewer unsatisfied clauses than its best.
+   * Returns true with the model in point, which is point itself if it
+   * already is one.
+   */
+  bool search(std::vector<int64_t>& point, std::mt19937& g,
+              const std::atomic<bool>& stop);
+  [[nodiscard]] const std::vector<z3::expr>& get_vars() const { return vars; }
+
+ private:
+  static constexpr unsigned long MAX_STEPS = 100000;
+  static constexpr unsigned int MIN_TABU = 3;
+  static constexpr unsigned int TABU_RANGE = 10;
+  static constexpr int64_t PERTURBATION = 1024;
+  /* sum(coeff * var) <= bound, or = bound */
+  struct Literal {
+    std::vector<std::pair<unsigned int, int64_t>> terms;  // (var, coeff)
+    int128_t bound;
+    bool is_eq;
+    unsigned int clause;
+  };
+  std::vector<z3::expr> vars;
+  std::vector<Literal> literals;
+  std::vector<std::vector<unsigned int>> clauses;  // literal indices
+  // for every variable: (literal, coeff) of the literals it appears in
+  std::vector<std::vector<std::pair<unsigned int, int64_t>>> occurrences;
+
+  // search state
+  std::vector<int64_t> values;
+  std::vector<int128_t> lhs;  // sum(coeff * var) of every literal
+  std::vector<unsigned int> num_sat;  // satisfied literals of every clause
+  std::vector<unsigned long> weights;
+  std::vector<unsigned int> unsat;  // unsatisfied clauses
+  std::vector<unsigned int> unsat_position;
+  std::vector<unsigned long> tabu_up;  // no increase before this step
+  std::vector<unsigned long> tabu_down;
+  std::vector<long> clause_delta;  // scratch, per clause
+  std::vector<unsigned int> touched;
+  std::unordered_map<unsigned int, unsigned int> var_index;  // by expr id
+
+  bool add_clause(const std::vector<z3::expr>& disjuncts,
+                  const z3::model& model);
+  bool add_literal(const z3::expr& literal, const z3::model& model,
+                   std::vector<Literal>& clause_literals);
+  [[nodiscard]] bool is_sat(const Literal& literal, int128_t value) const {
+    return literal.is_eq ? value == literal.bound : value <= literal.bound;
+  }
+  /* the change of var that satisfies literal, false if there is none */
+  bool critical_move(unsigned int literal, int64_t coeff, unsigned int var,
+                     int64_t& delta) const;
+  /* weight of the clauses the move satisfies minus those it falsifies */
+  long score(unsigned int var, int64_t delta);
+  void move(unsigned int var, int64_t delta, unsigned long step,
+            std::mt19937& g);
+  void set_sat(unsigned int clause, bool sat);
+};
+
+#endif  // MEGASAMPLER_LOCAL_SEARCH_H
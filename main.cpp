@@ -54,6 +54,22 @@ static const char *argp_doc = "megasampler -- Sample SMT formulas";
 
 static const char *argp_args_doc = "INPUT";
 
+/* keys for options that only have a long name */
+enum {
+    OPT_EPOCH_POLICY = 256,
+    OPT_VOLUME_WEIGHTED,
+    OPT_BOX_CACHE,
+    OPT_STRENGTHEN,
+    OPT_GRACEFUL_STRENGTHENING,
+    OPT_SEED_MODE,
+    OPT_LOCAL_SEARCH,
+    OPT_SEED_CHAINING,
+    OPT_IMPLICANTS,
+    OPT_DISJUNCT_POLICY,
+    OPT_DECOMPOSE,
+    OPT_ELIMINATE_EQUALITIES
+};
+
 static struct argp_option options[] = {
     {"algorithm", 'a', "ALGORITHM", 0,
      "Select which sampling algorithm to use {MeGA, MeGAb, SMT, z3}", 0},
@@ -80,18 +96,78 @@ static struct argp_option options[] = {
      "MeGA: Number of sampling rounds in each epoch", 0},
     {"output-dir", 'o', "DIRECTORY", 0,
      "Output directory (for statistics, samples, ...)", 0},
+    {"coverage", 'c', 0, 0, "Track wire coverage of the samples while sampling",
+     0},
+    {"stop-on-coverage-plateau", 'P', "RATE", 0,
+     "Stop when wire coverage grows by less than RATE (fraction of all wires) "
+     "per second, implies --coverage",
+     0},
+    {"epoch-policy", OPT_EPOCH_POLICY, "POLICY", 0,
+     "MeGA: When to abandon a box and start a new epoch {legacy, adaptive}", 0},
+    {"volume-weighted", OPT_VOLUME_WEIGHTED, 0, 0,
+     "MeGA: Sample all boxes found so far, weighted by their volume", 0},
+    {"box-cache", OPT_BOX_CACHE, 0, 0,
+     "MeGA: Skip strengthening when a box found before for the same implicant "
+     "contains the seed, and sample that box (array equality removal still "
+     "runs)",
+     0},
+    {"strengthen", OPT_STRENGTHEN, "ENGINE", 0,
+     "MeGA: How to grow the seed into a region {legacy, volume, octagon, "
+     "polytope}",
+     0},
+    {"graceful-strengthening", OPT_GRACEFUL_STRENGTHENING, 0, 0,
+     "MeGA: Pin the variables of a literal no rule can strengthen to the "
+     "seed, instead of aborting",
+     0},
+    {"seed-mode", OPT_SEED_MODE, "MODE", 0,
+     "How to find the seed of an epoch {maxsmt, cheap}: cheap is plain SMT "
+     "with a random seed and random targets for a few variables",
+     0},
+    {"local-search", OPT_LOCAL_SEARCH, 0, 0,
+     "MeGA: Race a native local search against z3 for the seeds of linear "
+     "integer formulas",
+     0},
+    {"seed-chaining", OPT_SEED_CHAINING, "K", 0,
+     "MeGA: Solve for a fresh seed only every K-th epoch, the other epochs "
+     "start from recent samples",
+     0},
+    {"implicants", OPT_IMPLICANTS, "N", 0,
+     "MeGA: Strengthen and sample up to N distinct implicants of every seed "
+     "(default 1)",
+     0},
+    {"disjunct-policy", OPT_DISJUNCT_POLICY, "POLICY", 0,
+     "MeGA: How to choose among the satisfied disjuncts of a disjunction "
+     "{uniform, ucb} (default uniform)",
+     0},
+    {"decompose", OPT_DECOMPOSE, 0, 0,
+     "MeGA: Split the formula into conjunctions over disjoint variables, "
+     "solve one of them per epoch and combine their boxes",
+     0},
+    {"eliminate-equalities", OPT_ELIMINATE_EQUALITIES, 0, 0,
+     "MeGA: Substitute away the Int variables that linear equalities define, "
+     "and compute them in every sample",
+     0},
     {0, 0, 0, 0, 0, 0}};
 
 struct args {
     char *input;
     std::string output_dir{getcwd(NULL, 0)};
     unsigned int max_epochs = 1000000, max_samples = 1000000,
-                 max_epoch_samples = 10000, num_rounds = 50;
+                 max_epoch_samples = 10000, num_rounds = 50, seed_chaining = 0,
+                 implicants = 1;
     enum algorithm algorithm = ALGO_UNSET;
+    enum epoch_policy epoch_policy = EPOCH_POLICY_LEGACY;
+    enum strengthen_engine strengthen_engine = STRENGTHEN_LEGACY;
+    enum seed_mode seed_mode = SEED_MODE_MAXSMT;
+    enum disjunct_policy disjunct_policy = DISJUNCT_POLICY_UNIFORM;
     int strategy = STRAT_SMTBIT;
     bool json = false, no_write = false, debug = false, one_epoch = false,
-         exhaust_epoch = false, save_interval_size = false, avoid_maxsmt = false;
-    double max_time = 3600.0, max_epoch_time = 600.0, min_rate = 0.95;
+         exhaust_epoch = false, save_interval_size = false, avoid_maxsmt = false,
+         coverage = false, volume_weighted = false, box_cache = false,
+         graceful_strengthening = false, local_search = false, decompose = false,
+         eliminate_equalities = false;
+    double max_time = 3600.0, max_epoch_time = 600.0, min_rate = 0.95,
+           coverage_plateau = 0.0;
 };
 
 static error_t parse_opt(int key, char *arg, struct argp_state *state) {
@@ -164,6 +240,78 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
         case 'S':
             args->num_rounds = atoi(arg);
             break;
+        case 'c':
+            args->coverage = true;
+            break;
+        case 'P':
+            args->coverage = true;
+            args->coverage_plateau = atof(arg);
+            break;
+        case OPT_EPOCH_POLICY:
+            if (0 == strncasecmp("legacy", arg, 7)) {
+                args->epoch_policy = EPOCH_POLICY_LEGACY;
+            } else if (0 == strncasecmp("adaptive", arg, 9)) {
+                args->epoch_policy = EPOCH_POLICY_ADAPTIVE;
+            } else {
+                argp_usage(state);
+            }
+            break;
+        case OPT_VOLUME_WEIGHTED:
+            args->volume_weighted = true;
+            break;
+        case OPT_BOX_CACHE:
+            args->box_cache = true;
+            break;
+        case OPT_STRENGTHEN:
+            if (0 == strncasecmp("legacy", arg, 7)) {
+                args->strengthen_engine = STRENGTHEN_LEGACY;
+            } else if (0 == strncasecmp("volume", arg, 7)) {
+                args->strengthen_engine = STRENGTHEN_VOLUME;
+            } else if (0 == strncasecmp("octagon", arg, 8)) {
+                args->strengthen_engine = STRENGTHEN_OCTAGON;
+            } else if (0 == strncasecmp("polytope", arg, 9)) {
+                args->strengthen_engine = STRENGTHEN_POLYTOPE;
+            } else {
+                argp_usage(state);
+            }
+            break;
+        case OPT_GRACEFUL_STRENGTHENING:
+            args->graceful_strengthening = true;
+            break;
+        case OPT_SEED_MODE:
+            if (0 == strncasecmp("maxsmt", arg, 7)) {
+                args->seed_mode = SEED_MODE_MAXSMT;
+            } else if (0 == strncasecmp("cheap", arg, 6)) {
+                args->seed_mode = SEED_MODE_CHEAP;
+            } else {
+                argp_usage(state);
+            }
+            break;
+        case OPT_LOCAL_SEARCH:
+            args->local_search = true;
+            break;
+        case OPT_DECOMPOSE:
+            args->decompose = true;
+            break;
+        case OPT_ELIMINATE_EQUALITIES:
+            args->eliminate_equalities = true;
+            break;
+        case OPT_SEED_CHAINING:
+            args->seed_chaining = atoi(arg);
+            break;
+        case OPT_IMPLICANTS:
+            args->implicants = atoi(arg);
+            if (args->implicants < 1) argp_usage(state);
+            break;
+        case OPT_DISJUNCT_POLICY:
+            if (0 == strncasecmp("uniform", arg, 8)) {
+                args->disjunct_policy = DISJUNCT_POLICY_UNIFORM;
+            } else if (0 == strncasecmp("ucb", arg, 4)) {
+                args->disjunct_policy = DISJUNCT_POLICY_UCB;
+            } else {
+                argp_usage(state);
+            }
+            break;
         case ARGP_KEY_END:
             if (state->arg_num < 1) argp_usage(state);
             break;
@@ -187,9 +335,11 @@ static volatile Sampler *volatile global_samplers[4] = {
 void signal_handler(__attribute__((unused)) int sig) {
     // External timeout
     if (NULL == global_samplers[0]) std::abort();
+    Watchdog::notify_signal();  // stops the running z3 check
     for (unsigned long i = 0;
          i < sizeof(global_samplers) / sizeof(*global_samplers); ++i) {
-        global_samplers[i]->set_exit();
+        // a regular run has a single sampler
+        if (NULL != global_samplers[i]) global_samplers[i]->set_exit();
     }
 }
 
@@ -198,7 +348,14 @@ SamplerConfig configFromArgs(const struct args &args, bool blocking) {
                          args.save_interval_size, args.avoid_maxsmt,
                          args.max_samples, args.max_epoch_samples, args.max_time,
                          args.max_epoch_time, args.strategy, args.json,
-                         args.no_write, args.min_rate, args.num_rounds);
+                         args.no_write, args.min_rate, args.num_rounds,
+                         args.coverage, args.coverage_plateau,
+                         args.epoch_policy, args.volume_weighted,
+                         args.box_cache, args.strengthen_engine,
+                         args.graceful_strengthening, args.seed_mode,
+                         args.local_search, args.seed_chaining,
+                         args.implicants, args.disjunct_policy,
+                         args.decompose, args.eliminate_equalities);
 }
 
 int regular_run(z3::context &c, const struct args &args) {
@@ -245,6 +402,7 @@ int regular_run(z3::context &c, const struct args &args) {
             s->do_epoch(m);
             s->accumulate_time("do_epoch");
             s->accumulate_time("epoch");
+            s->record_epoch_stats();
         }
     } catch (const z3::exception &except) {
         std::cout << "Termination due to: " << except << "\n";
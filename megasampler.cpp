@@ -1,8 +1,12 @@
 #include "megasampler.h"
 
+#include <algorithm>
+#include <climits>
 #include <cstdint>
 #include <iostream>
+#include <numeric>
 
+#include "expr_walker.h"
 #include "model.h"
 #include "z3_utils.h"
 
@@ -111,8 +115,10 @@ static inline void extract_array_from_store(const z3::expr& e,
     }
 }
 
-void MEGASampler::register_array_eq(z3::expr& f) {
-    if (is_array_eq(f)) {
+void MEGASampler::register_array_eq(const z3::expr& formula) {
+    ExprWalker walker;
+    walker.walk(formula, [this](const z3::expr& f) {
+        if (!is_array_eq(f)) return true;
         const z3::expr& left_a = f.arg(0);
         const z3::expr& right_a = f.arg(1);
         arrayEqualityEdge st_eq(c);
@@ -125,38 +131,341 @@ void MEGASampler::register_array_eq(z3::expr& f) {
         if (!z3::eq(st_eq.a, st_eq.b)) {
             arrayEqualityGraph[st_eq.b.to_string()].push_back(st_eq);
         }
-    } else {
-        for (auto child : f) {
-            register_array_eq(child);
-        }
-    }
+        return false;
+    });
+}
+
+static inline z3::expr combine_expr(const z3::expr& base, const z3::expr& arg) {
+    if (base) return base && arg;
+    return arg;
 }
 
 MEGASampler::MEGASampler(z3::context* _c, const std::string& _input,
                          const std::string& _output_dir,
                          const MeGA::SamplerConfig& config)
-    : Sampler(_c, _input, _output_dir, config), simpl_formula(c), implicant(c) {
+    : Sampler(_c, _input, _output_dir, config),
+      simpl_formula(c),
+      implicant(c),
+      scheduler(EpochScheduler::create(this->config)),
+      disjunct_policy(DisjunctPolicy::create(this->config)),
+      uf_definitions(c) {
+    for (const auto& v : variables) {
+        const z3::sort range = v.range();
+        sample_names.push_back(v.name().str());
+        if (v.arity() > 0) {
+            bool int_function = range.is_int();
+            for (unsigned int i = 0; i < v.arity(); i++)
+                int_function = int_function && v.domain(i).is_int();
+            if (!int_function) {
+                std::cout << "Unsupported sort in formula. Exiting.\n";
+                failure_cause = "Unsupported sort in formula.";
+                safe_exit(1);
+            }
+            continue;
+        }
+        const bool wide_bv = range.is_bv() && range.bv_size() > 64;
+        // array accesses are sampled as Int intervals
+        const bool non_int_array =
+            range.is_array() &&
+            (range.array_domain().is_bv() || range.array_range().is_bv() ||
+             range.array_domain().is_real() || range.array_range().is_real());
+        if (wide_bv || non_int_array) {
+            std::cout << "Unsupported sort in formula. Exiting.\n";
+            failure_cause = "Unsupported sort in formula.";
+            safe_exit(1);
+        }
+    }
     simplify_formula();
     initialize_solvers();
+    if (config.local_search && !config.blocking) {
+        local_search = std::make_unique<LocalSearch>();
+        if (!local_search->compile(simpl_formula)) {
+            std::cout << "Local search: not a linear integer formula, using "
+                         "z3 only\n";
+            local_search.reset();
+        }
+    }
+    if (config.seed_chaining > 1) {
+        chain_seeds = true;
+        for (const auto& v : variables)
+            chain_seeds = chain_seeds && v.arity() == 0 && !v.range().is_array();
+        if (!chain_seeds)
+            std::cout << "Seed chaining: arrays or uninterpreted functions, "
+                         "solving for every seed\n";
+    }
+    if (config.decompose) decompose_formula();
     std::cout << "starting MeGASampler" << std::endl;
 }
 
-static inline void collect_z3_names(z3::expr& formula,
+void MEGASampler::decompose_formula() {
+    bool supported = !config.blocking &&
+                     config.strengthen_engine != MeGA::STRENGTHEN_OCTAGON &&
+                     config.strengthen_engine != MeGA::STRENGTHEN_POLYTOPE;
+    for (const auto& v : variables)
+        supported = supported && v.arity() == 0 && !v.range().is_array();
+    if (!supported) {
+        std::cout << "Decomposition: not with blocking, regions, arrays or "
+                     "uninterpreted functions\n";
+        return;
+    }
+    std::vector<z3::expr> conjuncts;
+    std::vector<z3::expr> stack{simpl_formula};
+    while (!stack.empty()) {
+        const z3::expr e = stack.back();
+        stack.pop_back();
+        if (e.is_and()) {
+            for (unsigned int i = 0; i < e.num_args(); i++)
+                stack.push_back(e.arg(i));
+        } else {
+            conjuncts.push_back(e);
+        }
+    }
+    // union-find over the ids of the variables
+    std::unordered_map<unsigned int, unsigned int> parent;
+    auto find = [&parent](unsigned int id) {
+        unsigned int root = id;
+        while (parent[root] != root) root = parent[root];
+        while (parent[id] != root) {
+            const unsigned int next = parent[id];
+            parent[id] = root;
+            id = next;
+        }
+        return root;
+    };
+    std::vector<std::vector<z3::expr>> conjunct_vars;
+    for (auto& conjunct : conjuncts) {
+        z3::expr_vector collected(c);
+        collect_vars(conjunct, collected);
+        std::vector<z3::expr> vars;
+        for (unsigned int i = 0; i < collected.size(); i++) {
+            if (collected[i].decl().decl_kind() != Z3_OP_UNINTERPRETED)
+                continue;  // true and false
+            vars.push_back(collected[i]);
+            parent.emplace(collected[i].id(), collected[i].id());
+        }
+        for (size_t i = 1; i < vars.size(); i++)
+            parent[find(vars[i].id())] = find(vars[0].id());
+        conjunct_vars.push_back(std::move(vars));
+    }
+    std::unordered_map<unsigned int, size_t> index_of_root;
+    std::vector<z3::expr_vector> component_conjuncts;
+    std::vector<z3::expr> ground;  // conjuncts without variables
+    for (size_t i = 0; i < conjuncts.size(); i++) {
+        if (conjunct_vars[i].empty()) {
+            ground.push_back(conjuncts[i]);
+            continue;
+        }
+        const unsigned int root = find(conjunct_vars[i][0].id());
+        auto it = index_of_root.find(root);
+        if (it == index_of_root.end()) {
+            it = index_of_root.emplace(root, components.size()).first;
+            components.emplace_back(c);
+            component_conjuncts.emplace_back(c);
+        }
+        component_conjuncts[it->second].push_back(conjuncts[i]);
+        for (const auto& var : conjunct_vars[i]) {
+            if (component_of.emplace(var.id(), it->second).second)
+                components[it->second].variables.push_back(var.decl());
+        }
+    }
+    // ground conjuncts go with the first component, whose solver checks them
+    for (const auto& conjunct : ground) {
+        if (!component_conjuncts.empty())
+            component_conjuncts[0].push_back(conjunct);
+    }
+    if (components.size() < 2) {
+        std::cout << "Decomposition: a single component\n";
+        components.clear();
+        component_of.clear();
+        return;
+    }
+    for (size_t k = 0; k < components.size(); k++) {
+        components[k].formula = z3::mk_and(component_conjuncts[k]);
+        components[k].solver.add(components[k].formula);
+    }
+    std::cout << "Decomposition: " << components.size() << " components\n";
+}
+
+z3::check_result MEGASampler::find_component_seed() {
+    const size_t k = next_component;
+    next_component = (next_component + 1) % components.size();
+    epoch_components.assign(1, k);
+    Component& component = components[k];
+    z3::params params(c);
+    params.set("random_seed", static_cast<unsigned>(g()));
+    params.set("phase_selection", 5u);  // random
+    component.solver.set(params);
+    z3::expr_vector targets = choose_random_targets(component.variables);
+    z3::check_result res;
+    while (true) {
+        try {
+            smt_calls++;
+            Watchdog::Guard guard(watchdog, deadline("epoch", UINT_MAX));
+            res = targets.empty() ? component.solver.check()
+                                  : component.solver.check(targets);
+        } catch (const z3::exception& except) {
+            std::cout << "Exception: " << except << "\n";
+            std::stringstream ss;
+            ss << except;
+            failure_cause = "SMT (z3) exception: " + ss.str();
+            safe_exit(1);
+        }
+        if (res != z3::unsat || targets.empty()) break;
+        targets = z3::expr_vector(c);  // the targets conflict
+    }
+    if (res != z3::sat) return res;  // the component keeps its values
+    const z3::model values = component.solver.get_model();
+    z3::model seed(c);
+    for (unsigned int i = 0; i < model.num_consts(); i++) {
+        z3::func_decl decl = model.get_const_decl(i);
+        const auto it = component_of.find(decl().id());
+        if (it != component_of.end() && it->second == k) continue;
+        z3::expr value = model.get_const_interp(decl);
+        seed.add_const_interp(decl, value);
+    }
+    for (const auto& var : component.variables) {
+        z3::func_decl decl = var;
+        z3::expr value = values.eval(var(), true);
+        seed.add_const_interp(decl, value);
+    }
+    model = seed;
+    component.seeds++;
+    return z3::sat;
+}
+
+void MEGASampler::compute_implicant(const z3::model& m,
+                                    std::list<z3::expr>& conjuncts) {
+    if (components.empty()) {
+        remove_or(simpl_formula, m, conjuncts);
+        return;
+    }
+    for (const size_t k : epoch_components)
+        remove_or(components[k].formula, m, conjuncts);
+}
+
+void MEGASampler::combine_component_boxes(IntervalMap& i_map) {
+    std::vector<bool> in_epoch(components.size(), false);
+    for (const size_t k : epoch_components) in_epoch[k] = true;
+    // the bounds on the variables of other components (such as the bools the
+    // implicant leaves free) give way to their boxes
+    std::vector<ComponentBox> parts(components.size());
+    for (auto it = i_map.begin(); it != i_map.end();) {
+        const auto component = component_of.find(it->first.id());
+        if (component == component_of.end()) {
+            ++it;
+        } else if (in_epoch[component->second]) {
+            parts[component->second].i_map.insert(*it++);
+        } else {
+            it = i_map.erase(it);
+        }
+    }
+    for (auto it = r_map.begin(); it != r_map.end();) {
+        const auto component = component_of.find(it->first.id());
+        if (component == component_of.end()) {
+            ++it;
+        } else if (in_epoch[component->second]) {
+            parts[component->second].r_map.insert(*it++);
+        } else {
+            it = r_map.erase(it);
+        }
+    }
+    for (const size_t k : epoch_components) {
+        auto& boxes = components[k].boxes;
+        if (boxes.size() >= BOXES_PER_COMPONENT) boxes.pop_front();
+        boxes.push_back(std::move(parts[k]));
+    }
+    for (size_t k = 0; k < components.size(); k++) {
+        if (in_epoch[k] || components[k].boxes.empty()) continue;
+        const auto& boxes = components[k].boxes;
+        const ComponentBox& box =
+            *std::next(boxes.begin(), g() % boxes.size());
+        i_map.insert(box.i_map.begin(), box.i_map.end());
+        r_map.insert(box.r_map.begin(), box.r_map.end());
+    }
+}
+
+z3::check_result MEGASampler::find_seed() {
+    const z3::check_result res = find_reduced_seed();
+    if (res == z3::sat) eliminator.reconstruct(model);
+    return res;
+}
+
+z3::check_result MEGASampler::find_reduced_seed() {
+    epoch_components.clear();
+    if (components.size() > 1 && epochs > 0) {
+        if (find_component_seed() == z3::sat) return z3::sat;
+        // a component that timed out doesn't stop the sampling: a seed of
+        // the whole formula renews the boxes of all components
+        epoch_components.resize(components.size());
+        std::iota(epoch_components.begin(), epoch_components.end(), 0);
+    }
+    if (chain_seeds && epochs % config.seed_chaining != 0 && chain_seed())
+        return z3::sat;
+    if (!local_search) return Sampler::find_seed();
+    // search from a perturbation of the previous seed
+    const std::vector<z3::expr>& ls_vars = local_search->get_vars();
+    std::vector<int64_t> point;
+    for (const auto& var : ls_vars) {
+        int64_t value;
+        point.push_back(model.eval(var, true).is_numeral_i64(value) ? value
+                                                                    : 0);
+    }
+    std::atomic<bool> stop{false};
+    local_search_found = false;
+    const unsigned int search_seed = g();
+    // the searcher touches no z3 object; the watchdog stops the check
+    std::thread searcher([&]() {
+        std::mt19937 search_g(search_seed);
+        LocalSearch::perturb(point, search_g);
+        if (!local_search->search(point, search_g, stop)) return;
+        local_search_found = true;
+        watchdog.cancel();
+    });
+    // joined on every way out of find_seed
+    struct SearcherJoin {
+        std::thread& searcher;
+        std::atomic<bool>& stop;
+        ~SearcherJoin() {
+            stop = true;
+            searcher.join();
+        }
+    };
+    z3::check_result res;
+    {
+        SearcherJoin join{searcher, stop};
+        res = Sampler::find_seed();
+    }
+    watchdog.resume();
+    local_search_runs++;
+    if (!local_search_found) return res;
+    local_search_seeds++;
+    z3::model seed(c);
+    for (size_t i = 0; i < ls_vars.size(); i++) {
+        z3::func_decl decl = ls_vars[i].decl();
+        z3::expr value = c.int_val(point[i]);
+        seed.add_const_interp(decl, value);
+    }
+    model = seed;
+    return z3::sat;
+}
+
+bool MEGASampler::seed_found_elsewhere() { return local_search_found; }
+
+static inline void collect_z3_names(const z3::expr& formula,
                                     std::set<std::string>& z3names_set,
                                     z3::expr_vector& z3var_vector) {
-    if (formula.is_const()) {
-        std::string const_name = formula.decl().name().str();
+    ExprWalker walker;
+    walker.walk(formula, [&](const z3::expr& e) {
+        if (!e.is_const()) return true;
+        std::string const_name = e.decl().name().str();
         if (const_name.rfind("z3name!", 0) == 0) {
             auto res = z3names_set.insert(const_name);
             if (res.second) {
-                z3var_vector.push_back(formula);
+                z3var_vector.push_back(e);
             }
         }
-    } else {
-        for (z3::expr child : formula) {
-            collect_z3_names(child, z3names_set, z3var_vector);
-        }
-    }
+        return false;
+    });
 }
 
 z3::expr MEGASampler::rename_z3_names(z3::expr& formula) {
@@ -182,10 +491,92 @@ z3::expr MEGASampler::rename_z3_names(z3::expr& formula) {
     return formula.substitute(z3_var_vector, new_vars_vector);
 }
 
+z3::expr MEGASampler::replace_uf_applications(
+    const z3::expr& e, std::unordered_map<unsigned int, z3::expr>& cache,
+    z3::expr_vector& constraints) {
+    if (!e.is_app()) return e;
+    const auto cached = cache.find(e.id());
+    if (cached != cache.end()) return cached->second;
+    z3::expr_vector args(c);
+    for (unsigned int i = 0; i < e.num_args(); i++)
+        args.push_back(replace_uf_applications(e.arg(i), cache, constraints));
+    z3::expr res = e.num_args() > 0 ? e.decl()(args) : e;
+    if (e.num_args() > 0 && e.decl().decl_kind() == Z3_OP_UNINTERPRETED) {
+        const std::string name = e.decl().name().str();
+        if (e.num_args() == 1) {
+            auto array = uf_arrays.find(name);
+            if (array == uf_arrays.end()) {
+                const std::string array_name = "mega!uf!" + name;
+                array = uf_arrays
+                            .emplace(name, c.constant(
+                                               array_name.c_str(),
+                                               c.array_sort(c.int_sort(),
+                                                            c.int_sort())))
+                            .first;
+            }
+            res = z3::select(array->second, args[0]);
+        } else {
+            auto& applications = uf_applications[name];
+            const std::string var_name =
+                "mega!uf!" + name + "!" + std::to_string(applications.size());
+            res = c.int_const(var_name.c_str());
+            // same arguments, same value
+            for (const auto& other : applications) {
+                z3::expr_vector different(c);
+                for (unsigned int i = 0; i < args.size(); i++)
+                    different.push_back(args[i] != other.args[i]);
+                different.push_back(res == other.value);
+                constraints.push_back(z3::mk_or(different));
+            }
+            applications.emplace_back(args, res);
+        }
+        uf_definitions = combine_expr(uf_definitions, e.decl()(args) == res);
+    }
+    cache.emplace(e.id(), res);
+    return res;
+}
+
+z3::expr MEGASampler::eliminate_uninterpreted_functions(
+    const z3::expr& formula) {
+    std::unordered_map<unsigned int, z3::expr> cache;
+    z3::expr_vector constraints(c);
+    constraints.push_back(replace_uf_applications(formula, cache, constraints));
+    if (debug && (!uf_arrays.empty() || !uf_applications.empty()))
+        std::cout << "uninterpreted functions as arrays: " << uf_arrays.size()
+                  << ", Ackermann constraints: " << constraints.size() - 1
+                  << "\n";
+    return z3::mk_and(constraints);
+}
+
+void MEGASampler::add_uf_tables(Model& sample) {
+    for (const auto& uf_array : uf_arrays) {
+        const auto table =
+            sample.evalArrayVarAsFunc(uf_array.second.decl().name().str());
+        if (!table.second) continue;
+        for (const auto& entry : table.first)
+            sample.addUfAssignment(uf_array.first, {entry.first}, entry.second);
+    }
+    for (const auto& uf : uf_applications) {
+        for (const auto& application : uf.second) {
+            // applications outside the implicant are not sampled
+            const auto value = sample.evalIntExpr(application.value);
+            if (!value.second) continue;
+            std::vector<int64_t> args;
+            for (const auto& arg : application.args) {
+                const auto arg_value = sample.evalIntExpr(arg);
+                if (!arg_value.second) break;
+                args.push_back(arg_value.first);
+            }
+            if (args.size() == application.args.size())
+                sample.addUfAssignment(uf.first, args, value.first);
+        }
+    }
+}
+
 void MEGASampler::simplify_formula() {
     // arith_lhs + lose select(store())
     z3::goal g(c);
-    g.add(original_formula);
+    g.add(eliminate_uninterpreted_functions(original_formula));
     z3::params simplify_params(c);
     //  simplify_params = z3::params(c);
     simplify_params.set("arith_lhs", true);           // Move all the terms of the arithmetic expression to
@@ -200,6 +591,23 @@ void MEGASampler::simplify_formula() {
         std::cout << "after arith_lhs+blast_select_store: "
                   << simp_formula.to_string() << "\n";
 
+    if (config.eliminate_equalities) {
+        bool supported = true;
+        for (const auto& v : variables)
+            supported = supported && v.arity() == 0 && !v.range().is_array();
+        if (supported) {
+            simp_formula = eliminator.eliminate(simp_formula, simplify_params);
+            std::cout << "Equality elimination: " << eliminator.size()
+                      << " variables eliminated\n";
+            if (debug)
+                std::cout << "after equality elimination: "
+                          << simp_formula.to_string() << "\n";
+        } else {
+            std::cout << "Equality elimination: not with arrays or "
+                         "uninterpreted functions\n";
+        }
+    }
+
     // nnf conversion- to make sure its nnf + get rid of ite in expr
     g = z3::goal(c);
     g.add(simp_formula);
@@ -224,39 +632,36 @@ void MEGASampler::initialize_solvers() {
     opt.add(simpl_formula);  // adds formula as hard constraint to optimization
     // solver (no weight specified for it)
     solver.add(simpl_formula);  // adds formula as constraint to normal solver
+    if (uf_definitions) {
+        opt.add(uf_definitions);
+        solver.add(uf_definitions);
+    }
+    if (config.blocking) blocking_set.start();
 }
 
-void MEGASampler::remove_or(z3::expr& formula, const z3::model& m,
+void MEGASampler::remove_or(const z3::expr& formula, const z3::model& m,
                             std::list<z3::expr>& res) {
-    if (formula.decl().decl_kind() != Z3_OP_OR &&
-        formula.decl().decl_kind() != Z3_OP_AND) {  // theoretical atom
-        res.push_front(formula);
-    } else if (formula.decl().decl_kind() == Z3_OP_OR) {  // disjunction
-        std::vector<int> satisfied_disjncts_distances;    // already satisfied disjunction sub formula
-        int i = 0;
-        for (const auto& child : formula) {
+    // a subformula shared by several conjunctions is kept once
+    ExprWalker walker;
+    walker.walk(formula, [&](const z3::expr& f) {
+        if (f.decl().decl_kind() == Z3_OP_AND) return true;
+        if (f.decl().decl_kind() != Z3_OP_OR) {  // theoretical atom
+            res.push_front(f);
+            return false;
+        }
+        // disjunction
+        std::vector<unsigned int> satisfied_disjncts_distances;    // already satisfied disjunction sub formula
+        unsigned int i = 0;
+        for (const auto& child : f) {
             if (m.eval(child, true).is_true()) {
                 satisfied_disjncts_distances.push_back(i);
             }
             i++;
         }
-        std::shuffle(satisfied_disjncts_distances.begin(),
-                     satisfied_disjncts_distances.end(), g);
-        i = *satisfied_disjncts_distances.begin();
-        int j = 0;
-        for (auto child : formula) {
-            if (j == i) {
-                remove_or(child, m, res);
-                break;
-            }
-            j++;
-        }
-    } else {
-        assert(formula.decl().decl_kind() == Z3_OP_AND);
-        for (auto child : formula) {
-            remove_or(child, m, res);
-        }
-    }
+        i = disjunct_policy->choose(f, satisfied_disjncts_distances, g);
+        walker.descend(f.arg(i));
+        return false;
+    });
 }
 
 void MEGASampler::add_opposite_array_constraint(
@@ -376,21 +781,23 @@ void MEGASampler::add_array_value_constraints(const arrayEqualityEdge& store_eq,
 }
 
 template <typename T>
-static void collect_select_terms(const z3::expr& expr, T& select_terms) {
-    if (expr.decl().decl_kind() == Z3_OP_SELECT) {
-        select_terms.insert(expr);
-    }
-    for (unsigned int i = 0; i < expr.num_args(); i++) {
-        collect_select_terms(expr.arg(i), select_terms);
-    }
+static void collect_select_terms(const z3::expr& expr, T& select_terms,
+                                 ExprWalker& walker) {
+    walker.walk(expr, [&select_terms](const z3::expr& e) {
+        if (e.decl().decl_kind() == Z3_OP_SELECT) {
+            select_terms.insert(e);
+        }
+        return true;
+    });
 }
 
 void MEGASampler::add_equalities_from_select_terms(
     std::list<z3::expr>& conjuncts) {
     std::list<z3::expr> new_conjuncts;
     std::unordered_set<z3::expr> select_terms;
+    ExprWalker walker;  // the conjuncts share subterms
     for (const auto& conj : conjuncts) {
-        collect_select_terms(conj, select_terms);
+        collect_select_terms(conj, select_terms, walker);
     }
     for (const auto& sterm : select_terms) {
         assert(sterm.decl().decl_kind() == Z3_OP_SELECT);
@@ -479,6 +886,66 @@ void MEGASampler::remove_array_equalities(std::list<z3::expr>& conjuncts,
     }
 }
 
+std::vector<unsigned int> MEGASampler::implicant_signature(
+    const std::list<z3::expr>& conjuncts) {
+    std::vector<unsigned int> signature;
+    signature.reserve(conjuncts.size());
+    for (const auto& conj : conjuncts) {
+        signature.push_back(conj.id());
+    }
+    std::sort(signature.begin(), signature.end());
+    signature.erase(std::unique(signature.begin(), signature.end()),
+                    signature.end());
+    return signature;
+}
+
+bool MEGASampler::find_cached_box(const std::vector<unsigned int>& signature,
+                                  const z3::model& m, IntervalMap& i_map) {
+    ++box_cache_lookups;
+    const auto it = box_cache.find(signature);
+    if (it == box_cache.end()) return false;
+    ++box_cache_signature_hits;
+    for (const auto& box : it->second.boxes) {
+        bool contains_seed = true;
+        for (const auto& varinterval : box) {
+            const z3::expr& var = varinterval.first;
+            int64_t value;
+            if (var.is_bool()) {
+                value = model_eval_to_bool(m, var);
+            } else if (var.is_bv()) {
+                value = bv_to_box(model_eval_to_uint64(m, var),
+                                  var.get_sort().bv_size());
+            } else {
+                value = model_eval_to_int64(m, var);
+            }
+            if (!varinterval.second.is_in_range(value)) {
+                contains_seed = false;
+                break;
+            }
+        }
+        if (contains_seed) {
+            if (debug) std::cout << "reusing cached box\n";
+            ++box_cache_reuses;
+            i_map = box;
+            return true;
+        }
+    }
+    return false;
+}
+
+void MEGASampler::cache_box(const std::vector<unsigned int>& signature,
+                            const std::list<z3::expr>& conjuncts,
+                            const IntervalMap& i_map) {
+    auto it = box_cache.find(signature);
+    if (it == box_cache.end()) {
+        if (box_cache.size() >= MAX_CACHED_SIGNATURES) return;
+        it = box_cache.emplace(signature, CachedBoxes{conjuncts, {}}).first;
+    }
+    std::list<IntervalMap>& boxes = it->second.boxes;
+    if (boxes.size() >= MAX_BOXES_PER_SIGNATURE) boxes.pop_front();
+    boxes.push_back(i_map);
+}
+
 bool MEGASampler::has_unbounded_selects(const IntervalMap& intervalmap) {
     for (const auto& select_t : intervals_select_terms) {
         //    std::cout << "parsing: " << select_t.to_string() << "\n";
@@ -511,8 +978,37 @@ bool MEGASampler::has_unbounded_selects(const IntervalMap& intervalmap) {
 void MEGASampler::do_epoch(const z3::model& m) {
     is_time_limit_reached();
 
-    set_timer_on("grow_seed");
+    // remove_or picks a random satisfied disjunct of every disjunction, so
+    // asking again may give another implicant of the same seed
+    std::set<std::vector<unsigned int>> seen_implicants;
+    // components without a box yet are strengthened from any seed
+    for (size_t k = 0; k < components.size(); k++) {
+        if (components[k].boxes.empty() &&
+            std::find(epoch_components.begin(), epoch_components.end(), k) ==
+                epoch_components.end())
+            epoch_components.push_back(k);
+    }
+    for (unsigned long k = 0; k < config.implicants; k++) {
+        set_timer_on("grow_seed");
+        std::list<z3::expr> implicant_conjuncts_list;
+        compute_implicant(m, implicant_conjuncts_list);
+        if (config.implicants > 1 &&
+            !seen_implicants
+                 .insert(implicant_signature(implicant_conjuncts_list))
+                 .second) {
+            ++duplicate_implicants;
+            disjunct_policy->discard();
+            accumulate_time("grow_seed");
+            continue;
+        }
+        if (k > 0) ++extra_implicants;
+        sample_implicant(m, implicant_conjuncts_list);
+        if (is_time_limit_reached("epoch")) return;
+    }
+}
 
+void MEGASampler::sample_implicant(
+    const z3::model& m, std::list<z3::expr>& implicant_conjuncts_list) {
     // set all edges of array_eq_graph as non-valid (not in implicant) and empty
     // the index_values vector
     for (auto& entry : arrayEqualityGraph) {
@@ -524,9 +1020,6 @@ void MEGASampler::do_epoch(const z3::model& m) {
 
     if (debug) std::cout << "model is: " << m.to_string() << "\n";
 
-    // compute m-implicant
-    std::list<z3::expr> implicant_conjuncts_list;
-    remove_or(simpl_formula, m, implicant_conjuncts_list);
     if (debug) {
         std::cout << "after remove or: ";
         for (const auto& conj : implicant_conjuncts_list) {
@@ -536,6 +1029,10 @@ void MEGASampler::do_epoch(const z3::model& m) {
         std::cout << "\n";
     }
 
+    IntervalMap i_map;
+    region.reset();
+    r_map.clear();
+    ++sampled_boxes;
     remove_array_equalities(implicant_conjuncts_list, config.debug);
     if (debug) {
         std::cout << "after remove array equalities: ";
@@ -546,30 +1043,45 @@ void MEGASampler::do_epoch(const z3::model& m) {
         std::cout << "\n";
     }
 
-    bool debug_rules = false;
-    Strengthener s(c, model, debug_rules);
-    for (const auto& conj : implicant_conjuncts_list) {
-        s.strengthen_literal(conj);
+    std::vector<unsigned int> signature;
+    if (config.box_cache)
+        signature = implicant_signature(implicant_conjuncts_list);
+    if (!config.box_cache || !find_cached_box(signature, m, i_map)) {
+        i_map = strengthen(implicant_conjuncts_list);
+        if (config.json && config.strengthen_engine == MeGA::STRENGTHEN_VOLUME) {
+            accumulate_time("grow_seed");
+            set_timer_on("compare_strengthening");
+            compare_with_legacy_box(implicant_conjuncts_list, i_map);
+            accumulate_time("compare_strengthening");
+            set_timer_on("grow_seed");
+        }
+        add_bool_intervals(implicant_conjuncts_list, m, i_map);
+        add_bv_domains(i_map);
+        // the bounding box of a region is not sound for the implicant, and
+        // cached boxes have no real bounds
+        if (config.box_cache && !region && r_map.empty())
+            cache_box(signature, implicant_conjuncts_list, i_map);
     }
-    if (debug) s.print_interval_map();
+    if (!components.empty()) combine_component_boxes(i_map);
 
     accumulate_time("grow_seed");
 
     if (config.interval_size) {
         if (debug) std::cout << "documenting interval size: ";
         int64_t i_size;
-        bool is_finite = intervals_size(s.i_map, i_size);
+        bool is_finite = intervals_size(i_map, i_size);
         if (!is_finite) {
             if (debug) std::cout << "infinite\n";
             num_infinite_intervals++;
         } else {
             if (debug) std::cout << i_size << "\n";
-            average_interval_size += (i_size - average_interval_size) / epochs;
+            average_interval_size +=
+                (i_size - average_interval_size) / sampled_boxes;
         }
     }
 
     intervals_select_terms.clear();
-    for (const auto& varinterval : s.i_map) {
+    for (const auto& varinterval : i_map) {
         const z3::expr& var = varinterval.first;
         if (is_op_select(get_op(var))) {
             intervals_select_terms.push_back(var);
@@ -593,27 +1105,256 @@ void MEGASampler::do_epoch(const z3::model& m) {
     if (config.interval_size) {
         if (debug) std::cout << "documenting interval size: ";
         int64_t i_size = -1;
-        bool are_intervals_finite = intervals_size(s.i_map, i_size);
+        bool are_intervals_finite = intervals_size(i_map, i_size);
         assert(i_size > 0);
-        bool unbounded_selects = has_unbounded_selects(s.i_map);
+        bool unbounded_selects = has_unbounded_selects(i_map);
         if (!are_intervals_finite || unbounded_selects) {
             if (debug) std::cout << "infinite\n";
             num_infinite_intervals++;
         } else {
             if (debug) std::cout << i_size << "\n";
-            average_interval_size += (i_size - average_interval_size) / epochs;
+            average_interval_size +=
+                (i_size - average_interval_size) / sampled_boxes;
         }
     }
 
-    if (config.blocking) add_blocking_constraint_from_intervals(s.i_map);
+    if (config.blocking) add_blocking_constraint_from_intervals(i_map);
+
+    sample_from_registry = false;
+    if (config.volume_weighted && !region && r_map.empty() &&
+        !has_unbounded_selects(i_map)) {
+        box_registry.add(i_map, intervals_select_terms);
+        sample_from_registry = !box_registry.empty();
+    }
+
+    if (is_time_limit_reached("epoch")) {
+        disjunct_policy->discard();
+        return;
+    }
+
+    const uint64_t unique_samples = sample_intervals_in_rounds(i_map);
+    disjunct_policy->reward(intervals_log2_volume(i_map), unique_samples);
+}
+
+void MEGASampler::add_bool_intervals(const std::list<z3::expr>& conjuncts,
+                                     const z3::model& m, IntervalMap& i_map) {
+    std::unordered_set<unsigned int> visited;
+    std::vector<z3::expr> stack(conjuncts.begin(), conjuncts.end());
+    while (!stack.empty()) {
+        const z3::expr e = stack.back();
+        stack.pop_back();
+        if (!e.is_app() || !visited.insert(e.id()).second) continue;
+        if (e.is_const() && e.is_bool() &&
+            e.decl().decl_kind() == Z3_OP_UNINTERPRETED) {
+            const int64_t value = model_eval_to_bool(m, e);
+            i_map[e] = Interval(value, value);
+            continue;
+        }
+        for (unsigned int i = 0; i < e.num_args(); i++) stack.push_back(e.arg(i));
+    }
+    // the implicant holds whatever value the other bools take
+    for (const auto& v : variables) {
+        if (v.arity() > 0 || !v.range().is_bool()) continue;
+        const z3::expr var = v();
+        if (i_map.find(var) == i_map.end()) i_map[var] = Interval(0, 1);
+    }
+}
+
+void MEGASampler::add_bv_domains(IntervalMap& i_map) {
+    for (const auto& v : variables) {
+        if (v.arity() > 0 || !v.range().is_bv()) continue;
+        const z3::expr var = v();
+        if (i_map.find(var) != i_map.end()) continue;
+        const unsigned int width = v.range().bv_size();
+        const uint64_t max = width == 64 ? UINT64_MAX : (1ULL << width) - 1;
+        i_map[var] = Interval(bv_to_box(0, width), bv_to_box(max, width));
+    }
+}
+
+template <typename S>
+void MEGASampler::strengthen_or_pin(S& s, const z3::expr& literal) {
+    std::string rule;
+    try {
+        s.strengthen_literal(literal);
+        return;
+    } catch (const Strengthener::NoRuleForStrengthening& e) {
+        if (!config.graceful_strengthening) throw;
+        rule = e.rule;
+    } catch (const UnsupportedOperator&) {
+        if (!config.graceful_strengthening) throw;
+        rule = "unsupported operator";
+    }
+    if (debug)
+        std::cout << "no rule (" << rule << ") for " << literal.to_string()
+                  << ", pinning it\n";
+    // sound: the bounds added before the throw all contain the seed
+    s.pin_literal(literal);
+    pinned_literals++;
+    missing_rules[rule]++;
+}
 
-    if (is_time_limit_reached("epoch")) return;
+IntervalMap MEGASampler::strengthen(const std::list<z3::expr>& conjuncts) {
+    bool debug_rules = false;
+    if (config.strengthen_engine == MeGA::STRENGTHEN_VOLUME) {
+        VolumeStrengthener s(c, model, debug_rules);
+        for (const auto& conj : conjuncts) {
+            strengthen_or_pin(s, conj);
+        }
+        s.compute_box();
+        if (debug) s.print_interval_map();
+        ite_rewrites += s.get_ite_rewrites();
+        r_map = std::move(s.r_map);
+        return std::move(s.i_map);
+    }
+    if (config.strengthen_engine == MeGA::STRENGTHEN_OCTAGON) {
+        OctagonStrengthener s(c, model, debug_rules);
+        for (const auto& conj : conjuncts) {
+            strengthen_or_pin(s, conj);
+        }
+        s.compute_octagon();
+        if (debug) s.print_interval_map();
+        ite_rewrites += s.get_ite_rewrites();
+        // without relational constraints the octagon is just the box
+        if (s.octagon.num_relational() > 0) {
+            region_epochs++;
+            region_constraints += s.octagon.num_relational();
+            region = std::make_unique<Octagon>(std::move(s.octagon));
+        }
+        r_map = std::move(s.r_map);
+        return std::move(s.i_map);
+    }
+    if (config.strengthen_engine == MeGA::STRENGTHEN_POLYTOPE) {
+        PolytopeStrengthener s(c, model, debug_rules);
+        for (const auto& conj : conjuncts) {
+            strengthen_or_pin(s, conj);
+        }
+        s.compute_polytope();
+        if (debug) s.print_interval_map();
+        ite_rewrites += s.get_ite_rewrites();
+        if (s.polytope.num_rows() > 0) {
+            region_epochs++;
+            region_constraints += s.polytope.num_rows();
+            region = std::make_unique<Polytope>(std::move(s.polytope));
+        }
+        r_map = std::move(s.r_map);
+        return std::move(s.i_map);
+    }
+    Strengthener s(c, model, debug_rules);
+    for (const auto& conj : conjuncts) {
+        strengthen_or_pin(s, conj);
+    }
+    if (debug) s.print_interval_map();
+    ite_rewrites += s.ite_rewrites;
+    r_map = std::move(s.r_map);
+    return std::move(s.i_map);
+}
 
-    sample_intervals_in_rounds(s.i_map);
+void MEGASampler::compare_with_legacy_box(
+    const std::list<z3::expr>& conjuncts, const IntervalMap& i_map) {
+    Strengthener s(c, model, false);
+    try {
+        for (const auto& conj : conjuncts) {
+            s.strengthen_literal(conj);
+        }
+    } catch (const Strengthener::NoRuleForStrengthening&) {
+        return;  // the legacy rules have no box to compare with
+    } catch (const UnsupportedOperator&) {
+        return;  // pinned by strengthen_or_pin, no legacy box either
+    }
+    const double log2_volume = intervals_log2_volume(i_map);
+    const double legacy_log2_volume = intervals_log2_volume(s.i_map);
+    compared_boxes++;
+    if (log2_volume > legacy_log2_volume) larger_boxes++;
+    total_log2_volume += log2_volume;
+    total_legacy_log2_volume += legacy_log2_volume;
 }
 
 void MEGASampler::finish() {
     json_output["method name"] = "megasampler";
+    if (config.json && config.strengthen_engine == MeGA::STRENGTHEN_VOLUME) {
+        Json::Value& stats = json_output["strengthening"];
+        stats["engine"] = "volume";
+        stats["compared boxes"] = (Json::UInt64)compared_boxes;
+        stats["larger than legacy"] = (Json::UInt64)larger_boxes;
+        if (compared_boxes > 0) {
+            stats["average log2 volume"] = total_log2_volume / compared_boxes;
+            stats["average legacy log2 volume"] =
+                total_legacy_log2_volume / compared_boxes;
+            stats["average log2 volume gain"] =
+                (total_log2_volume - total_legacy_log2_volume) / compared_boxes;
+        }
+    }
+    if (config.json && config.strengthen_engine == MeGA::STRENGTHEN_OCTAGON) {
+        Json::Value& stats = json_output["octagon"];
+        stats["epochs"] = (Json::UInt64)region_epochs;
+        stats["average relational constraints"] =
+            region_epochs ? (double)region_constraints / region_epochs : 0.0;
+        stats["draws"] = (Json::UInt64)region_draws;
+        stats["dead ends"] = (Json::UInt64)region_rejections;
+    }
+    if (config.json && config.strengthen_engine == MeGA::STRENGTHEN_POLYTOPE) {
+        Json::Value& stats = json_output["polytope"];
+        stats["epochs"] = (Json::UInt64)region_epochs;
+        stats["average rows"] =
+            region_epochs ? (double)region_constraints / region_epochs : 0.0;
+        stats["walk steps"] = (Json::UInt64)region_draws;
+    }
+    if (config.json) {
+        json_output["epoch scheduler"] = scheduler->to_json();
+        json_output["ite rewrites"] = (Json::UInt64)ite_rewrites;
+        json_output["pinned literals"] = (Json::UInt64)pinned_literals;
+        Json::Value& rules = json_output["missing rules"];
+        rules = Json::objectValue;
+        for (const auto& rule : missing_rules)
+            rules[rule.first] = (Json::UInt64)rule.second;
+    }
+    if (config.box_cache) {
+        json_output["box cache"]["lookups"] = (Json::UInt64)box_cache_lookups;
+        json_output["box cache"]["signature hits"] =
+            (Json::UInt64)box_cache_signature_hits;
+        json_output["box cache"]["reused boxes"] =
+            (Json::UInt64)box_cache_reuses;
+        json_output["box cache"]["hit rate"] =
+            box_cache_lookups ? (double)box_cache_reuses / box_cache_lookups
+                              : 0.0;
+    }
+    if (config.volume_weighted) {
+        json_output["box registry"]["boxes"] = (Json::UInt64)box_registry.size();
+        json_output["box registry"]["total volume"] =
+            (double)box_registry.get_total_volume();
+        json_output["box registry"]["overlap rejections"] =
+            (Json::UInt64)box_registry.get_rejected();
+    }
+    if (config.blocking) json_output["blocking"] = blocking_set.to_json();
+    if (config.eliminate_equalities)
+        json_output["eliminated variables"] = (Json::UInt64)eliminator.size();
+    if (!components.empty()) {
+        for (const auto& component : components) {
+            Json::Value stats;
+            stats["variables"] = (Json::UInt64)component.variables.size();
+            stats["seeds"] = (Json::UInt64)component.seeds;
+            json_output["components"].append(stats);
+        }
+    }
+    if (config.disjunct_policy != MeGA::DISJUNCT_POLICY_UNIFORM)
+        json_output["disjunct policy"] = disjunct_policy->to_json();
+    if (config.implicants > 1) {
+        json_output["implicants"]["extra boxes"] =
+            (Json::UInt64)extra_implicants;
+        json_output["implicants"]["duplicates"] =
+            (Json::UInt64)duplicate_implicants;
+    }
+    if (chain_seeds) {
+        json_output["seed chaining"]["chained seeds"] =
+            (Json::UInt64)chained_seeds;
+        json_output["seed chaining"]["rejected seeds"] =
+            (Json::UInt64)chain_rejections;
+    }
+    if (local_search) {
+        json_output["local search"]["runs"] = (Json::UInt64)local_search_runs;
+        json_output["local search"]["seeds"] =
+            (Json::UInt64)local_search_seeds;
+    }
     if (config.interval_size) {
         json_output["inifnite intervals"] = num_infinite_intervals;
         json_output["average interval size"] = (Json::Int64)average_interval_size;
@@ -621,48 +1362,52 @@ void MEGASampler::finish() {
     Sampler::finish();
 }
 
-/* Computes the base-2 logarithm of an unsigned 64-bit integer. */
-static inline uint64_t ilog2(const uint64_t x) {
-    if (0 == x) return 1;  // undefined but useful for me here
-    return (63 - __builtin_clzll(x));
-}
-
-/**
- * If the multiplication does not overflow,
- * the result of the product is returned.
- * If the multiplication overflows,
- * the function returns a value indicating an integer overflow.
- * If the result of the multiplication is positive,
- * INT64_MAX is returned, otherwise INT64_MIN is returned.
- */
-static inline int64_t safe_mul(const int64_t a, const int64_t b) {
-    int64_t ret;
-    if (!__builtin_mul_overflow(a, b, &ret)) return ret;
-    return ((a > 0) ^ (b > 0)) ? INT64_MIN : INT64_MAX;
-}
-
 bool MEGASampler::get_random_sample_from_intervals(
-    const IntervalMap& intervalmap, Model& m_out) {
+    const IntervalMap& intervalmap, const std::list<z3::expr>& select_terms,
+    Model& m_out, Region* region) {
     bool valid_model = true;
+    if (region) {
+        std::vector<int64_t> point;
+        region_draws++;
+        if (!region->sample(g, point)) {
+            region_rejections++;
+            return false;
+        }
+        const auto& vars = region->get_vars();
+        for (unsigned int i = 0; i < vars.size(); i++) {
+#ifndef NDEBUG
+            bool res =
+#endif
+                m_out.addIntAssignment(vars[i].to_string(), point[i]);
+            assert(res);
+        }
+    }
     for (const auto& varinterval : intervalmap) {
         const z3::expr& var = varinterval.first;
-        if (var.is_const()) {
+        if (var.is_const() && !(region && region->contains(var))) {
             const Interval& interval = varinterval.second;
+            // a variable pinned to a value that doesn't fit in int64
+            if (interval.is_bottom()) return false;
             const std::string& varname = var.to_string();
             int64_t rand = interval.random_in_range();
+            const unsigned int width = var.is_bv() ? var.get_sort().bv_size() : 0;
 #ifndef NDEBUG
             bool res =
 #endif
-                m_out.addIntAssignment(varname, rand);
+                var.is_bool() ? m_out.addBoolAssignment(varname, rand != 0)
+                : var.is_bv()
+                    ? m_out.addBvAssignment(varname, bv_from_box(rand, width),
+                                            width)
+                    : m_out.addIntAssignment(varname, rand);
             assert(res);
         }
     }
-    for (const auto& select_t : intervals_select_terms) {
+    for (const auto& select_t : select_terms) {
         assert(is_op_select(get_op(select_t)));
         int64_t i_val;
         z3::expr index_expr = select_t.arg(1);
         auto index_res = m_out.evalIntExpr(index_expr, false, true);
-        assert(index_res.second);
+        if (!index_res.second) return false;  // the index overflows int64
         i_val = index_res.first;  // index value
         assert(select_t.arg(0).is_const());
         std::string array_name = select_t.arg(0).to_string();
@@ -672,6 +1417,7 @@ bool MEGASampler::get_random_sample_from_intervals(
             if (!valid_model) break;
         } else {  // array[index] is unassigned
             const auto& interval = intervalmap.at(select_t);
+            if (interval.is_bottom()) return false;
             int64_t rand = interval.random_in_range();
             m_out.addArrayAssignment(array_name, i_val, rand);
         }
@@ -679,80 +1425,180 @@ bool MEGASampler::get_random_sample_from_intervals(
     return valid_model;
 }
 
-static inline z3::expr combine_expr(const z3::expr& base, const z3::expr& arg) {
-    if (base) return base && arg;
-    return arg;
+bool MEGASampler::get_random_sample_from_real_intervals(
+    const RealIntervalMap& real_intervals, Model& m_out) {
+    for (const auto& varinterval : real_intervals) {
+        Rational rand;
+        if (!varinterval.second.random_in_range(g, rand)) return false;
+#ifndef NDEBUG
+        bool res =
+#endif
+            m_out.addRealAssignment(varinterval.first.to_string(), rand);
+        assert(res);
+    }
+    return true;
+}
+
+double MEGASampler::average_seed_cost() {
+    if (epochs == 0) return 0.0;
+    double seed_time = 0.0;
+    for (const auto& category : {"start_epoch", "grow_seed"}) {
+        const auto it = accumulated_times.find(category);
+        if (it != accumulated_times.end()) seed_time += it->second;
+    }
+    return seed_time / epochs;
 }
 
 /**
- *Sample from a given set of intervals
- *and control the number of rounds and rate of sampling
- *according to specified conditions
+ *Sample from a given set of intervals, rounds of MAX_SAMPLES draws at a
+ *time, for as long as the epoch scheduler decides it is worth it
  */
-void MEGASampler::sample_intervals_in_rounds(const IntervalMap& intervalmap) {
-    uint64_t coeff = 1;
-    for (const auto& imap : intervalmap) {
-        const auto& i = imap.second;
-        if (i.is_low_minf() || i.is_high_inf()) {
-            coeff *= 4;
-            continue;
-        }
-        coeff =
-            safe_mul(coeff, 1 + ilog2(1 + ilog2(1 + i.get_high() - i.get_low())));
-    }
-    if (config.blocking) coeff = coeff + intervalmap.size();
-    const uint64_t MAX_ROUNDS =
-        std::min(std::max(config.num_rounds, coeff), config.max_samples >> 7UL);  //
+uint64_t MEGASampler::sample_intervals_in_rounds(
+    const IntervalMap& intervalmap) {
     const unsigned long MAX_SAMPLES = 100;
-    uint64_t debug_samples = 0;
+    uint64_t box_samples = 0;
 
+    scheduler->start_box(intervalmap, average_seed_cost());
     if (debug)
-        std::cout << "Sampling, coeff = " << coeff
-                  << ", MAX_ROUNDS = " << MAX_ROUNDS
+        std::cout << "Sampling, policy = " << scheduler->name()
                   << ", MAX_SAMPLES = " << MAX_SAMPLES << "\n";
 
-    double rate = 1.0;
-    for (uint64_t round = 0;
-         config.exhaust_epoch || (round < MAX_ROUNDS && rate > config.min_rate);
-         ++round) {  // conducting multiple rounds of sampling
+    while (config.exhaust_epoch || scheduler->continue_box()) {  // conducting multiple rounds of sampling
         is_time_limit_reached();
-        if (epoch_samples >= config.max_epoch_samples) break;
+        if (epoch_samples >= config.max_epoch_samples) {
+            scheduler->stop_reason = "max epoch samples";
+            break;
+        }
+        struct timespec round_start;
+        clock_gettime(CLOCK_REALTIME, &round_start);
         unsigned int new_samples = 0;
         unsigned int round_samples = 0;
         for (; round_samples <= MAX_SAMPLES; ++round_samples) {  // 100 samples in a single round
             ++total_samples;
-            Model m_out(variable_names);
-            bool valid_model = get_random_sample_from_intervals(intervalmap, m_out);
+            Model m_out(sample_names);
+            bool valid_model;
+            const IntervalMap* box_intervals = &intervalmap;
+            if (sample_from_registry) {
+                const auto& box = box_registry.choose(g);
+                box_intervals = &box.i_map;
+                valid_model = get_random_sample_from_intervals(
+                                  box.i_map, box.select_terms, m_out) &&
+                              box_registry.accept(m_out, g);
+            } else {
+                valid_model =
+                    get_random_sample_from_intervals(
+                        intervalmap, intervals_select_terms, m_out,
+                        region.get()) &&
+                    get_random_sample_from_real_intervals(r_map, m_out);
+            }
+            // an eliminated variable may overflow
+            valid_model = valid_model && eliminator.reconstruct(m_out);
             if (valid_model) {
+                add_uf_tables(m_out);
                 if (save_and_output_sample_if_unique(m_out.toString())) {
-                    if (debug) ++debug_samples;
+                    ++box_samples;
                     ++new_samples;
+                    if (chain_seeds) keep_chain_seed(m_out, *box_intervals);
                 }
             }
         }
-        rate = (double)new_samples / round_samples;  // proportion of new samples in the current round of sampling
+        scheduler->end_round(new_samples, round_samples,
+                             elapsed_time_from(round_start));
     }
+    if (config.json) scheduler->end_box(epochs);
     if (debug)
-        std::cout << "Epoch unique samples: " << debug_samples
-                  << ", rate = " << rate << "\n";
+        std::cout << "Epoch unique samples: " << box_samples
+                  << ", stopped: " << scheduler->stop_reason << "\n";
+    return box_samples;
+}
+
+void MEGASampler::keep_chain_seed(Model sample,
+                                  const IntervalMap& intervalmap) {
+    bool on_boundary = false;
+    for (const auto& var_interval : intervalmap) {
+        const z3::expr& var = var_interval.first;
+        if (!var.is_int() || !var.is_const()) continue;
+        const auto value = sample.evalIntVar(var.to_string());
+        if (value.second && (value.first == var_interval.second.get_low() ||
+                             value.first == var_interval.second.get_high())) {
+            on_boundary = true;
+            break;
+        }
+    }
+    auto& pool = on_boundary ? chain_boundary_pool : chain_pool;
+    if (pool.size() >= CHAIN_POOL_SIZE) pool.pop_front();
+    pool.push_back(std::move(sample));
+}
+
+bool MEGASampler::chain_seed() {
+    auto& pool =
+        chain_boundary_pool.empty() ? chain_pool : chain_boundary_pool;
+    if (pool.empty()) return false;
+    const auto chosen = std::next(pool.begin(), g() % pool.size());
+    Model sample = *chosen;
+    pool.erase(chosen);  // every sample seeds once
+    z3::model seed(c);
+    for (const auto& v : variables) {
+        const std::string name = v.name().str();
+        z3::expr value(c);
+        if (v.range().is_bool()) {
+            const auto b = sample.evalBoolVar(name);
+            if (b.second) value = c.bool_val(b.first);
+        } else if (v.range().is_bv()) {
+            const auto bv = sample.evalBvVar(name);
+            if (bv.second) value = c.bv_val(bv.first, v.range().bv_size());
+        } else if (v.range().is_real()) {
+            const auto r = sample.evalRealVar(name);
+            if (r.second) value = c.real_val(r.first.to_string().c_str());
+        } else {
+            const auto i = sample.evalIntVar(name);
+            if (i.second) value = c.int_val(i.first);
+        }
+        if (!bool(value)) continue;  // model completion picks a value
+        z3::func_decl decl = v;
+        seed.add_const_interp(decl, value);
+    }
+    if (!seed.eval(simpl_formula, true).is_true()) {
+        chain_rejections++;
+        return false;
+    }
+    model = seed;
+    chained_seeds++;
+    return true;
 }
 
 void MEGASampler::add_blocking_constraint_from_intervals(
     const IntervalMap& intervalmap) {
+    // the bounds of the variables the box doesn't cover
     z3::expr intervals_expr(c);
-    for (const auto& var_interval : intervalmap) {
+    for (const auto& var_interval : r_map) {
         const z3::expr& var = var_interval.first;
-        const Interval& interval = var_interval.second;
+        const RealInterval& interval = var_interval.second;
         if (!interval.is_low_minf()) {
-            const auto low = c.int_val(interval.get_low());
-            intervals_expr = combine_expr(intervals_expr, var >= low);
+            const auto low =
+                c.real_val(interval.get_low().to_string().c_str());
+            intervals_expr = combine_expr(
+                intervals_expr, interval.is_low_strict() ? var > low : var >= low);
         }
         if (!interval.is_high_inf()) {
-            const auto high = c.int_val(interval.get_high());
-            intervals_expr = combine_expr(intervals_expr, var <= high);
+            const auto high =
+                c.real_val(interval.get_high().to_string().c_str());
+            intervals_expr =
+                combine_expr(intervals_expr,
+                             interval.is_high_strict() ? var < high : var <= high);
         }
     }
+    if (region)
+        intervals_expr = combine_expr(intervals_expr, region->to_expr(c));
+    blocking_set.add(intervalmap, intervals_expr);
     if (debug)
-        std::cout << "blocking constraint: " << intervals_expr.to_string() << "\n";
-    solver.add(!intervals_expr);  // add as *HARD* constraint
+        std::cout << "blocking clauses: " << blocking_set.size() << "\n";
+}
+
+z3::expr_vector MEGASampler::solver_assumptions() {
+    return blocking_set.assumptions();
+}
+
+bool MEGASampler::retract_blocking_constraints() {
+    return blocking_set.retire_core();
 }
@@ -1,13 +1,26 @@
 #ifndef MEGASAMPLER_H_
 #define MEGASAMPLER_H_
 
+#include <atomic>
 #include <list>
+#include <memory>
 #include <random>
 #include <set>
+#include <thread>
+#include <unordered_map>
 
+#include "blocking_set.h"
+#include "box_registry.h"
+#include "disjunct_policy.h"
+#include "epoch_scheduler.h"
+#include "equality_eliminator.h"
+#include "local_search.h"
 #include "model.h"
+#include "octagon.h"
+#include "polytope.h"
 #include "sampler.h"
 #include "strengthener.h"
+#include "volume_strengthener.h"
 #include "z3_utils.h"
 
 class MEGASampler : public Sampler {
@@ -17,6 +30,131 @@ class MEGASampler : public Sampler {
     std::list<z3::expr> intervals_select_terms; // array function "select" items
     int num_infinite_intervals = 0;
     long double average_interval_size = 0.0;
+    unsigned long sampled_boxes = 0;  // several per epoch with --implicants
+    std::unique_ptr<EpochScheduler> scheduler;  // when to abandon a box
+    std::unique_ptr<DisjunctPolicy> disjunct_policy;  // for remove_or
+    /* boxes of all epochs, for volume-weighted sampling */
+    static constexpr size_t MAX_REGISTERED_BOXES = 256;
+    BoxRegistry box_registry{MAX_REGISTERED_BOXES};
+    bool sample_from_registry = false;
+
+    /* guarded blocking clauses of MeGAb */
+    static constexpr size_t MAX_BLOCKING_CLAUSES = 256;
+    BlockingSet blocking_set{c, solver, MAX_BLOCKING_CLAUSES};
+
+    /*
+     * boxes found for each implicant signature (sorted literal ids), with
+     * the literals, which keeps z3 from reusing their ids
+     */
+    static constexpr size_t MAX_CACHED_SIGNATURES = 4096;
+    static constexpr size_t MAX_BOXES_PER_SIGNATURE = 8;
+    struct CachedBoxes {
+        std::list<z3::expr> literals;
+        std::list<IntervalMap> boxes;
+    };
+    std::map<std::vector<unsigned int>, CachedBoxes> box_cache;
+    unsigned long box_cache_lookups = 0;
+    unsigned long box_cache_signature_hits = 0;
+    unsigned long box_cache_reuses = 0;
+
+    unsigned long ite_rewrites = 0;  // literals strengthened through an ite
+    /* literals no rule could strengthen, pinned to the seed instead */
+    unsigned long pinned_literals = 0;
+    std::map<std::string, unsigned long> missing_rules;
+
+    /* log2 box volumes of --strengthen=volume against the legacy rules */
+    unsigned long compared_boxes = 0;
+    unsigned long larger_boxes = 0;
+    double total_log2_volume = 0.0;
+    double total_legacy_log2_volume = 0.0;
+
+    /* region of the epoch, with --strengthen=octagon/polytope */
+    std::unique_ptr<Region> region;
+    unsigned long region_epochs = 0;
+    unsigned long region_constraints = 0;  // relational ones, or rows
+    unsigned long region_draws = 0;
+    unsigned long region_rejections = 0;
+
+    /*
+     * Uninterpreted functions, all from Int to Int: a unary function becomes
+     * a fresh array, whose select terms stay consistent like those of any
+     * array. The applications of the others become fresh Int variables with
+     * Ackermann constraints.
+     */
+    struct UfApplication {
+        z3::expr_vector args;
+        z3::expr value;  // the fresh variable
+        UfApplication(const z3::expr_vector& _args, const z3::expr& _value)
+            : args(_args), value(_value) {}
+    };
+    std::map<std::string, z3::expr> uf_arrays;
+    std::map<std::string, std::vector<UfApplication>> uf_applications;
+    // f(args) = fresh term, so the seeds interpret the functions
+    z3::expr uf_definitions;
+    std::vector<std::string> sample_names;  // variable_names and the functions
+
+    /*
+     * Native local search for the seeds of linear integer formulas
+     * (--local-search, without blocking), raced against z3: whichever finds
+     * a seed first interrupts the other.
+     */
+    std::unique_ptr<LocalSearch> local_search;
+    std::atomic<bool> local_search_found{false};
+    unsigned long local_search_runs = 0;
+    unsigned long local_search_seeds = 0;
+
+    /*
+     * Recent samples, the seeds of the epochs that don't solve with
+     * --seed-chaining. Samples on the boundary of their box are preferred:
+     * they are the likeliest to have another implicant.
+     */
+    static constexpr size_t CHAIN_POOL_SIZE = 64;
+    bool chain_seeds = false;  // not with arrays or uninterpreted functions
+    std::list<Model> chain_pool;
+    std::list<Model> chain_boundary_pool;
+    unsigned long chained_seeds = 0;
+    unsigned long chain_rejections = 0;  // didn't satisfy simpl_formula
+
+    /*
+     * With --implicants, the boxes of the implicants after the first of
+     * their seed, and the draws that repeated an implicant of the seed.
+     */
+    unsigned long extra_implicants = 0;
+    unsigned long duplicate_implicants = 0;
+
+    /*
+     * With --decompose, the top-level conjuncts of simpl_formula grouped by
+     * shared variables. The first epoch strengthens every component; each
+     * later one solves a single component, in turn, with a solver of its
+     * own, and strengthens it. The box of the epoch combines that box with a
+     * recent box of every other component.
+     */
+    struct ComponentBox {
+        IntervalMap i_map;
+        RealIntervalMap r_map;
+    };
+    struct Component {
+        z3::expr formula;
+        std::vector<z3::func_decl> variables;
+        z3::solver solver;
+        std::list<ComponentBox> boxes;  // the most recent ones
+        unsigned long seeds = 0;
+        explicit Component(z3::context& c) : formula(c), solver(c) {}
+    };
+    static constexpr size_t BOXES_PER_COMPONENT = 16;
+    std::vector<Component> components;  // none unless decomposed
+    std::unordered_map<unsigned int, size_t> component_of;  // by variable id
+    size_t next_component = 0;
+    std::vector<size_t> epoch_components;  // strengthened in this epoch
+
+    /*
+     * With --eliminate-equalities, the variables that simpl_formula no
+     * longer has, and their definitions over the others.
+     */
+    EqualityEliminator eliminator;
+
+    /* bounds of the Real variables of the epoch's box */
+    RealIntervalMap r_map;
 
     /* for randomness */
     std::random_device rd;
@@ -91,6 +229,11 @@ class MEGASampler : public Sampler {
     initialize_solvers();                  // for MEGA, solve simpl_formula, not original_formula
     void add_blocking_soft_constraints() { /* do nothing */
     }
+    z3::check_result find_seed();
+    bool seed_found_elsewhere();
+    z3::expr_vector solver_assumptions();
+    /* retires the blocking clauses of the unsat core */
+    bool retract_blocking_constraints();
 
    private:
     /*
@@ -103,21 +246,75 @@ class MEGASampler : public Sampler {
      * entry aux_a->(a,b) is inserted to aux_array_map.
      */
     void eliminate_eq_of_different_arrays();
+    /*
+     * Strengthens an implicant of the seed m into a box (and region) and
+     * samples it.
+     */
+    void sample_implicant(const z3::model& m,
+                          std::list<z3::expr>& implicant_conjuncts_list);
+    /* groups the conjuncts of simpl_formula into components, for --decompose */
+    void decompose_formula();
+    /*
+     * Solves the next component for new values of its variables, and puts
+     * them in model with the values of the other components unchanged.
+     */
+    z3::check_result find_component_seed();
+    /* a model of simpl_formula, without the eliminated variables */
+    z3::check_result find_reduced_seed();
+    /* the implicant of simpl_formula, or of the components of the epoch */
+    void compute_implicant(const z3::model& m, std::list<z3::expr>& conjuncts);
+    /*
+     * Keeps the boxes of the components of the epoch, and adds to i_map and
+     * r_map a recent box of every other component.
+     */
+    void combine_component_boxes(IntervalMap& i_map);
     /**
-     * multiple rounds of sampling over the intervals
+     * multiple rounds of sampling over the intervals, returns the number of
+     * new unique samples
      * */
-    void sample_intervals_in_rounds(const IntervalMap& intervalmap);
+    uint64_t sample_intervals_in_rounds(const IntervalMap& intervalmap);
+    /*
+     * Average time spent to get a box so far (seed solving + strengthening).
+     */
+    double average_seed_cost();
     /**
-     * random sampling within the intervals
+     * random sampling within the intervals (and the region, if given, for
+     * its variables)
      * */
-    bool get_random_sample_from_intervals(const IntervalMap& intervalmap,
-                                          Model& sample);
+    bool get_random_sample_from_intervals(
+        const IntervalMap& intervalmap,
+        const std::list<z3::expr>& select_terms, Model& sample,
+        Region* region = nullptr);
+    /*
+     * Random values for the Real variables. Returns false if an interval has
+     * no point on the sampling grid.
+     */
+    bool get_random_sample_from_real_intervals(
+        const RealIntervalMap& real_intervals, Model& sample);
     void add_blocking_constraint_from_intervals(const IntervalMap& intervalmap);
+    /* keeps a new sample of the box as a seed for --seed-chaining */
+    void keep_chain_seed(Model sample, const IntervalMap& intervalmap);
+    /*
+     * Puts a kept sample in model, if it satisfies simpl_formula. Returns
+     * false if there is none.
+     */
+    bool chain_seed();
     /**
-     * randomly selecting the satisfied atoms in disjunction formulas to represent it. 
+     * selecting one of the satisfied atoms in disjunction formulas, by the
+     * disjunct policy, to represent it.
      * */
-    void remove_or(z3::expr& formula, const z3::model& m,
+    void remove_or(const z3::expr& formula, const z3::model& m,
                    std::list<z3::expr>& res);
+    /*
+     * Replaces the uninterpreted function applications in formula by fresh
+     * terms, and conjoins the Ackermann constraints.
+     */
+    z3::expr eliminate_uninterpreted_functions(const z3::expr& formula);
+    z3::expr replace_uf_applications(
+        const z3::expr& e, std::unordered_map<unsigned int, z3::expr>& cache,
+        z3::expr_vector& constraints);
+    /* fills the function tables of the sample from the fresh terms */
+    void add_uf_tables(Model& sample);
     /*
      * simplifies original_formula and saves the result in simpl_fomrula
      */
@@ -127,7 +324,7 @@ class MEGASampler : public Sampler {
      */
     z3::expr rename_z3_names(z3::expr& formula);
     void print_array_equality_graph();
-    void register_array_eq(z3::expr& f);
+    void register_array_eq(const z3::expr& formula);
     void remove_array_equalities(std::list<z3::expr>& conjuncts,
                                  bool debug_me);
     void add_equalities_from_select_terms(std::list<z3::expr>& conjuncts);
@@ -149,6 +346,52 @@ class MEGASampler : public Sampler {
                                   int64_t value,
                                   std::list<z3::expr>& new_conjucts);
     bool has_unbounded_selects(const IntervalMap& intervalmap);
+    /*
+     * Fingerprint of an implicant: the sorted ids of its literals.
+     */
+    std::vector<unsigned int> implicant_signature(
+        const std::list<z3::expr>& conjuncts);
+    /*
+     * Looks for a cached box of the same implicant that contains the seed
+     * model. Such a box is sound for the implicant, so it replaces
+     * strengthening only: the implicant includes the constraints of array
+     * equality removal, which depend on the seed and so run on every hit,
+     * and the box is sampled again. Returns true if found.
+     */
+    bool find_cached_box(const std::vector<unsigned int>& signature,
+                         const z3::model& m, IntervalMap& i_map);
+    void cache_box(const std::vector<unsigned int>& signature,
+                   const std::list<z3::expr>& conjuncts,
+                   const IntervalMap& i_map);
+    /*
+     * Adds the bool variables to the box as 0/1 intervals: those of the
+     * implicant are pinned to their value in the seed m, the others are
+     * [0,1] and get sampled uniformly.
+     */
+    void add_bool_intervals(const std::list<z3::expr>& conjuncts,
+                            const z3::model& m, IntervalMap& i_map);
+    /*
+     * Adds the full domain of the bit-vector variables that strengthening
+     * left unbounded: the implicant holds whatever values they take.
+     */
+    void add_bv_domains(IntervalMap& i_map);
+    /*
+     * Strengthens the literal with s. If no rule applies, pins its variables
+     * to the seed and counts the missing rule with --graceful-strengthening,
+     * and throws otherwise.
+     */
+    template <typename S>
+    void strengthen_or_pin(S& s, const z3::expr& literal);
+    /*
+     * Grows the seed into a box with the configured strengthening engine.
+     */
+    IntervalMap strengthen(const std::list<z3::expr>& conjuncts);
+    /*
+     * Strengthens the same implicant with the legacy rules and records how
+     * much larger the box of the volume engine is.
+     */
+    void compare_with_legacy_box(const std::list<z3::expr>& conjuncts,
+                                 const IntervalMap& i_map);
 };
 
 #endif /* MEGASAMPLER_H_ */
@@ -7,19 +7,32 @@
 #include <cstdint>
 #include <random>
 
-static inline int64_t safe_add(int64_t a, int64_t b) {
-  int64_t ret;
-  if (!__builtin_add_overflow(a, b, &ret)) return ret;
-  return ((a > 0) & (b > 0))
-             ? INT64_MAX
-             : INT64_MIN;  // TODO: fix for opposite signs? If there is overflow
-                           // the value will be wrong anyway
+/*
+ * Results are computed exactly in int128; one that doesn't fit in int64 has
+ * no value in the model.
+ */
+static inline std::pair<int64_t, bool> checked_result(int128_t value) {
+  if (value < INT64_MIN || value > INT64_MAX)
+    return std::pair<int64_t, bool>(-1, false);
+  return std::pair<int64_t, bool>((int64_t)value, true);
+}
+
+/*
+ * div and mod with the SMT-LIB semantics: a = b * div(a, b) + mod(a, b) and
+ * 0 <= mod(a, b) < |b|. b must not be 0.
+ */
+static inline int128_t euclidean_div(int64_t a, int64_t b) {
+  if (b == -1) return -(int128_t)a;
+  int64_t q = a / b;
+  if (a % b < 0) q = (b > 0) ? q - 1 : q + 1;
+  return q;
 }
 
-static inline int64_t safe_mul(int64_t a, int64_t b) {
-  int64_t ret;
-  if (!__builtin_mul_overflow(a, b, &ret)) return ret;
-  return ((a > 0) ^ (b > 0)) ? INT64_MIN : INT64_MAX;
+static inline int64_t euclidean_mod(int64_t a, int64_t b) {
+  if (b == -1) return 0;
+  int64_t r = a % b;
+  if (r < 0) r = (b > 0) ? r + b : r - b;
+  return r;
 }
 
 /** 
@@ -38,6 +51,23 @@ bool Model::addIntAssignment(const std::string& var, int64_t value) {
   return ret.second;
 }
 
+bool Model::addBoolAssignment(const std::string& var, bool value) {
+  auto ret = bool_map.insert(std::pair(var, value));
+  return ret.second;
+}
+
+bool Model::addBvAssignment(const std::string& var, uint64_t value,
+                            unsigned int width) {
+  assert(width > 0 && width <= 64);
+  auto ret = bv_map.insert(std::pair(var, std::pair(value, width)));
+  return ret.second;
+}
+
+bool Model::addRealAssignment(const std::string& var, const Rational& value) {
+  auto ret = real_map.insert(std::pair(var, value));
+  return ret.second;
+}
+
 bool Model::addArrayAssignment(const std::string& array, int64_t index,
                                int64_t value) {
   std::map<int64_t, int64_t> idx_val_map;
@@ -51,10 +81,18 @@ bool Model::addArrayAssignment(const std::string& array, int64_t index,
   }
 }
 
+bool Model::addUfAssignment(const std::string& function,
+                            const std::vector<int64_t>& args, int64_t value) {
+  auto ret = uf_map[function].insert(std::pair(args, value));
+  return ret.second;
+}
+
 std::string Model::toString() {
   std::string res;
   // lets estimate the string size to prevent reallocation
-  res.reserve(10 + variable_map.size() * 10 + array_map.size() * 25);
+  res.reserve(10 + variable_map.size() * 10 + bool_map.size() * 5 +
+              bv_map.size() * 20 + real_map.size() * 20 +
+              array_map.size() * 25 + uf_map.size() * 25);
   for (const auto& name : var_names) {
     const auto var_value = variable_map.find(name);
     if (var_value != variable_map.end()) { // format "var: var;"
@@ -64,6 +102,33 @@ std::string Model::toString() {
       res += ';';
       continue;
     }
+    const auto bool_value = bool_map.find(name);
+    if (bool_value != bool_map.end()) { // format "var:0;" or "var:1;"
+      res += bool_value->first;
+      res += ':';
+      res += bool_value->second ? '1' : '0';
+      res += ';';
+      continue;
+    }
+    const auto bv_value = bv_map.find(name);
+    if (bv_value != bv_map.end()) { // format "var:hex;", like bv_string
+      static const char digits[] = "0123456789abcdef";
+      const uint64_t value = bv_value->second.first;
+      res += bv_value->first;
+      res += ':';
+      for (int i = (bv_value->second.second + 3) / 4 - 1; i >= 0; i--)
+        res += digits[(value >> (4 * i)) & 15];
+      res += ';';
+      continue;
+    }
+    const auto real_value = real_map.find(name);
+    if (real_value != real_map.end()) { // format "var:num/den;" or "var:num;"
+      res += real_value->first;
+      res += ':';
+      res += real_value->second.to_string();
+      res += ';';
+      continue;
+    }
     const auto array_value = array_map.find(name);
     if (array_value != array_map.end()) { // format "arr_name:[arr_size,0,idx1->val1,idx2->val2,...];"
       res += array_value->first;
@@ -83,6 +148,23 @@ std::string Model::toString() {
       res += "];";
       continue;
     }
+    const auto uf_value = uf_map.find(name);
+    if (uf_value != uf_map.end()) { // format "f:(#entries;0;arg1:arg2:val,...);"
+      res += uf_value->first;
+      res += ":(";
+      res += std::to_string(uf_value->second.size());
+      res += ";0;";  // default value, like for arrays
+      for (const auto& entry : uf_value->second) {
+        for (const auto arg : entry.first) {
+          res += std::to_string(arg);
+          res += ':';
+        }
+        res += std::to_string(entry.second);
+        res += ',';
+      }
+      res += ");";
+      continue;
+    }
     //if (debug)
     //  std::cerr << "Variable named " << name << " not found in model.";
     // assert(false);
@@ -104,6 +186,33 @@ std::pair<int64_t, bool> Model::evalIntVar(const std::string& var) {
   }
 }
 
+std::pair<bool, bool> Model::evalBoolVar(const std::string& var) {
+  auto it = bool_map.find(var);
+  if (it == bool_map.end()) {
+    return std::pair<bool, bool>(false, false);
+  } else {
+    return std::pair<bool, bool>(it->second, true);
+  }
+}
+
+std::pair<uint64_t, bool> Model::evalBvVar(const std::string& var) {
+  auto it = bv_map.find(var);
+  if (it == bv_map.end()) {
+    return std::pair<uint64_t, bool>(0, false);
+  } else {
+    return std::pair<uint64_t, bool>(it->second.first, true);
+  }
+}
+
+std::pair<Rational, bool> Model::evalRealVar(const std::string& var) {
+  auto it = real_map.find(var);
+  if (it == real_map.end()) {
+    return std::pair<Rational, bool>(Rational(), false);
+  } else {
+    return std::pair<Rational, bool>(it->second, true);
+  }
+}
+
 /**
  * Returns (val,true) if the array element arr[idx] 
  * is assigned a value in the model; 
@@ -132,8 +241,9 @@ std::pair<int64_t, bool> Model::evalIntExpr(const z3::expr& e, bool debug,
   assert(e.is_app());
   z3::func_decl fd = e.decl();
   if (e.is_const()) {
-    int i;
-    if (e.is_numeral_i(i)) {
+    if (e.is_numeral()) {
+      int64_t i;
+      if (!e.is_numeral_i64(i)) return std::pair<int64_t, bool>(-1, false);
       if (debug) std::cout << "found numeral: " << std::to_string(i) << "\n";
       return std::pair<int64_t, bool>(i, true);
     }
@@ -200,45 +310,68 @@ std::pair<int64_t, bool> Model::evalIntExpr(const z3::expr& e, bool debug,
   switch (fd.decl_kind()) {
     case Z3_OP_ADD: {
       if (debug) std::cout << "found add\n";
-      int64_t sum = 0;
+      int128_t sum = 0;  // exact for any number of int64 summands
       for (std::vector<int64_t>::iterator it = children_values.begin();
            it != children_values.end(); ++it) {
-        sum = safe_add(sum, *it);
+        sum += *it;
       }
       if (debug)
-        std::cout << "returning sum result: " << std::to_string(sum) << "\n";
-      return std::pair<int64_t, bool>(sum, true);
+        std::cout << "returning sum result: " << int128_to_string(sum) << "\n";
+      return checked_result(sum);
     }
     case Z3_OP_MUL: {
       if (debug) std::cout << "found mul\n";
-      int64_t prod = 1;
+      int128_t prod = 1;
       for (std::vector<int64_t>::iterator it = children_values.begin();
            it != children_values.end(); ++it) {
-        prod = safe_mul(prod, *it);
+        if (__builtin_mul_overflow(prod, *it, &prod))
+          return std::pair<int64_t, bool>(-1, false);
       }
       if (debug)
-        std::cout << "returning mult result: " << std::to_string(prod) << "\n";
-      return std::pair<int64_t, bool>(prod, true);
+        std::cout << "returning mult result: " << int128_to_string(prod)
+                  << "\n";
+      return checked_result(prod);
     }
     case Z3_OP_SUB: {
       if (debug) std::cout << "found sub\n";
       assert(children_values.size() == 2);
-      int64_t sub = safe_add(
-          children_values[0],
-          -children_values[1]);  // TODO: can unary minus computation overflow?
+      const int128_t sub = (int128_t)children_values[0] - children_values[1];
       if (debug)
-        std::cout << "returning sub result: " << std::to_string(sub) << "\n";
-      return std::pair<int64_t, bool>(sub, true);
+        std::cout << "returning sub result: " << int128_to_string(sub) << "\n";
+      return checked_result(sub);
     }
     case Z3_OP_UMINUS: {
       if (debug) std::cout << "found uminus\n";
       assert(children_values.size() == 1);
+      const int128_t minus = -(int128_t)children_values[0];
+      if (debug)
+        std::cout << "returning uminus result: " << int128_to_string(minus)
+                  << "\n";
+      return checked_result(minus);
+    }
+    case Z3_OP_IDIV:
+    case Z3_OP_MOD:
+    case Z3_OP_REM: {
+      if (debug) std::cout << "found div/mod/rem\n";
+      assert(children_values.size() == 2);
+      int64_t divisor = children_values[1];
+      if (divisor == 0) {
+        // uninterpreted in SMT-LIB, no value to give
+        if (debug) std::cout << "division by zero\n";
+        return std::pair<int64_t, bool>(-1, false);
+      }
+      int128_t res;
+      if (fd.decl_kind() == Z3_OP_IDIV) {
+        res = euclidean_div(children_values[0], divisor);
+      } else {
+        res = euclidean_mod(children_values[0], divisor);
+        // rem takes the sign of the divisor
+        if (fd.decl_kind() == Z3_OP_REM && divisor < 0) res = -res;
+      }
       if (debug)
-        std::cout << "returning uminus result: "
-                  << std::to_string(-children_values[0]) << "\n";
-      return std::pair<int64_t, bool>(
-          -children_values[0],
-          true);  // TODO: can unary minus computation overflow?
+        std::cout << "returning div/mod/rem result: " << int128_to_string(res)
+                  << "\n";
+      return checked_result(res);
     }
     default: {
       if (debug) std::cout << "unknown op: " << fd.decl_kind() << "\n";
@@ -296,9 +429,20 @@ Model::Model(const z3::model& m, const std::vector<std::string>& _var_names, con
       Z3_ast ast = b;
       switch (v.range().sort_kind()) {
         case Z3_BV_SORT:
+          // wider bit-vectors do not fit in bv_map
+          if (!ast || v.range().bv_size() > 64) {
+            continue;
+          } else {
+            addBvAssignment(var_name, b.get_numeral_uint64(),
+                            v.range().bv_size());
+          }
           break;
         case Z3_BOOL_SORT:
-          // TODO: add bool support in model
+          if (!ast) {
+            continue;
+          } else {
+            addBoolAssignment(var_name, b.is_true());
+          }
           break;
         case Z3_INT_SORT:
           if (!ast) {
@@ -309,6 +453,15 @@ Model::Model(const z3::model& m, const std::vector<std::string>& _var_names, con
             addIntAssignment(var_name, num);
           }
           break;
+        case Z3_REAL_SORT:
+          if (!ast) {
+            continue;
+          } else {
+            Rational value;
+            if (numeral_to_rational(b, value))
+              addRealAssignment(var_name, value);
+          }
+          break;
         default:
           throw UnsupportedOpInZ3Model();
       }
@@ -8,14 +8,28 @@
 #include <string>
 #include <vector>
 
+#include "real_interval.h"
+
 class Model {
   const std::vector<std::string>& var_names;  // Memory shenanigans :)
   std::map<std::string, int64_t> variable_map;
+  std::map<std::string, bool> bool_map;
+  // bit-vectors of at most 64 bits: (unsigned value, width)
+  std::map<std::string, std::pair<uint64_t, unsigned int>> bv_map;
+  std::map<std::string, Rational> real_map;
   std::map<std::string, std::map<int64_t, int64_t>> array_map;
+  // uninterpreted functions from Int arguments to Int: args -> value
+  std::map<std::string, std::map<std::vector<int64_t>, int64_t>> uf_map;
 
  public:
   Model(const std::vector<std::string>& _var_names)
-      : var_names(_var_names), variable_map(), array_map() {}
+      : var_names(_var_names),
+        variable_map(),
+        bool_map(),
+        bv_map(),
+        real_map(),
+        array_map(),
+        uf_map() {}
   Model(const z3::model& m, const std::vector<std::string>& _var_names, const std::vector<z3::func_decl>& variables);
 
   struct UnsupportedOpInZ3Model : public std::exception{};
@@ -24,10 +38,24 @@ class Model {
    * assigned).
    */
   bool addIntAssignment(const std::string& var, int64_t value);
+  // Returns true iff assignment was successful (i.e, var was not previously
+  // assigned).
+  bool addBoolAssignment(const std::string& var, bool value);
+  // Returns true iff assignment was successful (i.e, var was not previously
+  // assigned). value is the unsigned value of a bit-vector of width bits.
+  bool addBvAssignment(const std::string& var, uint64_t value,
+                       unsigned int width);
+  // Returns true iff assignment was successful (i.e, var was not previously
+  // assigned).
+  bool addRealAssignment(const std::string& var, const Rational& value);
   // Returns true iff assignment was successful (i.e, array[index] was not
   // previously assigned).
   bool addArrayAssignment(const std::string& array, int64_t index,
                           int64_t value);
+  // Returns true iff assignment was successful (i.e, function(args) was not
+  // previously assigned).
+  bool addUfAssignment(const std::string& function,
+                       const std::vector<int64_t>& args, int64_t value);
   /**
    * Return the model as a string
    * */
@@ -38,6 +66,21 @@ class Model {
    * and true. Else - returns -1 and false.
    */
   std::pair<int64_t, bool> evalIntVar(const std::string& var);
+  /*
+   * If var is assigned in the current model - returns its value in the model
+   * and true. Else - returns false and false.
+   */
+  std::pair<bool, bool> evalBoolVar(const std::string& var);
+  /*
+   * If var is assigned in the current model - returns its unsigned value in
+   * the model and true. Else - returns 0 and false.
+   */
+  std::pair<uint64_t, bool> evalBvVar(const std::string& var);
+  /*
+   * If var is assigned in the current model - returns its value in the model
+   * and true. Else - returns 0 and false.
+   */
+  std::pair<Rational, bool> evalRealVar(const std::string& var);
   /*
    * If array[index] is assigned in the current model - returns its value in the
    * model and true. Else - returns -1 and false.
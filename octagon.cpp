@@ -0,0 +1,193 @@
+#include "octagon.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <numeric>
+
+#include "z3_utils.h"
+
+void Octagon::add_edge(unsigned int a, unsigned int b, int128_t bound) {
+  edges.emplace_back(a, b, bound);
+}
+
+bool Octagon::add_constraint(const LinearConstraint& constraint) {
+  const auto& terms = constraint.terms;
+  if (terms.empty() || terms.size() > 2) return false;
+  const int128_t magnitude =
+      terms[0].second > 0 ? terms[0].second : -terms[0].second;
+  if (terms.size() == 2 && terms[1].second != magnitude &&
+      terms[1].second != -magnitude)
+    return false;
+  const int128_t bound = floor_div(constraint.bound, magnitude);
+  if (constraint.is_eq && bound * magnitude != constraint.bound) return false;
+
+  // the node of s * x_i is 2i for s > 0 and 2i+1 for s < 0
+  auto node = [&](unsigned int term, bool negate) {
+    const unsigned int i = add_var(terms[term].first);
+    return ((terms[term].second > 0) != negate) ? 2 * i : 2 * i + 1;
+  };
+  const unsigned int a = node(0, false);
+  if (terms.size() == 1) {
+    add_edge(a, a ^ 1, 2 * bound);
+    if (constraint.is_eq) add_edge(a ^ 1, a, -2 * bound);
+  } else {
+    const unsigned int b = node(1, true);
+    add_edge(a, b, bound);
+    if (constraint.is_eq) add_edge(b, a, -bound);
+    relational++;
+  }
+  return true;
+}
+
+void Octagon::add_bounds(const z3::expr& var, const Interval& interval) {
+  const unsigned int i = add_var(var);
+  if (!interval.is_high_inf())
+    add_edge(2 * i, 2 * i + 1, 2 * (int128_t)interval.get_high());
+  if (!interval.is_low_minf())
+    add_edge(2 * i + 1, 2 * i, -2 * (int128_t)interval.get_low());
+}
+
+bool Octagon::close() {
+  const unsigned int size = 2 * vars.size();
+  m.assign((size_t)size * size, INF);
+  for (unsigned int a = 0; a < size; a++) at(a, a) = 0;
+  for (const auto& edge : edges) {
+    const unsigned int a = std::get<0>(edge), b = std::get<1>(edge);
+    const int128_t bound = std::get<2>(edge);
+    // V_a - V_b <= c is also -V_b - (-V_a) <= c
+    at(a, b) = std::min(at(a, b), bound);
+    at(b ^ 1, a ^ 1) = std::min(at(b ^ 1, a ^ 1), bound);
+  }
+
+  for (unsigned int k = 0; k < size; k++) {
+    for (unsigned int a = 0; a < size; a++) {
+      const int128_t a_k = at(a, k);
+      if (a_k >= INF) continue;
+      for (unsigned int b = 0; b < size; b++) {
+        const int128_t k_b = at(k, b);
+        if (k_b < INF && a_k + k_b < at(a, b)) at(a, b) = a_k + k_b;
+      }
+    }
+  }
+  for (unsigned int a = 0; a < size; a++) {
+    if (at(a, a) < 0) return false;
+    if (at(a, a ^ 1) < INF) at(a, a ^ 1) = 2 * floor_div(at(a, a ^ 1), 2);
+  }
+  for (unsigned int a = 0; a < size; a++) {
+    if (at(a, a ^ 1) >= INF) continue;
+    for (unsigned int b = 0; b < size; b++) {
+      if (at(b ^ 1, b) >= INF) continue;
+      at(a, b) = std::min(at(a, b), (at(a, a ^ 1) + at(b ^ 1, b)) / 2);
+    }
+  }
+  for (unsigned int a = 0; a < size; a += 2) {
+    if (at(a, a + 1) < INF && at(a + 1, a) < INF &&
+        at(a, a + 1) + at(a + 1, a) < 0)
+      return false;
+  }
+
+  neighbors.assign(vars.size(), {});
+  for (unsigned int i = 0; i < vars.size(); i++) {
+    for (unsigned int j = 0; j < vars.size(); j++) {
+      if (i == j) continue;
+      if (at(2 * i, 2 * j) < INF || at(2 * i, 2 * j + 1) < INF ||
+          at(2 * i + 1, 2 * j) < INF || at(2 * i + 1, 2 * j + 1) < INF)
+        neighbors[i].push_back(j);
+    }
+  }
+  return true;
+}
+
+Interval Octagon::get_bounds(unsigned int i) const {
+  const int128_t high = at(2 * i, 2 * i + 1);
+  const int128_t minus_low = at(2 * i + 1, 2 * i);
+  return Interval(minus_low < INF ? clamp_to_int64(-minus_low / 2) : INT64_MIN,
+                  high < INF ? clamp_to_int64(high / 2) : INT64_MAX);
+}
+
+bool Octagon::sample(std::mt19937& g, std::vector<int64_t>& point) {
+  const unsigned int n = vars.size();
+  std::vector<int128_t> low(n), high(n);
+  for (unsigned int i = 0; i < n; i++) {
+    const Interval bounds = get_bounds(i);
+    low[i] = bounds.get_low();
+    high[i] = bounds.get_high();
+  }
+  std::vector<unsigned int> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), g);
+  std::vector<bool> assigned(n, false);
+  point.resize(n);
+
+  for (const unsigned int k : order) {
+    const int128_t lo = std::max<int128_t>(low[k], INT64_MIN);
+    const int128_t hi = std::min<int128_t>(high[k], INT64_MAX);
+    if (lo > hi) return false;
+    std::uniform_int_distribution<int64_t> value_dist((int64_t)lo,
+                                                      (int64_t)hi);
+    const int64_t value = value_dist(g);
+    point[k] = value;
+    assigned[k] = true;
+    for (const unsigned int j : neighbors[k]) {
+      if (assigned[j]) continue;
+      // x_j - x_k, x_j + x_k, -x_j - x_k and -x_j + x_k
+      if (at(2 * j, 2 * k) < INF)
+        high[j] = std::min(high[j], value + at(2 * j, 2 * k));
+      if (at(2 * j, 2 * k + 1) < INF)
+        high[j] = std::min(high[j], at(2 * j, 2 * k + 1) - value);
+      if (at(2 * j + 1, 2 * k) < INF)
+        low[j] = std::max(low[j], -at(2 * j + 1, 2 * k) - value);
+      if (at(2 * j + 1, 2 * k + 1) < INF)
+        low[j] = std::max(low[j], value - at(2 * j + 1, 2 * k + 1));
+    }
+  }
+  return true;
+}
+
+z3::expr Octagon::to_expr(z3::context& c) const {
+  z3::expr result = c.bool_val(true);
+  auto node_expr = [&](unsigned int a) {
+    return (a % 2) ? -vars[a / 2] : vars[a / 2];
+  };
+  for (const auto& edge : edges) {
+    const unsigned int a = std::get<0>(edge), b = std::get<1>(edge);
+    const int128_t bound = std::get<2>(edge);
+    if (b == (a ^ 1)) {
+      const std::string half = int128_to_string(floor_div(bound, 2));
+      result = result && node_expr(a) <= c.int_val(half.c_str());
+    } else {
+      const std::string full = int128_to_string(bound);
+      result =
+          result && node_expr(a) - node_expr(b) <= c.int_val(full.c_str());
+    }
+  }
+  return result;
+}
+
+void OctagonStrengthener::strengthen_literal(const z3::expr& literal) {
+  if (debug)
+    std::cout << "octagon strengthening literal: " << literal.to_string()
+              << "\n";
+  LinearConstraint constraint;
+  if (to_linear_constraint(literal, model, constraint) &&
+      octagon.add_constraint(constraint))
+    return;
+  legacy.strengthen_literal(literal);
+}
+
+void OctagonStrengthener::compute_octagon() {
+  for (const auto& var : octagon.get_vars()) {
+    const auto it = i_map.find(var);
+    if (it != i_map.end()) octagon.add_bounds(var, it->second);
+  }
+#ifndef NDEBUG
+  bool res =
+#endif
+      octagon.close();
+  assert(res);  // the seed is in the octagon
+  const auto& vars = octagon.get_vars();
+  for (unsigned int i = 0; i < vars.size(); i++) {
+    i_map[vars[i]] = octagon.get_bounds(i);
+  }
+}
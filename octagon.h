@@ -0,0 +1,99 @@
+#ifndef MEGASAMPLER_OCTAGON_H
+#define MEGASAMPLER_OCTAGON_H
+
+#include <z3++.h>
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "interval.h"
+#include "intervalmap.h"
+#include "linear.h"
+#include "region.h"
+#include "strengthener.h"
+
+/*
+ * Conjunction of constraints +-x_i +-x_j <= c over Int constants, kept as a
+ * difference-bound matrix over the 2n nodes V_2i = x_i, V_2i+1 = -x_i, where
+ * m[a][b] bounds V_a - V_b (Mine, "The octagon abstract domain"). Unary
+ * constraints are x_i - (-x_i) <= 2c.
+ */
+class Octagon : public Region {
+ public:
+  /*
+   * Adds a linear constraint if it is octagonal: one variable, or two
+   * variables with coefficients of the same magnitude. Returns false
+   * otherwise.
+   */
+  bool add_constraint(const LinearConstraint& constraint);
+  void add_bounds(const z3::expr& var, const Interval& interval);
+  /*
+   * Tight closure (Bagnara, Hill, Zaffanella): shortest paths, integer
+   * tightening of the unary bounds, then strengthening. Returns false if the
+   * octagon has no integer point.
+   */
+  bool close();
+
+  /* projection of the closed octagon on a variable */
+  [[nodiscard]] Interval get_bounds(unsigned int i) const;
+  /* number of constraints between two different variables */
+  [[nodiscard]] unsigned long num_relational() const { return relational; }
+  /*
+   * Draws a point of the closed octagon by sequential bound propagation:
+   * variables are drawn in a random order, each uniformly between the bounds
+   * implied by the values drawn so far. Returns false on a dead end (the
+   * bounds of some variable became empty), point is then meaningless.
+   */
+  bool sample(std::mt19937& g, std::vector<int64_t>& point) override;
+  /* the constraints that were added, as a formula */
+  [[nodiscard]] z3::expr to_expr(z3::context& c) const override;
+
+ private:
+  static constexpr int128_t INF = ((int128_t)1) << 120;
+  std::vector<std::tuple<unsigned int, unsigned int, int128_t>> edges;
+  std::vector<int128_t> m;  // (2n)x(2n), row-major
+  std::vector<std::vector<unsigned int>> neighbors;  // related variables
+  unsigned long relational = 0;
+
+  void add_edge(unsigned int a, unsigned int b, int128_t bound);
+  [[nodiscard]] int128_t at(unsigned int a, unsigned int b) const {
+    return m[a * 2 * vars.size() + b];
+  }
+  int128_t& at(unsigned int a, unsigned int b) {
+    return m[a * 2 * vars.size() + b];
+  }
+};
+
+/*
+ * Grows the seed into an octagon: octagonal literals go to the Octagon,
+ * all other literals to the legacy Strengthener, whose bounds are added to
+ * the octagon. i_map gets the bounding box of the octagon for its variables.
+ */
+class OctagonStrengthener {
+  z3::model& model;
+  bool debug;
+  Strengthener legacy;
+
+ public:
+  Octagon octagon;
+  IntervalMap& i_map;
+  RealIntervalMap& r_map;
+
+  OctagonStrengthener(z3::context& con, z3::model& mod, bool deb)
+      : model(mod),
+        debug(deb),
+        legacy(con, mod, deb),
+        i_map(legacy.i_map),
+        r_map(legacy.r_map){};
+  void strengthen_literal(const z3::expr& literal);
+  /* closes the octagon, must be called last */
+  void compute_octagon();
+  void print_interval_map() { legacy.print_interval_map(); }
+  void pin_literal(const z3::expr& literal) { legacy.pin_literal(literal); }
+  [[nodiscard]] unsigned long get_ite_rewrites() const {
+    return legacy.ite_rewrites;
+  }
+};
+
+#endif  // MEGASAMPLER_OCTAGON_H
@@ -0,0 +1,190 @@
+#include "polytope.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+#include "z3_utils.h"
+
+// keeps the products in the slacks far from overflowing int128
+static constexpr int128_t MAX_COEFF = INT32_MAX;
+
+void Polytope::add_row(std::vector<std::pair<unsigned int, int128_t>> terms,
+                       int128_t bound, bool from_equality) {
+  rows.push_back({std::move(terms), bound, from_equality});
+}
+
+void Polytope::add_constraint(const LinearConstraint& constraint) {
+  std::vector<std::pair<unsigned int, int128_t>> terms;
+  for (const auto& term : constraint.terms) {
+    terms.emplace_back(add_var(term.first), term.second);
+  }
+  if (constraint.is_eq) {
+    std::vector<std::pair<unsigned int, int128_t>> negated(terms);
+    for (auto& term : negated) term.second = -term.second;
+    add_row(std::move(negated), -constraint.bound, true);
+  }
+  add_row(std::move(terms), constraint.bound, constraint.is_eq);
+}
+
+void Polytope::add_bounds(const z3::expr& var, const Interval& interval) {
+  const unsigned int i = add_var(var);
+  if (!interval.is_high_inf()) add_row({{i, 1}}, interval.get_high(), false);
+  if (!interval.is_low_minf()) add_row({{i, -1}}, -interval.get_low(), false);
+}
+
+bool Polytope::start(const std::vector<int64_t>& point) {
+  assert(point.size() == vars.size());
+  current = point;
+  columns.assign(vars.size(), {});
+  slack.assign(rows.size(), 0);
+  std::vector<bool> frozen(vars.size(), false);
+  for (unsigned int r = 0; r < rows.size(); r++) {
+    int128_t row_value = 0;
+    for (const auto& term : rows[r].terms) {
+      row_value += term.second * current[term.first];
+      columns[term.first].emplace_back(r, term.second);
+      // a coordinate move changes the row, so it can't leave an equality
+      if (rows[r].from_equality) frozen[term.first] = true;
+    }
+    slack[r] = rows[r].bound - row_value;
+    if (slack[r] < 0) return false;
+  }
+  movable.clear();
+  for (unsigned int i = 0; i < vars.size(); i++) {
+    if (!frozen[i]) movable.push_back(i);
+  }
+  return true;
+}
+
+bool Polytope::sample(std::mt19937& g, std::vector<int64_t>& point) {
+  if (!movable.empty()) {
+    std::uniform_int_distribution<size_t> var_dist(0, movable.size() - 1);
+    const unsigned int i = movable[var_dist(g)];
+    const int128_t value = current[i];
+    // range of the move t: a * t <= slack for every row of the variable
+    int128_t low = (int128_t)INT64_MIN - value;
+    int128_t high = (int128_t)INT64_MAX - value;
+    for (const auto& rc : columns[i]) {
+      if (rc.second > 0) {
+        high = std::min(high, floor_div(slack[rc.first], rc.second));
+      } else {
+        low = std::max(low, -floor_div(slack[rc.first], -rc.second));
+      }
+    }
+    assert(low <= 0 && 0 <= high);
+    std::uniform_int_distribution<int64_t> value_dist(
+        (int64_t)(value + low), (int64_t)(value + high));
+    const int64_t new_value = value_dist(g);
+    const int128_t move = new_value - value;
+    if (move != 0) {
+      for (const auto& rc : columns[i]) slack[rc.first] -= rc.second * move;
+      current[i] = new_value;
+    }
+  }
+  point = current;
+  return true;
+}
+
+z3::expr Polytope::to_expr(z3::context& c) const {
+  z3::expr result = c.bool_val(true);
+  for (const auto& row : rows) {
+    z3::expr sum = c.int_val(0);
+    for (const auto& term : row.terms) {
+      const std::string coeff = int128_to_string(term.second);
+      sum = sum + c.int_val(coeff.c_str()) * vars[term.first];
+    }
+    const std::string bound = int128_to_string(row.bound);
+    result = result && sum <= c.int_val(bound.c_str());
+  }
+  return result;
+}
+
+void Polytope::bounding_box(IntervalMap& i_map) const {
+  std::vector<int128_t> low(vars.size(), INT64_MIN);
+  std::vector<int128_t> high(vars.size(), INT64_MAX);
+  auto is_infinite = [&](unsigned int i, int128_t coeff) {
+    return coeff > 0 ? low[i] == INT64_MIN : high[i] == INT64_MAX;
+  };
+  for (unsigned int round = 0; round < PROPAGATION_ROUNDS; round++) {
+    for (const auto& row : rows) {
+      // the smallest value of the row over the current box
+      int128_t finite_min = 0;
+      unsigned int num_infinite = 0;
+      bool overflow = false;
+      for (const auto& term : row.terms) {
+        if (is_infinite(term.first, term.second)) {
+          num_infinite++;
+          continue;
+        }
+        const int128_t bound = term.second > 0 ? low[term.first]
+                                               : high[term.first];
+        int128_t product;
+        overflow = overflow ||
+                   __builtin_mul_overflow(term.second, bound, &product) ||
+                   __builtin_add_overflow(finite_min, product, &finite_min);
+      }
+      if (overflow || num_infinite > 1) continue;
+      for (const auto& term : row.terms) {
+        const bool infinite = is_infinite(term.first, term.second);
+        if (num_infinite == 1 && !infinite) continue;
+        int128_t rest = row.bound - finite_min;
+        if (!infinite) {
+          rest += term.second * (term.second > 0 ? low[term.first]
+                                                 : high[term.first]);
+        }
+        if (term.second > 0) {
+          high[term.first] = std::min(
+              high[term.first], clamp_to_int64(floor_div(rest, term.second)));
+        } else {
+          low[term.first] =
+              std::max(low[term.first],
+                       clamp_to_int64(-floor_div(rest, -term.second)));
+        }
+      }
+    }
+  }
+  for (unsigned int i = 0; i < vars.size(); i++) {
+    Interval& interval = i_map[vars[i]];
+    interval.set_lower_bound((int64_t)low[i]);
+    interval.set_upper_bound((int64_t)high[i]);
+  }
+}
+
+void PolytopeStrengthener::strengthen_literal(const z3::expr& literal) {
+  if (debug)
+    std::cout << "polytope strengthening literal: " << literal.to_string()
+              << "\n";
+  LinearConstraint constraint;
+  if (to_linear_constraint(literal, model, constraint) &&
+      !constraint.terms.empty()) {
+    bool representable = true;
+    for (const auto& term : constraint.terms) {
+      const int64_t value = model_eval_to_int64(model, term.first);
+      representable = representable && value != INT64_MIN &&
+                      value != INT64_MAX && term.second <= MAX_COEFF &&
+                      term.second >= -MAX_COEFF;
+    }
+    if (representable) {
+      polytope.add_constraint(constraint);
+      return;
+    }
+  }
+  legacy.strengthen_literal(literal);
+}
+
+void PolytopeStrengthener::compute_polytope() {
+  const auto& vars = polytope.get_vars();
+  for (const auto& var : vars) {
+    const auto it = i_map.find(var);
+    if (it != i_map.end()) polytope.add_bounds(var, it->second);
+  }
+  std::vector<int64_t> seed;
+  for (const auto& var : vars) seed.push_back(model_eval_to_int64(model, var));
+#ifndef NDEBUG
+  bool res =
+#endif
+      polytope.start(seed);
+  assert(res);  // the seed satisfies the implicant
+  polytope.bounding_box(i_map);
+}
@@ -0,0 +1,92 @@
+#ifndef MEGASAMPLER_POLYTOPE_H
+#define MEGASAMPLER_POLYTOPE_H
+
+#include <z3++.h>
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "interval.h"
+#include "intervalmap.h"
+#include "linear.h"
+#include "region.h"
+#include "strengthener.h"
+
+/*
+ * The linear part of the implicant as Ax <= b over Int constants, sampled by
+ * a coordinate-direction integer hit-and-run walk that starts at the seed:
+ * every step picks a variable, computes in closed form the range of values
+ * it can take with all other variables fixed, and moves to a uniform value
+ * in it. Every visited point is a sample.
+ */
+class Polytope : public Region {
+ public:
+  /* adds a row, or two rows for an equality */
+  void add_constraint(const LinearConstraint& constraint);
+  void add_bounds(const z3::expr& var, const Interval& interval);
+  /*
+   * Starts the walk at point (values in the order of get_vars()). Returns
+   * false if the point violates a row.
+   */
+  bool start(const std::vector<int64_t>& point);
+  /* one step of the walk, point gets the new position */
+  bool sample(std::mt19937& g, std::vector<int64_t>& point) override;
+  [[nodiscard]] z3::expr to_expr(z3::context& c) const override;
+  /*
+   * Intersects the intervals of the variables with a bounding box of the
+   * polytope, found by propagating the rows.
+   */
+  void bounding_box(IntervalMap& i_map) const;
+
+  [[nodiscard]] size_t num_rows() const { return rows.size(); }
+
+ private:
+  static constexpr unsigned int PROPAGATION_ROUNDS = 3;
+  struct Row {
+    std::vector<std::pair<unsigned int, int128_t>> terms;  // (var, coeff)
+    int128_t bound;
+    bool from_equality;
+  };
+  std::vector<Row> rows;
+  // for every variable: (row, coeff) of the rows it appears in
+  std::vector<std::vector<std::pair<unsigned int, int128_t>>> columns;
+  std::vector<int64_t> current;
+  std::vector<int128_t> slack;        // b - Ax at the current point
+  std::vector<unsigned int> movable;  // variables not fixed by equalities
+
+  void add_row(std::vector<std::pair<unsigned int, int128_t>> terms,
+               int128_t bound, bool from_equality);
+};
+
+/*
+ * Grows the seed into a polytope: linear literals become rows, the others go
+ * to the legacy Strengthener, whose bounds are added as rows too.
+ */
+class PolytopeStrengthener {
+  z3::model& model;
+  bool debug;
+  Strengthener legacy;
+
+ public:
+  Polytope polytope;
+  IntervalMap& i_map;
+  RealIntervalMap& r_map;
+
+  PolytopeStrengthener(z3::context& con, z3::model& mod, bool deb)
+      : model(mod),
+        debug(deb),
+        legacy(con, mod, deb),
+        i_map(legacy.i_map),
+        r_map(legacy.r_map){};
+  void strengthen_literal(const z3::expr& literal);
+  /* starts the walk at the seed, must be called last */
+  void compute_polytope();
+  void print_interval_map() { legacy.print_interval_map(); }
+  void pin_literal(const z3::expr& literal) { legacy.pin_literal(literal); }
+  [[nodiscard]] unsigned long get_ite_rewrites() const {
+    return legacy.ite_rewrites;
+  }
+};
+
+#endif  // MEGASAMPLER_POLYTOPE_H
@@ -0,0 +1,157 @@
+#include "real_interval.h"
+
+#include <algorithm>
+
+static int128_t gcd(int128_t a, int128_t b) {
+  if (a < 0) a = -a;
+  if (b < 0) b = -b;
+  while (b != 0) {
+    const int128_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+Rational::Rational(int128_t n, int128_t d) {
+  assert(d != 0);
+  if (d < 0) {
+    n = -n;
+    d = -d;
+  }
+  const int128_t g = gcd(n, d);
+  n /= g;
+  d /= g;
+  if (n < INT64_MIN || n > INT64_MAX || d > INT64_MAX) throw RationalOverflow();
+  num = (int64_t)n;
+  den = (int64_t)d;
+}
+
+std::string Rational::to_string() const {
+  if (den == 1) return std::to_string(num);
+  return std::to_string(num) + "/" + std::to_string(den);
+}
+
+// the products of int64 values fit in int128, and so do their sums
+Rational operator+(const Rational& a, const Rational& b) {
+  return Rational((int128_t)a.num * b.den + (int128_t)b.num * a.den,
+                  (int128_t)a.den * b.den);
+}
+
+Rational operator-(const Rational& a, const Rational& b) {
+  return Rational((int128_t)a.num * b.den - (int128_t)b.num * a.den,
+                  (int128_t)a.den * b.den);
+}
+
+Rational operator*(const Rational& a, const Rational& b) {
+  return Rational((int128_t)a.num * b.num, (int128_t)a.den * b.den);
+}
+
+Rational operator/(const Rational& a, const Rational& b) {
+  assert(b.num != 0);
+  return Rational((int128_t)a.num * b.den, (int128_t)a.den * b.num);
+}
+
+bool operator<(const Rational& a, const Rational& b) {
+  return (int128_t)a.num * b.den < (int128_t)b.num * a.den;
+}
+
+bool numeral_to_rational(const z3::expr& numeral, Rational& value) {
+  if (!numeral.is_numeral()) return false;
+  int64_t num, den;
+  if (numeral.is_int()) {
+    if (!numeral.is_numeral_i64(num)) return false;
+    value = Rational(num);
+    return true;
+  }
+  if (!numeral.numerator().is_numeral_i64(num) ||
+      !numeral.denominator().is_numeral_i64(den))
+    return false;
+  try {
+    value = Rational((int128_t)num, (int128_t)den);
+  } catch (const RationalOverflow&) {
+    return false;  // -INT64_MIN
+  }
+  return true;
+}
+
+void RealInterval::set_upper_bound(const Rational& u_bound, bool strict) {
+  if (!high_inf && (high < u_bound || (high == u_bound && !strict))) return;
+  high = u_bound;
+  high_inf = false;
+  high_strict = strict;
+}
+
+void RealInterval::set_lower_bound(const Rational& l_bound, bool strict) {
+  if (!low_inf && (l_bound < low || (low == l_bound && !strict))) return;
+  low = l_bound;
+  low_inf = false;
+  low_strict = strict;
+}
+
+bool RealInterval::is_bottom() const {
+  if (low_inf || high_inf) return false;
+  if (high < low) return true;
+  return low == high && (low_strict || high_strict);
+}
+
+bool RealInterval::is_in_range(const Rational& value) const {
+  const bool above_low =
+      low_inf || low < value || (low == value && !low_strict);
+  const bool below_high =
+      high_inf || value < high || (value == high && !high_strict);
+  return above_low && below_high;
+}
+
+bool RealInterval::random_in_range(std::mt19937& g, Rational& value) const {
+  if (is_bottom()) return false;
+  // the grid: the denominators of the bounds, refined if there is room
+  int128_t den = 1;
+  if (!low_inf) den = low.get_den();
+  if (!high_inf) den = den / gcd(den, high.get_den()) * high.get_den();
+  if (den > INT64_MAX) den = std::max(low.get_den(), high.get_den());
+  const int128_t refined = den <= (((int128_t)1) << 52) ? den * 1024 : den;
+  for (const int128_t d : {refined, den}) {
+    int128_t low_num = INT64_MIN;
+    int128_t high_num = INT64_MAX;
+    if (!low_inf) {
+      const int128_t scaled = (int128_t)low.get_num() * d;
+      low_num = -floor_div(-scaled, low.get_den());
+      if (low_strict && scaled % low.get_den() == 0) low_num++;
+    }
+    if (!high_inf) {
+      const int128_t scaled = (int128_t)high.get_num() * d;
+      high_num = floor_div(scaled, high.get_den());
+      if (high_strict && scaled % high.get_den() == 0) high_num--;
+    }
+    // numerators outside int64 only shrink the range, unless all of it is
+    if (low_num > INT64_MAX || high_num < INT64_MIN) continue;
+    low_num = clamp_to_int64(low_num);
+    high_num = clamp_to_int64(high_num);
+    if (low_num > high_num) continue;
+    std::uniform_int_distribution<int64_t> gen((int64_t)low_num,
+                                               (int64_t)high_num);
+    value = Rational((int128_t)gen(g), d);
+    return true;
+  }
+  return false;
+}
+
+std::ostream& operator<<(std::ostream& os, const RealInterval& interval) {
+  if (interval.is_bottom()) {
+    os << "EMPTY";
+    return os;
+  }
+  if (interval.low_inf) {
+    os << "(MINF";
+  } else {
+    os << (interval.low_strict ? "(" : "[") << interval.low;
+  }
+  os << ",";
+  if (interval.high_inf) {
+    os << "INF)";
+  } else {
+    os << interval.high << (interval.high_strict ? ")" : "]");
+  }
+  return os;
+}
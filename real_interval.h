@@ -0,0 +1,101 @@
+#ifndef MEGASAMPLER_REAL_INTERVAL_H
+#define MEGASAMPLER_REAL_INTERVAL_H
+
+#include <z3++.h>
+
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "intervalmap.h"
+#include "linear.h"
+
+/* thrown when the result of an operation on Rationals doesn't fit in int64 */
+class RationalOverflow : public std::exception {};
+
+/* num/den in lowest terms, with den > 0 and both in int64 */
+class Rational {
+  int64_t num;
+  int64_t den;
+
+ public:
+  Rational() : num(0), den(1){};
+  Rational(int64_t n) : num(n), den(1){};  // implicit, for integer constants
+  /* reduces n/d, throws RationalOverflow if it doesn't fit */
+  Rational(int128_t n, int128_t d);
+
+  [[nodiscard]] int64_t get_num() const { return num; }
+  [[nodiscard]] int64_t get_den() const { return den; }
+  [[nodiscard]] bool is_integer() const { return den == 1; }
+  [[nodiscard]] int128_t floor() const { return floor_div(num, den); }
+  [[nodiscard]] int128_t ceil() const { return -floor_div(-(int128_t)num, den); }
+  /* "n" or "n/d", as z3 prints numerals */
+  [[nodiscard]] std::string to_string() const;
+
+  Rational operator-() const { return Rational(-(int128_t)num, den); }
+  friend Rational operator+(const Rational& a, const Rational& b);
+  friend Rational operator-(const Rational& a, const Rational& b);
+  friend Rational operator*(const Rational& a, const Rational& b);
+  friend Rational operator/(const Rational& a, const Rational& b);
+  friend bool operator<(const Rational& a, const Rational& b);
+  friend bool operator==(const Rational& a, const Rational& b) {
+    return a.num == b.num && a.den == b.den;
+  }
+  friend bool operator<=(const Rational& a, const Rational& b) {
+    return !(b < a);
+  }
+  friend bool operator>(const Rational& a, const Rational& b) { return b < a; }
+  friend bool operator>=(const Rational& a, const Rational& b) {
+    return !(a < b);
+  }
+  friend std::ostream& operator<<(std::ostream& os, const Rational& r) {
+    return os << r.to_string();
+  }
+};
+
+/*
+ * Reads an Int or Real numeral. Returns false if it doesn't fit in a
+ * Rational.
+ */
+bool numeral_to_rational(const z3::expr& numeral, Rational& value);
+
+/*
+ * Interval over the reals, each bound is infinite, strict or non-strict.
+ */
+class RealInterval {
+  Rational low;
+  Rational high;
+  bool low_inf = true;
+  bool high_inf = true;
+  bool low_strict = false;
+  bool high_strict = false;
+
+ public:
+  /* initialized to the infinite interval */
+  RealInterval() = default;
+  void set_upper_bound(const Rational& u_bound, bool strict);
+  void set_lower_bound(const Rational& l_bound, bool strict);
+  [[nodiscard]] const Rational& get_low() const { return low; }
+  [[nodiscard]] const Rational& get_high() const { return high; }
+  [[nodiscard]] bool is_low_minf() const { return low_inf; }
+  [[nodiscard]] bool is_high_inf() const { return high_inf; }
+  [[nodiscard]] bool is_low_strict() const { return low_strict; }
+  [[nodiscard]] bool is_high_strict() const { return high_strict; }
+  /* empty interval */
+  [[nodiscard]] bool is_bottom() const;
+  [[nodiscard]] bool is_in_range(const Rational& value) const;
+  /*
+   * Draws a uniform value among the multiples of 1/D in the interval, where D
+   * is a multiple of the denominators of the bounds. Returns false if there
+   * is none.
+   */
+  bool random_in_range(std::mt19937& g, Rational& value) const;
+  friend std::ostream& operator<<(std::ostream& os,
+                                  const RealInterval& interval);
+};
+
+typedef std::unordered_map<z3::expr, RealInterval> RealIntervalMap;
+
+#endif  // MEGASAMPLER_REAL_INTERVAL_H
@@ -0,0 +1,45 @@
+#ifndef MEGASAMPLER_REGION_H
+#define MEGASAMPLER_REGION_H
+
+#include <z3++.h>
+
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "intervalmap.h"
+
+/*
+ * A set of integer points around the seed that is richer than a box. For the
+ * variables it covers, MEGASampler draws the values from the region instead
+ * of from their intervals; the interval map keeps a bounding box of them.
+ */
+class Region {
+ public:
+  virtual ~Region() {}
+
+  [[nodiscard]] bool contains(const z3::expr& var) const {
+    return var_index.count(var) > 0;
+  }
+  [[nodiscard]] const std::vector<z3::expr>& get_vars() const { return vars; }
+  /*
+   * Draws a point, with values in the order of get_vars(). Returns false if
+   * the draw failed and has to be rejected.
+   */
+  virtual bool sample(std::mt19937& g, std::vector<int64_t>& point) = 0;
+  /* the region as a formula, for blocking */
+  [[nodiscard]] virtual z3::expr to_expr(z3::context& c) const = 0;
+
+ protected:
+  std::vector<z3::expr> vars;
+  std::unordered_map<z3::expr, unsigned int> var_index;
+
+  unsigned int add_var(const z3::expr& var) {
+    const auto res = var_index.emplace(var, vars.size());
+    if (res.second) vars.push_back(var);
+    return res.first->second;
+  }
+};
+
+#endif  // MEGASAMPLER_REGION_H
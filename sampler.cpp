@@ -1,8 +1,21 @@
 #include "sampler.h"
 
+#include <climits>
 #include <filesystem>
 #include <fstream>
 
+/*
+ * A value of a model as samples write it: n or n/d for numbers, 0 or 1 for
+ * bools, hex for bit-vectors
+ */
+static std::string value_string(const z3::expr &value, Z3_context ctx) {
+    if (value.is_bool()) return std::to_string(value.bool_value() == Z3_L_TRUE);
+    if (value.is_bv() && value.is_numeral()) return bv_string(value, ctx);
+    std::string number;
+    if (value.is_numeral(number)) return number;
+    return value.to_string();
+}
+
 /**
  * \brief Sampler base class
  */
@@ -16,13 +29,17 @@ Sampler::Sampler(z3::context *_c, const std::string &_input,
       model(c),
       opt(c),
       solver(c),
+      watchdog(c),
       input_filename(_input),
       output_dir(_output_dir),
       config(config) {
     z3::set_param("rewriter.expand_select_store", "true");
     // Parallel makes it ignore the timeout :(
     // z3::set_param("parallel.enable", "true");
-    params.set(":timeout", 50000u);
+    // the watchdog times the checks out: z3 looks at its own timeout only now
+    // and then, and the timer of z3 4.8.12 can deadlock when it fires
+    params.set(":timeout", UINT_MAX);
+    params.set("timeout", UINT_MAX);
     opt.set(params);
     solver.set(params);
 
@@ -45,16 +62,16 @@ Sampler::Sampler(z3::context *_c, const std::string &_input,
     json_filename = output_base + ".json";
     if (!config.no_write) results_file.open(output_base + ".samples");
 
-    if (num_bv > 0 || num_uf > 0 || num_reals > 0) {
-        std::cout << "Unsupported sort in formula. Exiting.\n";
-        failure_cause = "Unsupported sort in formula.";
-        safe_exit(1);
-    }
-
     if (num_arrays > 0) {
         has_arrays = true;
     }
 
+    if (config.coverage) {
+        coverage = std::make_unique<WireCoverage>(original_formula);
+        std::cout << "Tracking wire coverage over " << coverage->get_total()
+                  << " wires\n";
+    }
+
     if (false && num_bools > 0) {
         // Are boolean vars actually fine ... ?
         std::cout << "Currently not supporting boolean vars in formula.\n";
@@ -92,6 +109,18 @@ double Sampler::get_time_left(const std::string &t) {
     return std::min(ret, get_time_left("total"));
 }
 
+Watchdog::time_point Sampler::deadline(const std::string &t,
+                                      unsigned timeout_ms) {
+    double left = max_times[t] - elapsed_time_from(timer_start_times[t]);
+    if ("total" != t)
+        left = std::min(left, max_times["total"] -
+                                  elapsed_time_from(timer_start_times["total"]));
+    left = std::min(std::max(left, 0.0), timeout_ms / 1000.0);
+    return std::chrono::steady_clock::now() +
+           std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+               std::chrono::duration<double>(left));
+}
+
 double Sampler::elapsed_time_from(struct timespec start) {
     struct timespec end;
     clock_gettime(CLOCK_REALTIME, &end);
@@ -135,26 +164,27 @@ void Sampler::check_if_satisfiable() {
 z3::check_result Sampler::solve(const std::string &timer_category,
                                 bool solve_opt) {
     z3::check_result res = z3::unknown;
+    if (seed_found_elsewhere()) return res;
     if (solve_opt) {  // using MAX-SMT after setting timeout
         try {
             max_smt_calls++;
             const unsigned timeout = std::min<unsigned>(
                 1000 * 60 * 5,
                 static_cast<unsigned>(250 * get_time_left(timer_category)));
-            params.set(":timeout", timeout);
-            params.set("timeout", timeout);
-
+            Watchdog::Guard guard(watchdog, deadline(timer_category, timeout));
             opt.set(params);
             res = opt.check();  // bat: first, solve a MAX-SMT instance
         } catch (const z3::exception &except) {
             std::cout << "Exception: " << except << "\n";
-            // TODO exception "canceled" can be thrown when Timeout is reached
+            // not a timeout: a check the watchdog interrupts returns unknown
             failure_cause = "MAX-SMT exception";
             safe_exit(1);
         }
     }
     if (res == z3::sat) {
         model = opt.get_model();
+    } else if (res == z3::unknown && seed_found_elsewhere()) {
+        return res;  // interrupted
     } else if (res == z3::unknown) {  // if MAX-SMT is not solved successfully, call SMT
         if (solve_opt) std::cout << "MAX-SMT returned 'unknown' (timeout?)\n";
         is_time_limit_reached();
@@ -162,12 +192,14 @@ z3::check_result Sampler::solve(const std::string &timer_category,
             smt_calls++;
             const unsigned timeout =
                 static_cast<unsigned>(1000 * get_time_left(timer_category));
-            params.set(":timeout", timeout);
-            params.set("timeout", timeout);
+            Watchdog::Guard guard(watchdog, deadline(timer_category, timeout));
 
             solver.set(params);
-            res = solver.check();  // bat: if too long, solve a regular SMT instance
-                                   // (without any soft constraints)
+            const z3::expr_vector assumptions = solver_assumptions();
+            // bat: if too long, solve a regular SMT instance (without any
+            // soft constraints)
+            res = assumptions.empty() ? solver.check()
+                                      : solver.check(assumptions);
         } catch (const z3::exception &except) {
             std::cout << "Exception: " << except << "\n";
             std::stringstream ss;
@@ -204,9 +236,27 @@ bool Sampler::is_time_limit_reached() {
         failure_cause = "Timeout.";
         safe_exit(0);
     }
+    if (is_coverage_plateau_reached()) {
+        std::cout << "Stopping: coverage plateau\n";
+        failure_cause = "Coverage plateau.";
+        safe_exit(0);
+    }
     return false;
 }
 
+bool Sampler::is_coverage_plateau_reached() {
+    if (!coverage || config.coverage_plateau <= 0.0) return false;
+    const double now = get_elapsed_time();
+    const double window = now - coverage_checkpoint_time;
+    if (window < COVERAGE_PLATEAU_WINDOW) return false;
+    const double gain = coverage->get_ratio() - coverage_checkpoint;
+    coverage_checkpoint = coverage->get_ratio();
+    coverage_checkpoint_time = now;
+    if (debug)
+        std::cout << "coverage gain rate: " << gain / window << " per second\n";
+    return gain / window < config.coverage_plateau;
+}
+
 void Sampler::set_exit() volatile { should_exit = true; }
 
 void Sampler::finish() {  // todo: remove exit and add where calling
@@ -236,6 +286,8 @@ void Sampler::write_json() {
     json_output["epochs"] = epochs;
     json_output["maxsmt calls"] = max_smt_calls;
     json_output["smt calls"] = smt_calls;
+    json_output["watchdog interrupts"] =
+        (Json::UInt64)watchdog.get_interrupts();
     json_output["total samples"] = (Json::UInt64)total_samples;
     json_output["valid samples"] = (Json::UInt64)valid_samples;
     json_output["unique valid samples"] = (Json::UInt64)unique_valid_samples;
@@ -260,6 +312,18 @@ void Sampler::write_json() {
     json_output["options"]["debug"] = config.debug;
     json_output["options"]["one epoch"] = config.one_epoch;
     json_output["options"]["no samples output"] = config.no_write;
+    json_output["options"]["coverage plateau"] = config.coverage_plateau;
+    json_output["seeds"]["mode"] =
+        config.seed_mode == MeGA::SEED_MODE_CHEAP ? "cheap" : "maxsmt";
+    json_output["seeds"]["average distance"] =
+        seed_distances ? total_seed_distance / seed_distances : 0.0;
+    if (coverage) {
+        json_output["wire coverage"]["covered"] =
+            (Json::UInt64)coverage->get_covered();
+        json_output["wire coverage"]["total"] =
+            (Json::UInt64)coverage->get_total();
+        json_output["wire coverage"]["ratio"] = coverage->get_ratio();
+    }
 
     Json::StreamWriterBuilder builder;
     builder["indentation"] = " ";
@@ -283,6 +347,13 @@ void Sampler::print_stats() {
     std::cout << "Models (with repetitions): " << valid_samples << '\n';
     std::cout << "Unique models (# samples in file): " << unique_valid_samples
               << '\n';
+    if (seed_distances)
+        std::cout << "Average distance between seeds: "
+                  << total_seed_distance / seed_distances << '\n';
+    if (coverage)
+        std::cout << "Wire coverage: " << coverage->get_covered() << "/"
+                  << coverage->get_total() << " (" << coverage->get_ratio()
+                  << ")\n";
     std::cout << "-----------------------------------" << std::endl;
 }
 
@@ -293,41 +364,159 @@ z3::model Sampler::start_epoch() {
     if (debug)
         std::cout << "Sampler: Starting an epoch (" << epochs << ")" << std::endl;
 
-    if (!config.blocking)
+    const z3::check_result res = find_seed();
+
+    epochs++;
+    total_samples++;
+
+    if (res == z3::sat) {
+        record_seed_distance(model);
+        save_and_output_sample_if_unique(model_to_string(model));
+    }
+
+    if (config.debug) std::cout << "finished start epoch\n";
+
+    return model;
+}
+
+z3::check_result Sampler::find_seed() {
+    const bool use_opt =
+        !config.blocking && config.seed_mode == MeGA::SEED_MODE_MAXSMT;
+    if (use_opt)
         opt.push();  // because formula is constant, but other hard/soft constraints
                      // change between epochs
 
     if (config.blocking) {  // not first epoch
         add_blocking_soft_constraints();
-    } else {  // first epoch
+    } else if (use_opt) {  // first epoch
         choose_random_assignment();
     }
-    
+
     z3::check_result res =
-        solve("epoch", !config.blocking && !config.avoid_maxsmt);
+        config.seed_mode == MeGA::SEED_MODE_CHEAP
+            ? solve_cheap("epoch")
+            : solve("epoch", !config.blocking && !config.avoid_maxsmt);
 
     if (config.debug)
         std::cout << "start epoch, after solve, res: " << res << '\n';
 
-    if (config.blocking && res == z3::unsat) {
-        /* we blocked everything, lets start over */
-        solver.pop();
-        solver.push();
-        res = solve("epoch", false);
-        if (config.debug) std::cout << "second solve, res: " << res << '\n';
+    /* we blocked everything, lift blocking constraints until sat */
+    while (config.blocking && res == z3::unsat &&
+           retract_blocking_constraints()) {
+        res = config.seed_mode == MeGA::SEED_MODE_CHEAP ? solve_cheap("epoch")
+                                                        : solve("epoch", false);
+        if (config.debug)
+            std::cout << "solve after retraction, res: " << res << '\n';
     }
 
     assert(res != z3::unsat);
-    if (!config.blocking) opt.pop();
+    if (use_opt) opt.pop();
+    return res;
+}
 
-    epochs++;
-    total_samples++;
+z3::expr_vector Sampler::choose_random_targets(
+    const std::vector<z3::func_decl> &candidate_variables) {
+    std::vector<const z3::func_decl *> candidates;
+    for (const z3::func_decl &v : candidate_variables) {
+        if (v.arity() > 0 || v.range().is_array()) continue;
+        candidates.push_back(&v);
+    }
+    z3::expr_vector targets(c);
+    for (unsigned int i = 0; i < CHEAP_SEED_TARGETS && !candidates.empty();
+         ++i) {
+        const size_t k = rand() % candidates.size();
+        const z3::expr v = (*candidates[k])();
+        candidates[k] = candidates.back();
+        candidates.pop_back();
+        const bool below = rand() % 2;
+        const int random = rand();
+        switch (v.get_sort().sort_kind()) {
+            case Z3_BOOL_SORT:
+                targets.push_back(below ? !v : v);
+                break;
+            case Z3_INT_SORT: {
+                const z3::expr value = c.int_val(rand() % 2 ? random : -random);
+                targets.push_back(below ? v <= value : v >= value);
+            } break;
+            case Z3_REAL_SORT: {
+                const z3::expr value = c.real_val(rand() % 2 ? random : -random);
+                targets.push_back(below ? v <= value : v >= value);
+            } break;
+            case Z3_BV_SORT: {
+                const unsigned int width = v.get_sort().bv_size();
+                const uint64_t bits = ((uint64_t)rand() << 32) ^ rand();
+                const z3::expr value = c.bv_val(
+                    width < 64 ? bits & (((uint64_t)1 << width) - 1) : bits,
+                    width);
+                targets.push_back(below ? z3::ule(v, value) : z3::uge(v, value));
+            } break;
+            default:
+                break;
+        }
+    }
+    return targets;
+}
 
-    if (res == z3::sat) save_and_output_sample_if_unique(model_to_string(model));
+z3::check_result Sampler::solve_cheap(const std::string &timer_category) {
+    const z3::expr_vector blocking = solver_assumptions();
+    z3::expr_vector targets = choose_random_targets(variables);
+    const unsigned timeout =
+        static_cast<unsigned>(1000 * get_time_left(timer_category));
+    params.set("random_seed", static_cast<unsigned>(rand()));
+    params.set("phase_selection", 5u);  // random
+    solver.set(params);
 
-    if (config.debug) std::cout << "finished start epoch\n";
+    z3::check_result res = z3::unknown;
+    while (true) {
+        z3::expr_vector assumptions(c);
+        for (unsigned int i = 0; i < blocking.size(); ++i)
+            assumptions.push_back(blocking[i]);
+        for (unsigned int i = 0; i < targets.size(); ++i)
+            assumptions.push_back(targets[i]);
+        try {
+            smt_calls++;
+            Watchdog::Guard guard(watchdog, deadline(timer_category, timeout));
+            res = assumptions.empty() ? solver.check()
+                                      : solver.check(assumptions);
+        } catch (const z3::exception &except) {
+            std::cout << "Exception: " << except << "\n";
+            std::stringstream ss;
+            ss << except;
+            failure_cause = "SMT (z3) exception: " + ss.str();
+            safe_exit(1);
+        }
+        if (res != z3::unsat || targets.empty()) break;
+        // drop the targets in conflict, or all of them
+        std::unordered_set<unsigned int> core;
+        const z3::expr_vector unsat_core = solver.unsat_core();
+        for (unsigned int i = 0; i < unsat_core.size(); ++i)
+            core.insert(unsat_core[i].id());
+        z3::expr_vector kept(c);
+        for (unsigned int i = 0; i < targets.size(); ++i)
+            if (!core.count(targets[i].id())) kept.push_back(targets[i]);
+        if (kept.size() == targets.size()) kept = z3::expr_vector(c);
+        targets = kept;
+        is_time_limit_reached();
+    }
+    if (debug) std::cout << "SMT result: " << res << "\n";
+    if (res == z3::sat) model = solver.get_model();
+    return res;
+}
 
-    return model;
+void Sampler::record_seed_distance(const z3::model &seed) {
+    std::vector<std::string> values;
+    for (const z3::func_decl &v : variables) {
+        if (v.arity() > 0) continue;
+        values.push_back(seed.eval(v(), true).to_string());
+    }
+    if (!previous_seed.empty() && !values.empty()) {
+        unsigned long differing = 0;
+        for (size_t i = 0; i < values.size(); ++i)
+            if (values[i] != previous_seed[i]) differing++;
+        total_seed_distance += (double)differing / values.size();
+        seed_distances++;
+    }
+    previous_seed = std::move(values);
 }
 
 void Sampler::choose_random_assignment() {
@@ -377,8 +566,14 @@ void Sampler::choose_random_assignment() {
                 else
                     assert_soft(v() == c.int_val(-random));
             } break;  // from switch, int case
+            case Z3_REAL_SORT: {
+                const int random = rand();
+                if (rand() % 2)
+                    assert_soft(v() == c.real_val(random));
+                else
+                    assert_soft(v() == c.real_val(-random));
+            } break;  // from switch, real case
             default:
-                // TODO add real
                 std::cout << "Invalid sort\n";
                 failure_cause = "Invalid sort.";
                 safe_exit(1);
@@ -386,6 +581,17 @@ void Sampler::choose_random_assignment() {
     }  // end for: random assignment chosen
 }
 
+z3::expr_vector Sampler::solver_assumptions() { return z3::expr_vector(c); }
+
+bool Sampler::seed_found_elsewhere() { return false; }
+
+bool Sampler::retract_blocking_constraints() {
+    // the formula itself is sat, so a single retraction is enough
+    solver.pop();
+    solver.push();
+    return true;
+}
+
 void Sampler::add_blocking_soft_constraints() {
     if (debug) std::cout << "Using blocking :)\n";
     for (unsigned int i = 0; i < model.num_consts(); ++i) {
@@ -404,6 +610,17 @@ void Sampler::do_epoch(__attribute__((unused)) const z3::model &m) {
     std::cout << "Sampler: Epoch: keeping only original model" << std::endl;
 }
 
+void Sampler::record_epoch_stats() {
+    if (!config.json || !coverage) return;
+    Json::Value epoch_stats;
+    epoch_stats["epoch"] = epochs;
+    epoch_stats["time"] = get_elapsed_time();
+    epoch_stats["unique valid samples"] = (Json::UInt64)unique_valid_samples;
+    epoch_stats["epoch samples"] = (Json::UInt64)epoch_samples;
+    epoch_stats["wire coverage"] = coverage->get_ratio();
+    json_output["epoch stats"].append(epoch_stats);
+}
+
 void Sampler::compute_and_print_formula_stats() {
     // TODO save formula theory
     _compute_formula_stats_aux(original_formula);
@@ -487,6 +704,11 @@ bool Sampler::save_and_output_sample_if_unique(const std::string &sample) {
             results_file << unique_valid_samples << ": " << sample << '\n';
     }
     accumulate_time("output");
+    if (res.second && coverage) {
+        set_timer_on("coverage");
+        coverage->add_sample(sample);
+        accumulate_time("coverage");
+    }
     if (unique_valid_samples >= config.max_samples) {
         failure_cause = "Reached max samples.";
         safe_exit(0);
@@ -519,14 +741,14 @@ std::string Sampler::model_to_string(const z3::model &m) {
                 s += '[';
                 s += std::to_string(f.num_entries());
                 s += ',';
-                s += std::to_string(f.else_value());
+                s += value_string(f.else_value(), c);
                 s += ',';
                 if (config.debug)
                     std::cout << "s: " << s << ", f num_entries: " << f.num_entries() << '\n';
                 for (size_t j = 0; j < f.num_entries(); ++j) {
-                    s += std::to_string(f.entry(j).arg(0));
+                    s += value_string(f.entry(j).arg(0), c);
                     s += "->";
-                    s += std::to_string(f.entry(j).value());
+                    s += value_string(f.entry(j).value(), c);
                     s += ',';
                 }
                 s += "];";
@@ -536,19 +758,19 @@ std::string Sampler::model_to_string(const z3::model &m) {
                 std::vector<std::string> args;
                 std::vector<std::string> values;
                 while (e.decl().name().str() == "store") {
-                    std::string arg = std::to_string(e.arg(1));
+                    std::string arg = value_string(e.arg(1), c);
                     if (std::find(args.begin(), args.end(), arg) != args.end()) {
                         e = e.arg(0);
                         continue;
                     }
                     args.push_back(arg);
-                    values.push_back(std::to_string(e.arg(2)));
+                    values.push_back(value_string(e.arg(2), c));
                     e = e.arg(0);
                 }
                 s += "[";
                 s += std::to_string(args.size());
                 s += ',';
-                s += std::to_string(e.arg(0));
+                s += value_string(e.arg(0), c);
                 s += ',';
                 for (int j = args.size() - 1; j >= 0; --j) {
                     s += args[j];
@@ -559,7 +781,7 @@ std::string Sampler::model_to_string(const z3::model &m) {
                 s += "];";
             }
 
-        } else if (v.is_const()) {  // BV, Int case
+        } else if (v.is_const()) {  // BV, Int, Real case
             s += v.name().str();
             s += ':';
             z3::expr b = m.get_const_interp(v);
@@ -580,6 +802,7 @@ std::string Sampler::model_to_string(const z3::model &m) {
                     }
                     break;
                 case Z3_INT_SORT:
+                case Z3_REAL_SORT:  // n or n/d
                     if (!ast) {
                         s += std::to_string(0);
                     } else {
@@ -601,16 +824,13 @@ std::string Sampler::model_to_string(const z3::model &m) {
             num += std::to_string(f.num_entries());
             s += num;
             s += ';';
-            std::string def = std::to_string(f.else_value());
-            s += def;
+            s += value_string(f.else_value(), c);
             s += ';';
             for (size_t j = 0; j < f.num_entries(); ++j) {
                 for (size_t k = 0; k < f.entry(j).num_args(); ++k) {
-                    std::string arg = std::to_string(f.entry(j).arg(k));
-                    s += arg + ':';
+                    s += value_string(f.entry(j).arg(k), c) + ':';
                 }
-                std::string val = std::to_string(f.entry(j).value());
-                s += val + ',';
+                s += value_string(f.entry(j).value(), c) + ',';
             }
             s += ");";
         }
@@ -661,6 +881,7 @@ void Sampler::safe_exit(int exitcode) {
     } else {
         result = "success";
     }
+    watchdog.stop();
     finish();
     exit(exitcode);
 }
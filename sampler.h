@@ -7,11 +7,14 @@
 #include <algorithm>  // for std::find
 #include <fstream>    //for results_file
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_set>
 #include <vector>
 
+#include "coverage.h"
 #include "sampler_config.h"
+#include "watchdog.h"
 
 Z3_ast parse_bv(char const *n, Z3_sort s, Z3_context ctx);
 std::string bv_string(Z3_ast ast, Z3_context ctx);
@@ -30,6 +33,7 @@ class Sampler {
     z3::model model;
     z3::optimize opt;
     z3::solver solver;
+    Watchdog watchdog;  // interrupts the checks that outlive their timer
 
     // Samples
     std::ofstream results_file;
@@ -57,7 +61,7 @@ class Sampler {
     std::vector<z3::func_decl> variables;          // function declarations in formulas
     std::vector<std::string> variable_names;       // used for model Record the names of the variables in the model (excluding uninterpreted functions)
     std::unordered_set<std::string> var_names = {  // variable names in formulas
-        "bv", "Int", "true",
+        "bv", "Int", "Real", "true",
         "false"};                    // initialize with constant names so that
                                      // constants are not mistaken for variables
     int max_depth = 0;               // AST max depth
@@ -83,10 +87,25 @@ class Sampler {
             // the size of the samples set and the number of lines in the results
             // file)
 
+    // Seed diversity: distance between the seeds of successive epochs
+    std::vector<std::string> previous_seed;  // values of the variables
+    double total_seed_distance = 0.0;
+    unsigned long seed_distances = 0;
+    // variables with a random target in --seed-mode=cheap
+    static constexpr unsigned int CHEAP_SEED_TARGETS = 4;
+
+    // Online wire coverage (--coverage)
+    std::unique_ptr<WireCoverage> coverage;
+    double coverage_checkpoint = 0.0;       // coverage at the last plateau check
+    double coverage_checkpoint_time = 0.0;  // elapsed time at the last check
+    static constexpr double COVERAGE_PLATEAU_WINDOW = 5.0;  // seconds
+
     // Methods
     double duration(struct timespec *a, struct timespec *b);     // duration
     double elapsed_time_from(struct timespec start);             // the time elapsed since start
     double get_time_left(const std::string &category);           // the time remaining on a timer
+    /* when a check started now must end: within timeout_ms and the timer */
+    Watchdog::time_point deadline(const std::string &category, unsigned timeout_ms);
     void parse_formula(const std::string &input);                // parsing Input Files
     void compute_and_print_formula_stats();                      // calculate and output information to the formula
     void _compute_formula_stats_aux(z3::expr e, int depth = 0);  // calculation formula information
@@ -96,10 +115,42 @@ class Sampler {
      * adds equivalence constraints as soft constraints to opt.
      */
     void choose_random_assignment();
+    /*
+     * Random targets for a few random candidate variables: a value for a
+     * bool, a half-line through a random value for the others.
+     */
+    z3::expr_vector choose_random_targets(
+        const std::vector<z3::func_decl> &candidate_variables);
+    /*
+     * Solves with solver only (--seed-mode=cheap), with a fresh random seed,
+     * random phases and the random targets as assumptions. The targets of an
+     * unsat core are dropped and the solver is called again.
+     */
+    z3::check_result solve_cheap(const std::string &timer_category);
+    /*
+     * Records the fraction of the variables whose value in seed differs from
+     * the previous seed.
+     */
+    void record_seed_distance(const z3::model &seed);
     /*
      * Adds negation of previous model as soft constraints to opt.
      */
     virtual void add_blocking_soft_constraints();
+    /*
+     * Assumptions passed to solver.check, none by default.
+     */
+    virtual z3::expr_vector solver_assumptions();
+    /*
+     * Called when blocking made the formula unsat. Lifts blocking constraints
+     * (by default all of them, by popping the solver) and returns false if
+     * there were none left to lift.
+     */
+    virtual bool retract_blocking_constraints();
+    /*
+     * Returns true if the seed of the epoch was found without z3, which then
+     * got interrupted. solve() doesn't fall back to the SMT solver then.
+     */
+    virtual bool seed_found_elsewhere();
     /*
      * Tries to solve optimized formula (using opt) - if solve_opt is enabled.
      * If too long, resorts to regular formula (using solver).
@@ -117,6 +168,11 @@ class Sampler {
      * Writes statistics to a newly created json file in json_dir.
      */
     void write_json();
+    /*
+     * Returns true if wire coverage grew by less than config.coverage_plateau
+     * per second over the last COVERAGE_PLATEAU_WINDOW seconds.
+     */
+    bool is_coverage_plateau_reached();
 
    public:
     /*
@@ -143,6 +199,11 @@ class Sampler {
      * Generates and returns a model to begin a new epoch.
      */
     virtual z3::model start_epoch();
+    /*
+     * Finds the seed of the epoch and puts it in model: MAX-SMT with random
+     * soft constraints, or SMT under the blocking constraints.
+     */
+    virtual z3::check_result find_seed();
     /*
      * Sampling epoch: generates multiple valid samples from the given model.
      * Whenever a sample is produced we check if it was produced before (i.e.,
@@ -160,6 +221,11 @@ class Sampler {
      * start_epoch was last called).
      */
     double get_epoch_elapsed_time();
+    /*
+     * Appends the statistics of the epoch that just ended to the json output
+     * (only when coverage tracking is enabled).
+     */
+    virtual void record_epoch_stats();
     /*
      * Prints stats and closes results file.
      */
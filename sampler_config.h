@@ -9,6 +9,15 @@ namespace MeGA {
 
 enum algorithm { ALGO_UNSET = 0, ALGO_MEGA, ALGO_MEGAB, ALGO_SMT, ALGO_Z3 };
 enum { STRAT_SMTBIT, STRAT_SMTBV, STRAT_SAT };
+enum epoch_policy { EPOCH_POLICY_LEGACY = 0, EPOCH_POLICY_ADAPTIVE };
+enum strengthen_engine {
+  STRENGTHEN_LEGACY = 0,
+  STRENGTHEN_VOLUME,
+  STRENGTHEN_OCTAGON,
+  STRENGTHEN_POLYTOPE
+};
+enum seed_mode { SEED_MODE_MAXSMT = 0, SEED_MODE_CHEAP };
+enum disjunct_policy { DISJUNCT_POLICY_UNIFORM = 0, DISJUNCT_POLICY_UCB };
 
 struct SamplerConfig {
   SamplerConfig(bool blocking, bool one_epoch, bool debug, bool exhaust_epoch,
@@ -16,7 +25,15 @@ struct SamplerConfig {
                 unsigned long max_samples, unsigned long max_epoch_samples,
                 unsigned long max_time, unsigned long max_epoch_time,
                 unsigned long strategy, bool json, bool no_write,
-                double min_rate, unsigned long num_rounds)
+                double min_rate, unsigned long num_rounds, bool coverage,
+                double coverage_plateau, enum epoch_policy epoch_policy,
+                bool volume_weighted, bool box_cache,
+                enum strengthen_engine strengthen_engine,
+                bool graceful_strengthening, enum seed_mode seed_mode,
+                bool local_search, unsigned long seed_chaining,
+                unsigned long implicants,
+                enum disjunct_policy disjunct_policy, bool decompose,
+                bool eliminate_equalities)
       : blocking(blocking),
         one_epoch(one_epoch),
         debug(debug),
@@ -31,7 +48,21 @@ struct SamplerConfig {
         max_epoch_time(max_epoch_time),
         strategy(strategy),
         min_rate(min_rate),
-        num_rounds(num_rounds) {}
+        num_rounds(num_rounds),
+        coverage(coverage),
+        coverage_plateau(coverage_plateau),
+        epoch_policy(epoch_policy),
+        volume_weighted(volume_weighted),
+        box_cache(box_cache),
+        strengthen_engine(strengthen_engine),
+        graceful_strengthening(graceful_strengthening),
+        seed_mode(seed_mode),
+        local_search(local_search),
+        seed_chaining(seed_chaining),
+        implicants(implicants),
+        disjunct_policy(disjunct_policy),
+        decompose(decompose),
+        eliminate_equalities(eliminate_equalities) {}
 
   const bool blocking;
   const bool one_epoch;
@@ -48,6 +79,20 @@ struct SamplerConfig {
   const unsigned long strategy;
   const double min_rate;
   const unsigned long num_rounds;
+  const bool coverage;
+  const double coverage_plateau;
+  const enum epoch_policy epoch_policy;
+  const bool volume_weighted;
+  const bool box_cache;
+  const enum strengthen_engine strengthen_engine;
+  const bool graceful_strengthening;
+  const enum seed_mode seed_mode;
+  const bool local_search;
+  const unsigned long seed_chaining;
+  const unsigned long implicants;  // per seed
+  const enum disjunct_policy disjunct_policy;
+  const bool decompose;
+  const bool eliminate_equalities;
 };
 
 }  // namespace MeGA
@@ -0,0 +1,156 @@
+"""Compare how well sampling engines mix: the box sampler (--strengthen=legacy)
+against the hit-and-run walk (--strengthen=polytope), or any other engines.
+
+For every formula and engine, megasampler is run and the stream of emitted
+samples is read back. For every integer variable the integrated
+autocorrelation time of its values (Geyer's initial positive sequence) is
+computed; the effective sample size is the number of samples divided by it.
+The table reports the worst (largest) autocorrelation time, the smallest
+effective sample size over all variables, and effective samples per second.
+"""
+import argparse
+import json
+import pathlib
+import re
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+PARSER = argparse.ArgumentParser(description="Mixing-time benchmark")
+PARSER.add_argument(
+    "formulas", metavar="FILE", type=pathlib.Path, nargs="+", help="Formulas"
+)
+PARSER.add_argument(
+    "-b",
+    "--binary",
+    metavar="FILE",
+    type=pathlib.Path,
+    default=pathlib.Path(__file__).resolve().parent.parent / "megasampler",
+    help="megasampler binary",
+)
+PARSER.add_argument(
+    "-e",
+    "--engines",
+    default="legacy,polytope",
+    help="Comma separated --strengthen engines to compare",
+)
+PARSER.add_argument("-n", "--samples", type=int, default=10000)
+PARSER.add_argument("-t", "--time", type=int, default=60)
+PARSER.add_argument(
+    "-o",
+    "--output-dir",
+    metavar="DIR",
+    type=pathlib.Path,
+    help="Keep the samples here (default: temporary directory)",
+)
+
+INT_ASSIGNMENT = re.compile(r"([^:;\[\]]+):(-?\d+);")
+
+
+def read_samples(samples_file: pathlib.Path):
+    series = {}
+    with open(samples_file) as f:
+        for line in f:
+            _, _, sample = line.partition(": ")
+            for name, value in INT_ASSIGNMENT.findall(sample):
+                series.setdefault(name, []).append(int(value))
+    return series
+
+
+def autocorrelation_time(values):
+    n = len(values)
+    if n < 4:
+        return float("nan")
+    mean = statistics.fmean(values)
+    centered = [v - mean for v in values]
+    variance = sum(c * c for c in centered) / n
+    if variance == 0:
+        return float("nan")  # constant, says nothing about mixing
+
+    def rho(lag):
+        return sum(centered[i] * centered[i + lag] for i in range(n - lag)) / (
+            n * variance
+        )
+
+    # Geyer: sum pairs of lags while they stay positive
+    tau = -1.0
+    lag = 0
+    while lag + 1 < n:
+        pair = rho(lag) + rho(lag + 1)
+        if pair <= 0:
+            break
+        tau += 2 * pair
+        lag += 2
+    return max(tau, 1.0)
+
+
+def run_engine(args, formula, engine, output_dir):
+    out = output_dir / engine
+    out.mkdir(parents=True, exist_ok=True)
+    command = [
+        str(args.binary),
+        "-a",
+        "MeGA",
+        "-j",
+        "-n",
+        str(args.samples),
+        "-t",
+        str(args.time),
+        "--strengthen=" + engine,
+        "-o",
+        str(out),
+        str(formula),
+    ]
+    start = time.monotonic()
+    subprocess.run(command, stdout=subprocess.DEVNULL, check=False)
+    elapsed = time.monotonic() - start
+    samples_file = out / (formula.name + ".samples")
+    json_file = out / (formula.name + ".json")
+    if not samples_file.is_file():
+        return None
+    epochs = json.load(open(json_file)).get("epochs") if json_file.is_file() else None
+    series = read_samples(samples_file)
+    taus = {
+        name: autocorrelation_time(values) for name, values in series.items()
+    }
+    taus = {name: tau for name, tau in taus.items() if tau == tau}
+    num_samples = max((len(v) for v in series.values()), default=0)
+    worst_tau = max(taus.values(), default=float("nan"))
+    min_ess = num_samples / worst_tau if taus else float("nan")
+    return {
+        "samples": num_samples,
+        "epochs": epochs,
+        "time": elapsed,
+        "worst tau": worst_tau,
+        "min ess": min_ess,
+        "ess/sec": min_ess / elapsed if elapsed > 0 else float("nan"),
+    }
+
+
+def main():
+    args = PARSER.parse_args()
+    engines = args.engines.split(",")
+    with tempfile.TemporaryDirectory() as tmp:
+        base = args.output_dir or pathlib.Path(tmp)
+        print(
+            f"{'formula':30} {'engine':10} {'samples':>8} {'epochs':>7} "
+            f"{'time':>7} {'worst tau':>10} {'min ESS':>9} {'ESS/sec':>9}"
+        )
+        for formula in args.formulas:
+            for engine in engines:
+                res = run_engine(args, formula, engine, base / formula.stem)
+                if res is None:
+                    print(f"{formula.name:30} {engine:10} failed", file=sys.stderr)
+                    continue
+                print(
+                    f"{formula.name:30} {engine:10} {res['samples']:8} "
+                    f"{str(res['epochs']):>7} {res['time']:7.2f} "
+                    f"{res['worst tau']:10.2f} {res['min ess']:9.1f} "
+                    f"{res['ess/sec']:9.1f}"
+                )
+
+
+if __name__ == "__main__":
+    main()
@@ -8,6 +8,12 @@ SMTSampler::SMTSampler(z3::context *_c, const std::string &_input,
                        const std::string &_output_dir,
                        const MeGA::SamplerConfig &config)
     : Sampler(_c, _input, _output_dir, config) {
+  if (num_bv > 0 || num_reals > 0 || num_uf > 0) {
+    // the bit-level mutations only know Int and Bool variables
+    std::cout << "Unsupported sort in formula. Exiting.\n";
+    failure_cause = "Unsupported sort in formula.";
+    safe_exit(1);
+  }
   initialize_solvers();
   //  if (!convert) {
   ind = variables;
@@ -1,31 +1,120 @@
 #include "strengthener.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <numeric>
 
+#include "linear.h"
 #include "z3_utils.h"
 
+static bool is_bv_comparison(const z3::expr &e) {
+  if (e.num_args() != 2 || !e.arg(0).is_bv()) return false;
+  switch (get_op(e)) {
+    case Z3_OP_EQ:
+    case Z3_OP_DISTINCT:
+    case Z3_OP_ULEQ:
+    case Z3_OP_UGEQ:
+    case Z3_OP_ULT:
+    case Z3_OP_UGT:
+    case Z3_OP_SLEQ:
+    case Z3_OP_SGEQ:
+    case Z3_OP_SLT:
+    case Z3_OP_SGT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/*
+ * Int values and bounds are computed exactly in int128. A value of the seed
+ * must fit in int64; a bound past the int64 limit on the side op allows
+ * holds for every int64 value and becomes the infinity sentinel.
+ */
+static int64_t to_int64_value(int128_t value) {
+  if (value < INT64_MIN || value > INT64_MAX)
+    throw Strengthener::NoRuleForStrengthening("int64 overflow");
+  return (int64_t)value;
+}
+
+static int64_t to_int64_bound(int128_t bound, Z3_decl_kind op) {
+  if (is_op_le(op) && bound > INT64_MAX) return INT64_MAX;
+  if (is_op_ge(op) && bound < INT64_MIN) return INT64_MIN;
+  return to_int64_value(bound);
+}
+
+static Z3_decl_kind negate_bv_op(Z3_decl_kind op) {
+  switch (op) {
+    case Z3_OP_EQ: return Z3_OP_DISTINCT;
+    case Z3_OP_DISTINCT: return Z3_OP_EQ;
+    case Z3_OP_ULEQ: return Z3_OP_UGT;
+    case Z3_OP_UGEQ: return Z3_OP_ULT;
+    case Z3_OP_ULT: return Z3_OP_UGEQ;
+    case Z3_OP_UGT: return Z3_OP_ULEQ;
+    case Z3_OP_SLEQ: return Z3_OP_SGT;
+    case Z3_OP_SGEQ: return Z3_OP_SLT;
+    case Z3_OP_SLT: return Z3_OP_SGEQ;
+    case Z3_OP_SGT: return Z3_OP_SLEQ;
+    default: throw UnsupportedOperator();
+  }
+}
+
 void Strengthener::strengthen_literal(const z3::expr &literal) {
   if (debug)
     std::cout << "strengthening literal: " << literal.to_string() << "\n";
   assert(model_eval_to_bool(model, literal));
+  std::vector<z3::expr> guards;
+  const z3::expr without_ite = remove_ite(literal, guards);
+  if (!guards.empty()) {
+    // sound: on the box every guard holds, so every ite takes its branch
+    ite_rewrites++;
+    for (const auto &guard : guards) strengthen_guard(guard);
+    strengthen_literal(without_ite);
+    return;
+  }
   if (literal.is_bool() && literal.is_const()) {
-    // case e=true/false/b/!b (where b is a boolean var)
-    return;  // TODO: this is what we do in Python. Is it correct?
+    // case e=true/false/b (where b is a boolean var), the sampler pins b
+    return;
   } else if (literal.is_not()) {
     const z3::expr &argument = literal.arg(0);
     if (argument.is_const()) {
-      // case Not(true/false/b) (where b is a boolean var)
-      return;  // TODO: this is what we do in Python. Is it correct?
+      // case Not(true/false/b) (where b is a boolean var), the sampler pins b
+      return;
+    } else if (is_bv_comparison(argument)) {
+      strengthen_bv_literal(argument, true);
     } else {
       strengthen_literal(negate_condition(argument));
     }
+  } else if (is_bv_comparison(literal)) {
+    strengthen_bv_literal(literal, false);
   } else if (is_binary_boolean(literal)) {
+    if (literal.num_args() > 2) {
+      if (!is_op_distinct(get_op(literal)))
+        throw NoRuleForStrengthening(literal.decl().name().str());
+      // pairwise distinct
+      for (unsigned int i = 0; i < literal.num_args(); i++) {
+        for (unsigned int j = i + 1; j < literal.num_args(); j++) {
+          strengthen_literal(literal.arg(i) != literal.arg(j));
+        }
+      }
+      return;
+    }
+    if (literal.arg(0).is_real()) {
+      strengthen_real_literal(literal);
+      return;
+    }
+    if (!literal.arg(0).is_int())
+      throw NoRuleForStrengthening(literal.decl().name().str() + " on " +
+                                   literal.arg(0).get_sort().name().str());
+    if (!literal.arg(1).is_numeral()) {
+      // e.g. (= t (* 2 x)) from the tactic that names ite terms
+      strengthen_literal(
+          literal.decl()(literal.arg(0) - literal.arg(1), c.int_val(0)));
+      return;
+    }
     const z3::expr &lhs = literal.arg(0);
-    if (!lhs.is_int()) throw NoRuleForStrengthening();
     const z3::expr rhs = literal.arg(1);
-    to_integer(rhs);
     // turn op into >=,<=, or ==
     z3::expr literal_as_ineq(literal);
     if (literal.decl().decl_kind() == Z3_OP_DISTINCT) {
@@ -37,12 +126,114 @@ void Strengthener::strengthen_literal(const z3::expr &literal) {
     if (is_lt(literal_as_ineq) || is_gt(literal_as_ineq)) {
       literal_as_ineq = simplify_strict_to_nonstrict(literal_as_ineq);
     }
-    int64_t lhs_value = to_integer(model.eval(literal_as_ineq.arg(0), true));
-    int64_t rhs_value = to_integer(model.eval(literal_as_ineq.arg(1), true));
     auto op = get_op(literal_as_ineq);
+    const int64_t lhs_value =
+        to_int64_value(model_eval_to_int128(literal_as_ineq.arg(0)));
+    const int64_t rhs_value =
+        to_int64_bound(model_eval_to_int128(literal_as_ineq.arg(1)), op);
     strengthen_binary_bool_literal(lhs, lhs_value, rhs_value, op);
   } else {
-    throw NoRuleForStrengthening();
+    throw NoRuleForStrengthening(literal.decl().name().str());
+  }
+}
+
+void Strengthener::pin_literal(const z3::expr &literal) {
+  if (debug) std::cout << "pinning literal: " << literal.to_string() << "\n";
+  std::unordered_set<unsigned int> visited;
+  std::vector<z3::expr> stack{literal};
+  while (!stack.empty()) {
+    const z3::expr e = stack.back();
+    stack.pop_back();
+    if (!e.is_app() || !visited.insert(e.id()).second) continue;
+    const bool is_var =
+        e.is_const() && e.decl().decl_kind() == Z3_OP_UNINTERPRETED;
+    if (e.is_int() && (is_var || is_op_select(get_op(e)))) {
+      try {
+        const int64_t value = to_int64_value(model_eval_to_int128(e));
+        add_interval_wrapper(e, value, Z3_OP_EQ);
+      } catch (const NoRuleForStrengthening &) {
+        // a value that can't be sampled, nothing is
+        i_map[e] = Interval(1, 0);
+      }
+    } else if (e.is_bv() && is_var) {
+      const uint64_t value = model_eval_to_uint64(model, e);
+      add_bv_interval(e, value, value);
+    } else if (e.is_real() && is_var) {
+      Rational value;
+      if (numeral_to_rational(model.eval(e, true), value)) {
+        add_real_interval(e, Z3_OP_EQ, value);
+      } else {
+        // a value that can't be written, nothing is sampled
+        r_map[e].set_lower_bound(1, false);
+        r_map[e].set_upper_bound(0, false);
+      }
+    }
+    // the index of a select is pinned too
+    for (unsigned int i = 0; i < e.num_args(); i++) stack.push_back(e.arg(i));
+  }
+}
+
+z3::expr Strengthener::remove_ite(const z3::expr &e,
+                                  std::vector<z3::expr> &guards) {
+  z3::expr_vector ites(c), branches(c);
+  std::unordered_set<unsigned int> visited;
+  std::vector<z3::expr> stack{e};
+  while (!stack.empty()) {
+    const z3::expr current = stack.back();
+    stack.pop_back();
+    if (!current.is_app() || !visited.insert(current.id()).second) continue;
+    if (is_op_ite(get_op(current))) {
+      const z3::expr &condition = current.arg(0);
+      const bool taken = model_eval_to_bool(model, condition);
+      ites.push_back(current);
+      branches.push_back(current.arg(taken ? 1 : 2));
+      guards.push_back(taken ? condition : !condition);
+      continue;  // ites in the branch are removed when it is strengthened
+    }
+    for (unsigned int i = 0; i < current.num_args(); i++) {
+      stack.push_back(current.arg(i));
+    }
+  }
+  if (ites.empty()) return e;
+  z3::expr result(e);
+  return result.substitute(ites, branches);
+}
+
+void Strengthener::strengthen_guard(const z3::expr &guard) {
+  assert(model_eval_to_bool(model, guard));
+  const auto op = get_op(guard);
+  if (is_op_and(op)) {
+    for (unsigned int i = 0; i < guard.num_args(); i++) {
+      strengthen_guard(guard.arg(i));
+    }
+  } else if (is_op_or(op)) {
+    for (unsigned int i = 0; i < guard.num_args(); i++) {
+      if (model_eval_to_bool(model, guard.arg(i))) {
+        strengthen_guard(guard.arg(i));
+        return;
+      }
+    }
+  } else if (is_op_not(op) && guard.arg(0).is_app()) {
+    const z3::expr &argument = guard.arg(0);
+    const auto argument_op = get_op(argument);
+    if (is_op_not(argument_op)) {
+      strengthen_guard(argument.arg(0));
+    } else if (is_op_and(argument_op)) {
+      for (unsigned int i = 0; i < argument.num_args(); i++) {
+        if (!model_eval_to_bool(model, argument.arg(i))) {
+          strengthen_guard(!argument.arg(i));
+          return;
+        }
+      }
+    } else if (is_op_or(argument_op)) {
+      for (unsigned int i = 0; i < argument.num_args(); i++) {
+        strengthen_guard(!argument.arg(i));
+      }
+    } else {
+      strengthen_literal(guard);
+    }
+  } else {
+    strengthen_literal(guard);
   }
 }
 
@@ -56,26 +247,39 @@ void Strengthener::strengthen_binary_bool_literal(const z3::expr &lhs,
   assert(is_op_ge(op) or is_op_le(op) or is_op_eq(op));
   assert(lhs.is_int());
   if (is_numeral_constant(lhs)) return;
-  if (lhs.is_const() || is_op_select(get_op(lhs))) {
+  const auto lhs_op = get_op(lhs);
+  if (lhs.is_const() || is_op_select(lhs_op)) {
     add_interval_wrapper(lhs, rhs_value, op);
+  } else if (is_op_div(lhs_op) || is_op_mod(lhs_op) || is_op_rem(lhs_op)) {
+    std::list<int64_t> arguments_values;
+    if (!get_arguments_values(lhs, model, arguments_values))
+      throw NoRuleForStrengthening("int64 overflow");
+    if (is_op_div(lhs_op)) {
+      strengthen_div(lhs, arguments_values, op, rhs_value);
+    } else {
+      strengthen_mod(lhs, arguments_values, op, rhs_value);
+    }
   } else if (is_op_eq(op)) {
     for (unsigned int i = 0; i < lhs.num_args(); i++) {
       if (!is_numeral_constant(lhs.arg(i))) {
-        int64_t arg_value = model_eval_to_int64(model, lhs.arg(i));
+        const int64_t arg_value =
+            to_int64_value(model_eval_to_int128(lhs.arg(i)));
         strengthen_binary_bool_literal(lhs.arg(i), arg_value, arg_value, op);
       }
     }
   } else {
-    auto lhs_op = get_op(lhs);
     std::list<int64_t> arguments_values;
-    get_arguments_values(lhs, model, arguments_values);
+    if (!get_arguments_values(lhs, model, arguments_values))
+      throw NoRuleForStrengthening("int64 overflow");
     if (is_op_uminus(lhs_op)) {
       if (debug)
         std::cout << "strengthening unary minus: " << lhs.to_string()
                   << op_to_string(op) << rhs_value << "\n";
       const z3::expr &arg0 = lhs.arg(0);
-      strengthen_binary_bool_literal(arg0, -lhs_value, -rhs_value,
-                                     reverse_bool_op(op));
+      const Z3_decl_kind reversed_op = reverse_bool_op(op);
+      strengthen_binary_bool_literal(
+          arg0, to_int64_value(-(int128_t)lhs_value),
+          to_int64_bound(-(int128_t)rhs_value, reversed_op), reversed_op);
     } else if (is_op_add(lhs_op)) {
       strengthen_add(lhs, lhs_value, arguments_values, op, rhs_value);
     } else if (is_op_mul(lhs_op)) {
@@ -83,7 +287,7 @@ void Strengthener::strengthen_binary_bool_literal(const z3::expr &lhs,
     } else if (is_op_sub(lhs_op)) {
       strengthen_sub(lhs, arguments_values, op, rhs_value);
     } else {
-      throw NoRuleForStrengthening();
+      throw NoRuleForStrengthening(lhs.decl().name().str());
     }
   }
 }
@@ -96,19 +300,22 @@ void Strengthener::strengthen_mult(const z3::expr &lhs, int64_t lhs_value,
               << rhs_value << "\n";
   assert(arguments_values.size() == lhs.num_args());
   z3::expr non_constants_prod_e(c);
-  int64_t constants_prod = 1;
-  int64_t non_constants_prod = 1;
+  int128_t constants_prod = 1;
+  int128_t non_constants_prod = 1;
   int constants_count = 0;
   auto it = arguments_values.begin();
   for (unsigned int i = 0; i < lhs.num_args(); i++) {
     const z3::expr &argument = lhs.arg(i);
     int64_t value = *it;
     if (is_numeral_constant(argument)) {
-      constants_prod *= value;  // TODO: safe computations
+      if (__builtin_mul_overflow(constants_prod, value, &constants_prod))
+        throw NoRuleForStrengthening("int128 overflow");
       constants_count++;
       it = arguments_values.erase(it);
     } else {
-      non_constants_prod *= value;
+      if (__builtin_mul_overflow(non_constants_prod, value,
+                                 &non_constants_prod))
+        throw NoRuleForStrengthening("int128 overflow");
       if (non_constants_prod_e) {
         non_constants_prod_e = non_constants_prod_e * argument;
       } else {
@@ -118,7 +325,8 @@ void Strengthener::strengthen_mult(const z3::expr &lhs, int64_t lhs_value,
     }
   }
   if (constants_count > 0) {
-    strengthen_mult_by_constant(non_constants_prod_e, non_constants_prod,
+    strengthen_mult_by_constant(non_constants_prod_e,
+                                to_int64_value(non_constants_prod),
                                 constants_prod, rhs_value, op);
   } else {
     strengthen_mult_without_constants(lhs, lhs_value, arguments_values, op,
@@ -134,8 +342,8 @@ void Strengthener::strengthen_add(const z3::expr &lhs, int64_t lhs_value,
               << rhs_value << "\n";
   assert(lhs.num_args() == arguments_values.size());
   z3::expr non_constants_sum_e(c);
-  int64_t constants_sum = 0;
-  int64_t non_constants_sum = 0;
+  int128_t constants_sum = 0;  // sums of int64 values, exact in int128
+  int128_t non_constants_sum = 0;
   int constants_count = 0;
   auto it = arguments_values.begin();
   for (unsigned int i = 0; i < lhs.num_args(); i++) {
@@ -145,7 +353,7 @@ void Strengthener::strengthen_add(const z3::expr &lhs, int64_t lhs_value,
     //    << value << "\n";
     if (is_numeral_constant(argument)) {
       //      std::cout << "is numeral constant\n";
-      constants_sum += value;  // TODO: safe computations
+      constants_sum += value;
       constants_count++;
       it = arguments_values.erase(it);
     } else {
@@ -160,8 +368,10 @@ void Strengthener::strengthen_add(const z3::expr &lhs, int64_t lhs_value,
     }
   }
   if (constants_count > 0) {
-    strengthen_binary_bool_literal(non_constants_sum_e, non_constants_sum,
-                                   rhs_value - constants_sum, op);
+    strengthen_binary_bool_literal(non_constants_sum_e,
+                                   to_int64_value(non_constants_sum),
+                                   to_int64_bound(rhs_value - constants_sum, op),
+                                   op);
   } else {
     strengthen_add_without_constants(lhs, lhs_value, arguments_values, op,
                                      rhs_value);
@@ -178,7 +388,7 @@ void Strengthener::add_interval_wrapper(const z3::expr &lhs, int64_t rhs_value,
     const z3::expr &index = lhs.arg(1);
     const z3::expr &array = lhs.arg(0);
     const std::string &array_name = array.to_string();
-    int64_t index_value = model_eval_to_int64(model, index);
+    int64_t index_value = to_int64_value(model_eval_to_int128(index));
     auto &equivalence_index_set =
         array_equivalence_classes[array_name][index_value];
     if (!equivalence_index_set.empty()) {
@@ -206,7 +416,7 @@ void Strengthener::add_interval(const z3::expr &lhs, int64_t rhs_value,
     i_map[lhs].set_lower_bound(rhs_value);
     i_map[lhs].set_upper_bound(rhs_value);
   } else {
-    throw NoRuleForStrengthening();
+    throw NoRuleForStrengthening(op_to_string(op));
   }
 }
 
@@ -220,29 +430,596 @@ void Strengthener::strengthen_sub(const z3::expr &lhs,
   int64_t second_arg_value = arguments_values.back();
   arguments_values.pop_back();
   int64_t first_arg_value = arguments_values.back();
-  arguments_values.push_back(-second_arg_value);
-  strengthen_add(lhs.arg(0) + (-lhs.arg(1)), first_arg_value - second_arg_value,
+  arguments_values.push_back(to_int64_value(-(int128_t)second_arg_value));
+  strengthen_add(lhs.arg(0) + (-lhs.arg(1)),
+                 to_int64_value((int128_t)first_arg_value - second_arg_value),
                  arguments_values, op, rhs_value);
 }
 
+void Strengthener::strengthen_div(const z3::expr &lhs,
+                                  std::list<int64_t> &arguments_values,
+                                  Z3_decl_kind op, int64_t rhs_value) {
+  if (debug)
+    std::cout << "strengthening div: " << lhs.to_string() << op_to_string(op)
+              << rhs_value << "\n";
+  assert(arguments_values.size() == 2);
+  const z3::expr &dividend = lhs.arg(0);
+  const z3::expr &divisor = lhs.arg(1);
+  const int64_t dividend_value = arguments_values.front();
+  const int64_t divisor_value = arguments_values.back();
+  if (divisor_value == 0) {
+    strengthen_division_by_zero(dividend, dividend_value, divisor);
+    return;
+  }
+  if (!is_numeral_constant(divisor)) {
+    if (is_op_eq(op)) {
+      strengthen_binary_bool_literal(divisor, divisor_value, divisor_value, op);
+    } else {
+      // with the signs of both arguments fixed, the quotient is monotone in
+      // the divisor: increasing for a negative dividend, decreasing otherwise
+      if (dividend_value >= 0) {
+        strengthen_binary_bool_literal(dividend, dividend_value, 0, Z3_OP_GE);
+      } else {
+        strengthen_binary_bool_literal(dividend, dividend_value, -1, Z3_OP_LE);
+      }
+      if (divisor_value > 0) {
+        strengthen_binary_bool_literal(divisor, divisor_value, 1, Z3_OP_GE);
+      } else {
+        strengthen_binary_bool_literal(divisor, divisor_value, -1, Z3_OP_LE);
+      }
+      // the divisor may only move where the quotient keeps satisfying op
+      const bool divisor_up = (dividend_value < 0) == is_op_ge(op);
+      strengthen_binary_bool_literal(divisor, divisor_value, divisor_value,
+                                     divisor_up ? Z3_OP_GE : Z3_OP_LE);
+    }
+  }
+  strengthen_div_by_constant(dividend, dividend_value, divisor_value, op,
+                             rhs_value);
+}
+
+void Strengthener::strengthen_div_by_constant(const z3::expr &dividend,
+                                              int64_t dividend_value,
+                                              int64_t divisor, Z3_decl_kind op,
+                                              int64_t rhs_value) {
+  if (debug)
+    std::cout << "strengthening div by constant: " << dividend.to_string()
+              << " div " << divisor << op_to_string(op) << rhs_value << "\n";
+  int128_t positive_divisor = divisor;
+  int128_t bound = rhs_value;
+  if (divisor < 0) {
+    // div(a, -k) = -div(a, k)
+    positive_divisor = -positive_divisor;
+    bound = -bound;
+    op = reverse_bool_op(op);
+  }
+  // a = k*q + r with 0 <= r < k, so q >= R iff a >= k*R and q <= R iff
+  // a <= k*R + k - 1
+  const int128_t low = positive_divisor * bound;
+  const int128_t high = low + positive_divisor - 1;
+  if (is_op_ge(op) || is_op_eq(op)) {
+    strengthen_binary_bool_literal(dividend, dividend_value,
+                                   to_int64_bound(low, Z3_OP_GE), Z3_OP_GE);
+  }
+  if (is_op_le(op) || is_op_eq(op)) {
+    strengthen_binary_bool_literal(dividend, dividend_value,
+                                   to_int64_bound(high, Z3_OP_LE), Z3_OP_LE);
+  }
+}
+
+void Strengthener::strengthen_division_by_zero(const z3::expr &dividend,
+                                               int64_t dividend_value,
+                                               const z3::expr &divisor) {
+  // the value is whatever the model gives the uninterpreted division by zero
+  // for this dividend, so nothing may move
+  strengthen_binary_bool_literal(dividend, dividend_value, dividend_value,
+                                 Z3_OP_EQ);
+  strengthen_binary_bool_literal(divisor, 0, 0, Z3_OP_EQ);
+}
+
+void Strengthener::strengthen_mod(const z3::expr &lhs,
+                                  std::list<int64_t> &arguments_values,
+                                  Z3_decl_kind op, int64_t rhs_value) {
+  if (debug)
+    std::cout << "strengthening mod: " << lhs.to_string() << op_to_string(op)
+              << rhs_value << "\n";
+  assert(arguments_values.size() == 2);
+  const z3::expr &dividend = lhs.arg(0);
+  const z3::expr &divisor = lhs.arg(1);
+  const int64_t dividend_value = arguments_values.front();
+  const int64_t divisor_value = arguments_values.back();
+  if (divisor_value == 0) {
+    strengthen_division_by_zero(dividend, dividend_value, divisor);
+    return;
+  }
+  if (divisor_value == INT64_MIN) throw NoRuleForStrengthening("mod overflow");
+  if (!is_numeral_constant(divisor)) {
+    // the remainder jumps around as the divisor changes
+    strengthen_binary_bool_literal(divisor, divisor_value, divisor_value,
+                                   Z3_OP_EQ);
+  }
+  if (is_op_rem(get_op(lhs)) && divisor_value < 0) {
+    // rem(a, -k) = -mod(a, k)
+    if (rhs_value == INT64_MIN) throw NoRuleForStrengthening("rem overflow");
+    rhs_value = -rhs_value;
+    op = reverse_bool_op(op);
+  }
+  strengthen_mod_by_constant(dividend, dividend_value,
+                             divisor_value > 0 ? divisor_value : -divisor_value,
+                             op, rhs_value);
+}
+
+void Strengthener::strengthen_mod_by_constant(const z3::expr &dividend,
+                                              int64_t dividend_value,
+                                              int64_t divisor, Z3_decl_kind op,
+                                              int64_t rhs_value) {
+  if (debug)
+    std::cout << "strengthening mod by constant: " << dividend.to_string()
+              << " mod " << divisor << op_to_string(op) << rhs_value << "\n";
+  assert(divisor > 0);
+  // always true, as 0 <= mod(a, k) <= k - 1
+  if (is_op_ge(op) && rhs_value <= 0) return;
+  if (is_op_le(op) && rhs_value >= divisor - 1) return;
+  // on the block of the seed, k*t <= a <= k*t + k - 1, mod(a, k) = a - k*t
+  const int128_t block = divisor * floor_div(dividend_value, divisor);
+  int128_t low = block, high = block + divisor - 1;
+  if (is_op_ge(op)) low = block + rhs_value;
+  if (is_op_le(op)) high = block + rhs_value;
+  if (is_op_eq(op)) low = high = block + rhs_value;
+  strengthen_binary_bool_literal(dividend, dividend_value,
+                                 to_int64_bound(low, Z3_OP_GE), Z3_OP_GE);
+  strengthen_binary_bool_literal(dividend, dividend_value,
+                                 to_int64_bound(high, Z3_OP_LE), Z3_OP_LE);
+}
+
+void Strengthener::strengthen_real_literal(const z3::expr &literal) {
+  if (debug)
+    std::cout << "strengthening real literal: " << literal.to_string() << "\n";
+  const z3::expr &lhs = literal.arg(0);
+  const z3::expr &rhs = literal.arg(1);
+  const Rational lhs_value = model_eval_to_rational(lhs);
+  const Rational rhs_value = model_eval_to_rational(rhs);
+  Z3_decl_kind op = get_op(literal);
+  if (is_op_distinct(op)) op = lhs_value < rhs_value ? Z3_OP_LT : Z3_OP_GT;
+  try {
+    if (rhs.is_numeral()) {
+      strengthen_real(lhs, lhs_value, op, rhs_value);
+    } else {
+      strengthen_real(lhs - rhs, lhs_value - rhs_value, op, 0);
+    }
+  } catch (const RationalOverflow &) {
+    throw NoRuleForStrengthening("rational overflow");
+  }
+}
+
+void Strengthener::strengthen_real(const z3::expr &term, const Rational &value,
+                                   Z3_decl_kind op, const Rational &bound) {
+  if (debug)
+    std::cout << "strengthening real term: " << term.to_string()
+              << op_to_string(op) << bound << "\n";
+  assert(is_op_le(op) || is_op_lt(op) || is_op_ge(op) || is_op_gt(op) ||
+         is_op_eq(op));
+  if (term.is_numeral()) return;
+  const auto term_op = get_op(term);
+  if (term.is_const()) {
+    add_real_interval(term, op, bound);
+  } else if (is_op_uminus(term_op)) {
+    strengthen_real(term.arg(0), -value, reverse_bool_op(op), -bound);
+  } else if (is_op_add(term_op) || is_op_sub(term_op)) {
+    strengthen_real_add(term, value, op, bound);
+  } else if (is_op_mul(term_op)) {
+    Rational constant = 1;
+    z3::expr_vector non_constants(c);
+    for (unsigned int i = 0; i < term.num_args(); i++) {
+      if (term.arg(i).is_numeral()) {
+        constant = constant * model_eval_to_rational(term.arg(i));
+      } else {
+        non_constants.push_back(term.arg(i));
+      }
+    }
+    if (non_constants.size() > 1) throw NoRuleForStrengthening("* on Real");
+    if (non_constants.empty() || constant == 0) return;
+    // exact, unlike the Int case that rounds the bound
+    strengthen_real(non_constants[0], value / constant,
+                    constant < 0 ? reverse_bool_op(op) : op,
+                    bound / constant);
+  } else if (term_op == Z3_OP_DIV && term.arg(1).is_numeral()) {
+    const Rational divisor = model_eval_to_rational(term.arg(1));
+    if (divisor == 0) throw NoRuleForStrengthening("/ by zero");
+    strengthen_real(term.arg(0), value * divisor,
+                    divisor < 0 ? reverse_bool_op(op) : op, bound * divisor);
+  } else if (term_op == Z3_OP_TO_REAL) {
+    strengthen_to_real(term, op, bound);
+  } else {
+    throw NoRuleForStrengthening(term.decl().name().str() + " on Real");
+  }
+}
+
+void Strengthener::strengthen_real_add(const z3::expr &term,
+                                       const Rational &value, Z3_decl_kind op,
+                                       const Rational &bound) {
+  const bool is_sub = is_op_sub(get_op(term));
+  std::vector<unsigned int> movable;
+  for (unsigned int i = 0; i < term.num_args(); i++) {
+    if (!term.arg(i).is_numeral()) movable.push_back(i);
+  }
+  if (movable.empty()) return;
+  const bool upper = is_op_le(op) || is_op_lt(op);
+  Rational share = 0;
+  if (!is_op_eq(op)) {
+    // the slack of the seed, split evenly; a strict bound stays strict
+    const Rational slack = upper ? bound - value : value - bound;
+    assert(slack >= 0);
+    share = slack / Rational((int64_t)movable.size());
+  }
+  for (const unsigned int i : movable) {
+    const z3::expr &argument = term.arg(i);
+    const Rational arg_value = model_eval_to_rational(argument);
+    const bool negative = is_sub && i > 0;
+    if (is_op_eq(op)) {
+      strengthen_real(argument, arg_value, op, arg_value);
+    } else if (upper != negative) {
+      strengthen_real(argument, arg_value, negative ? reverse_bool_op(op) : op,
+                      arg_value + share);
+    } else {
+      strengthen_real(argument, arg_value, negative ? reverse_bool_op(op) : op,
+                      arg_value - share);
+    }
+  }
+}
+
+void Strengthener::strengthen_to_real(const z3::expr &term, Z3_decl_kind op,
+                                      const Rational &bound) {
+  // the Int argument gets the integer part of the bound
+  const z3::expr &argument = term.arg(0);
+  const int64_t arg_value = to_int64_value(model_eval_to_int128(argument));
+  int128_t int_bound;
+  if (is_op_le(op)) {
+    int_bound = bound.floor();
+  } else if (is_op_lt(op)) {
+    int_bound = bound.ceil() - 1;
+    op = Z3_OP_LE;
+  } else if (is_op_ge(op)) {
+    int_bound = bound.ceil();
+  } else if (is_op_gt(op)) {
+    int_bound = bound.floor() + 1;
+    op = Z3_OP_GE;
+  } else {
+    int_bound = arg_value;
+  }
+  strengthen_binary_bool_literal(argument, arg_value,
+                                 to_int64_bound(int_bound, op), op);
+}
+
+void Strengthener::add_real_interval(const z3::expr &var, Z3_decl_kind op,
+                                     const Rational &bound) {
+  if (debug)
+    std::cout << "adding real interval: " << var.to_string()
+              << op_to_string(op) << bound << "\n";
+  assert(var.is_const());
+  RealInterval &interval = r_map[var];
+  if (is_op_le(op) || is_op_lt(op)) {
+    interval.set_upper_bound(bound, is_op_lt(op));
+  } else if (is_op_ge(op) || is_op_gt(op)) {
+    interval.set_lower_bound(bound, is_op_gt(op));
+  } else if (is_op_eq(op)) {
+    interval.set_lower_bound(bound, false);
+    interval.set_upper_bound(bound, false);
+  } else {
+    throw NoRuleForStrengthening(op_to_string(op));
+  }
+}
+
+int128_t Strengthener::model_eval_to_int128(const z3::expr &e) {
+  const z3::expr value = model.eval(e, true);
+  int64_t small_value;
+  if (value.is_numeral_i64(small_value)) return small_value;
+  std::string digits;
+  if (!value.is_numeral(digits)) throw NoRuleForStrengthening("int128 overflow");
+  // accumulated on the negative side, which has room for the minimum
+  const bool negative = digits[0] == '-';
+  int128_t result = 0;
+  for (size_t i = negative ? 1 : 0; i < digits.size(); i++) {
+    if (__builtin_mul_overflow(result, 10, &result) ||
+        __builtin_sub_overflow(result, digits[i] - '0', &result))
+      throw NoRuleForStrengthening("int128 overflow");
+  }
+  if (negative) return result;
+  if (__builtin_mul_overflow(result, -1, &result))
+    throw NoRuleForStrengthening("int128 overflow");
+  return result;
+}
+
+Rational Strengthener::model_eval_to_rational(const z3::expr &e) {
+  Rational value;
+  if (!numeral_to_rational(model.eval(e, true), value))
+    throw NoRuleForStrengthening("rational overflow");
+  return value;
+}
+
+void Strengthener::strengthen_bv_literal(const z3::expr &literal,
+                                         bool negated) {
+  if (debug)
+    std::cout << "strengthening bit-vector literal: " << (negated ? "not " : "")
+              << literal.to_string() << "\n";
+  const unsigned int width = literal.arg(0).get_sort().bv_size();
+  if (width > 64) throw NoRuleForStrengthening("bit-vector wider than 64 bits");
+  Z3_decl_kind op = get_op(literal);
+  if (negated) op = negate_bv_op(op);
+  z3::expr lhs = literal.arg(0);
+  z3::expr rhs = literal.arg(1);
+  uint64_t lhs_value = model_eval_to_uint64(model, lhs);
+  uint64_t rhs_value = model_eval_to_uint64(model, rhs);
+  if (op == Z3_OP_EQ) {
+    strengthen_bv_range(lhs, lhs_value, lhs_value);
+    strengthen_bv_range(rhs, rhs_value, rhs_value);
+    return;
+  }
+  // turn op into <= or <, unsigned for distinct
+  bool swap = op == Z3_OP_UGEQ || op == Z3_OP_UGT || op == Z3_OP_SGEQ ||
+              op == Z3_OP_SGT;
+  if (op == Z3_OP_DISTINCT) {
+    swap = lhs_value > rhs_value;
+    op = swap ? Z3_OP_UGT : Z3_OP_ULT;
+  }
+  if (swap) {
+    std::swap(lhs, rhs);
+    std::swap(lhs_value, rhs_value);
+    op = reverse_bool_op(op);
+  }
+  const bool is_signed = op == Z3_OP_SLEQ || op == Z3_OP_SLT;
+  const bool strict = op == Z3_OP_ULT || op == Z3_OP_SLT;
+  const int128_t domain = ((int128_t)1) << width;
+  const int128_t min = is_signed ? -domain / 2 : 0;
+  const int128_t max = is_signed ? domain / 2 - 1 : domain - 1;
+  auto to_order = [&](uint64_t value) -> int128_t {
+    if (is_signed && value >= (uint64_t)(domain / 2)) return value - domain;
+    return value;
+  };
+  const int128_t lhs_order = to_order(lhs_value);
+  const int128_t rhs_order = to_order(rhs_value);
+  assert(strict ? lhs_order < rhs_order : lhs_order <= rhs_order);
+  // lhs <= m and rhs >= m (+1 if strict), for m between the seed values
+  int128_t m;
+  if (lhs.is_numeral()) {
+    m = lhs_order;
+  } else if (rhs.is_numeral()) {
+    m = rhs_order - strict;
+  } else {
+    m = floor_div(lhs_order + rhs_order - strict, 2);
+  }
+  strengthen_bv_order_range(lhs, min, m, is_signed);
+  strengthen_bv_order_range(rhs, m + strict, max, is_signed);
+}
+
+void Strengthener::strengthen_bv_order_range(const z3::expr &term,
+                                             int128_t low, int128_t high,
+                                             bool is_signed) {
+  if (!is_signed) {
+    strengthen_bv_range(term, low, high);
+    return;
+  }
+  // stay in the sign half of the seed, where the orders agree
+  const int128_t half = ((int128_t)1) << (term.get_sort().bv_size() - 1);
+  if (model_eval_to_uint64(model, term) < (uint64_t)half) {
+    strengthen_bv_range(term, std::max<int128_t>(low, 0),
+                        std::min<int128_t>(high, half - 1));
+  } else {
+    strengthen_bv_range(term, low + 2 * half,
+                        std::min<int128_t>(high, -1) + 2 * half);
+  }
+}
+
+void Strengthener::strengthen_bv_range(const z3::expr &term, int128_t low,
+                                       int128_t high) {
+  const unsigned int width = term.get_sort().bv_size();
+  if (width > 64) throw NoRuleForStrengthening("bit-vector wider than 64 bits");
+  const int128_t domain = ((int128_t)1) << width;
+  low = std::max<int128_t>(low, 0);
+  high = std::min<int128_t>(high, domain - 1);
+  if (term.is_numeral() || (low == 0 && high == domain - 1)) return;
+  if (debug)
+    std::cout << "strengthening bit-vector range: " << term.to_string()
+              << " in [" << (uint64_t)low << "," << (uint64_t)high << "]\n";
+  assert(low <= model_eval_to_uint64(model, term) &&
+         model_eval_to_uint64(model, term) <= high);
+  const auto op = get_op(term);
+  if (term.is_const()) {
+    add_bv_interval(term, low, high);
+  } else if (is_op_add(op) || is_op_sub(op) || op == Z3_OP_BNEG) {
+    strengthen_bv_add(term, low, high);
+  } else if (op == Z3_OP_BMUL) {
+    strengthen_bv_mul(term, low, high);
+  } else if (op == Z3_OP_BUDIV || op == Z3_OP_BUDIV_I) {
+    strengthen_bv_udiv(term, low, high);
+  } else if (op == Z3_OP_BUREM || op == Z3_OP_BUREM_I) {
+    strengthen_bv_urem(term, low, high);
+  } else if (op == Z3_OP_ZERO_EXT) {
+    strengthen_bv_range(term.arg(0), low, high);
+  } else if (op == Z3_OP_SIGN_EXT) {
+    strengthen_bv_sign_extend(term, low, high);
+  } else if (op == Z3_OP_CONCAT) {
+    strengthen_bv_concat(term, low, high);
+  } else if (op == Z3_OP_EXTRACT) {
+    strengthen_bv_extract(term, low, high);
+  } else {
+    throw NoRuleForStrengthening(term.decl().name().str());
+  }
+}
+
+void Strengthener::strengthen_bv_add(const z3::expr &term, int128_t low,
+                                     int128_t high) {
+  const auto op = get_op(term);
+  std::vector<std::pair<unsigned int, int128_t>> movable;  // (arg, value)
+  for (unsigned int i = 0; i < term.num_args(); i++) {
+    if (!term.arg(i).is_numeral())
+      movable.emplace_back(i, model_eval_to_uint64(model, term.arg(i)));
+  }
+  if (movable.empty()) return;
+  // with every argument in its domain, the exact sum of the arguments keeps
+  // the lap of the seed (how often it wrapped around) as long as the sum
+  // grows by at most up and shrinks by at most down
+  const int128_t value = model_eval_to_uint64(model, term);
+  const int128_t up = high - value;
+  const int128_t down = value - low;
+  const int128_t n = movable.size();
+  for (unsigned int j = 0; j < movable.size(); j++) {
+    const unsigned int i = movable[j].first;
+    const int128_t arg_value = movable[j].second;
+    const int128_t arg_up = up / n + (j < up % n);
+    const int128_t arg_down = down / n + (j < down % n);
+    const bool negative = op == Z3_OP_BNEG || (is_op_sub(op) && i > 0);
+    if (negative) {
+      strengthen_bv_range(term.arg(i), arg_value - arg_up, arg_value + arg_down);
+    } else {
+      strengthen_bv_range(term.arg(i), arg_value - arg_down, arg_value + arg_up);
+    }
+  }
+}
+
+void Strengthener::strengthen_bv_mul(const z3::expr &term, int128_t low,
+                                     int128_t high) {
+  const unsigned int width = term.get_sort().bv_size();
+  uint128_t constant = 1;
+  std::vector<z3::expr> non_constants;
+  for (unsigned int i = 0; i < term.num_args(); i++) {
+    const z3::expr &argument = term.arg(i);
+    if (argument.is_numeral()) {
+      constant *= argument.get_numeral_uint64();
+      constant &= (((uint128_t)1) << width) - 1;
+    } else {
+      non_constants.push_back(argument);
+    }
+  }
+  if (non_constants.size() > 1)
+    throw NoRuleForStrengthening("bvmul without constants");
+  if (non_constants.empty() || constant == 0) return;
+  const z3::expr &non_constant = non_constants.front();
+  const uint128_t arg_value = model_eval_to_uint64(model, non_constant);
+  // the exact product is below 2^128 - 2^64, so it stays in uint128_t when
+  // it moves within [low, high] on the lap of the seed
+  const uint128_t product = constant * arg_value;
+  const uint128_t lap = product - model_eval_to_uint64(model, term);
+  const uint128_t product_low = lap + (uint128_t)low;
+  const uint128_t product_high = lap + (uint128_t)high;
+  // k*a in [product_low, product_high]
+  strengthen_bv_range(non_constant,
+                      (int128_t)((product_low + constant - 1) / constant),
+                      (int128_t)(product_high / constant));
+}
+
+void Strengthener::strengthen_bv_udiv(const z3::expr &term, int128_t low,
+                                      int128_t high) {
+  const z3::expr &dividend = term.arg(0);
+  const z3::expr &divisor = term.arg(1);
+  const uint64_t dividend_value = model_eval_to_uint64(model, dividend);
+  const uint64_t divisor_value = model_eval_to_uint64(model, divisor);
+  // the quotient jumps around as the divisor changes
+  strengthen_bv_range(divisor, divisor_value, divisor_value);
+  if (divisor_value == 0) {
+    // whatever the model gives the division by zero
+    strengthen_bv_range(dividend, dividend_value, dividend_value);
+    return;
+  }
+  // a = k*q + r with 0 <= r < k, so R1 <= q <= R2 iff k*R1 <= a <= k*R2 + k-1
+  const uint128_t k = divisor_value;
+  const uint128_t dividend_high = ((uint128_t)high + 1) * k - 1;
+  strengthen_bv_range(dividend, (int128_t)((uint128_t)low * k),
+                      (int128_t)std::min<uint128_t>(dividend_high, UINT64_MAX));
+}
+
+void Strengthener::strengthen_bv_urem(const z3::expr &term, int128_t low,
+                                      int128_t high) {
+  const z3::expr &dividend = term.arg(0);
+  const z3::expr &divisor = term.arg(1);
+  const uint64_t dividend_value = model_eval_to_uint64(model, dividend);
+  const uint64_t divisor_value = model_eval_to_uint64(model, divisor);
+  // the remainder jumps around as the divisor changes
+  strengthen_bv_range(divisor, divisor_value, divisor_value);
+  if (divisor_value == 0) {
+    strengthen_bv_range(dividend, dividend_value, dividend_value);
+    return;
+  }
+  // always true, as 0 <= urem(a, k) <= k - 1
+  if (low == 0 && high >= divisor_value - 1) return;
+  // on the block of the seed, urem(a, k) = a - block
+  const int128_t block = dividend_value - dividend_value % divisor_value;
+  strengthen_bv_range(dividend, block + low,
+                      block + std::min<int128_t>(high, divisor_value - 1));
+}
+
+void Strengthener::strengthen_bv_concat(const z3::expr &term, int128_t low,
+                                        int128_t high) {
+  // the high parts are pinned, the lowest part gets the range
+  const unsigned int last = term.num_args() - 1;
+  for (unsigned int i = 0; i < last; i++) {
+    const uint64_t value = model_eval_to_uint64(model, term.arg(i));
+    strengthen_bv_range(term.arg(i), value, value);
+  }
+  const int128_t offset = (int128_t)model_eval_to_uint64(model, term) -
+                          model_eval_to_uint64(model, term.arg(last));
+  strengthen_bv_range(term.arg(last), low - offset, high - offset);
+}
+
+void Strengthener::strengthen_bv_extract(const z3::expr &term, int128_t low,
+                                         int128_t high) {
+  // the bits above the extracted ones are pinned, the ones below are free
+  const z3::expr &argument = term.arg(0);
+  const unsigned int hi = term.hi();
+  const unsigned int lo = term.lo();
+  const uint128_t value = model_eval_to_uint64(model, argument);
+  const uint128_t top = (value >> (hi + 1)) << (hi + 1);
+  const uint128_t step = ((uint128_t)1) << lo;
+  strengthen_bv_range(argument, (int128_t)(top + (uint128_t)low * step),
+                      (int128_t)(top + ((uint128_t)high + 1) * step - 1));
+}
+
+void Strengthener::strengthen_bv_sign_extend(const z3::expr &term,
+                                             int128_t low, int128_t high) {
+  // stay in the sign half of the seed, where the extension adds a constant
+  const z3::expr &argument = term.arg(0);
+  const unsigned int width = argument.get_sort().bv_size();
+  const int128_t half = ((int128_t)1) << (width - 1);
+  if (model_eval_to_uint64(model, argument) < (uint64_t)half) {
+    strengthen_bv_range(argument, low, std::min<int128_t>(high, half - 1));
+  } else {
+    const int128_t offset =
+        (((int128_t)1) << term.get_sort().bv_size()) - 2 * half;
+    strengthen_bv_range(argument, std::max<int128_t>(low - offset, half),
+                        high - offset);
+  }
+}
+
+void Strengthener::add_bv_interval(const z3::expr &var, int128_t low,
+                                   int128_t high) {
+  if (debug)
+    std::cout << "adding bit-vector interval: " << var.to_string() << " in ["
+              << (uint64_t)low << "," << (uint64_t)high << "]\n";
+  assert(var.is_const() && 0 <= low && low <= high);
+  const unsigned int width = var.get_sort().bv_size();
+  Interval &interval = i_map[var];
+  interval.set_lower_bound(bv_to_box(low, width));
+  interval.set_upper_bound(bv_to_box(high, width));
+}
+
 void Strengthener::strengthen_add_without_constants(
     const z3::expr &lhs, int64_t lhs_value,
     std::list<int64_t> &arguments_values, Z3_decl_kind op, int64_t rhs_value) {
   assert(lhs.num_args() == arguments_values.size());
   unsigned int num_arguments = lhs.num_args();
   if (is_op_le(op)) {
-    int64_t diff = rhs_value - lhs_value;
+    int128_t diff = (int128_t)rhs_value - lhs_value;
     assert(diff >= 0);
-    int64_t minimal_addition = diff / num_arguments;
-    int64_t extra_addition = diff % num_arguments;
+    int128_t minimal_addition = diff / num_arguments;
+    int128_t extra_addition = diff % num_arguments;
     int count_given_extra_addition = 0;
     auto it = arguments_values.begin();
     unsigned int i = 0;
     while (count_given_extra_addition < extra_addition) {
       assert(it != arguments_values.end() && i < num_arguments);
       int64_t value_i = *it;
-      strengthen_binary_bool_literal(lhs.arg(i), value_i,
-                                     value_i + minimal_addition + 1, op);
+      strengthen_binary_bool_literal(
+          lhs.arg(i), value_i,
+          to_int64_bound(value_i + minimal_addition + 1, op), op);
       count_given_extra_addition++;
       i++;
       it++;
@@ -250,16 +1027,17 @@ void Strengthener::strengthen_add_without_constants(
     while (i < num_arguments) {
       assert(it != arguments_values.end());
       int64_t value_i = *it;
-      strengthen_binary_bool_literal(lhs.arg(i), value_i,
-                                     value_i + minimal_addition, op);
+      strengthen_binary_bool_literal(
+          lhs.arg(i), value_i, to_int64_bound(value_i + minimal_addition, op),
+          op);
       i++;
       it++;
     }
   } else if (is_op_ge(op)) {
-    int64_t diff = lhs_value - rhs_value;
+    int128_t diff = (int128_t)lhs_value - rhs_value;
     assert(diff >= 0);
-    int64_t minimal_subtraction = diff / num_arguments;
-    int64_t extra_subtraction = diff % num_arguments;
+    int128_t minimal_subtraction = diff / num_arguments;
+    int128_t extra_subtraction = diff % num_arguments;
 
     int count_given_extra_subtraction = 0;
     auto it = arguments_values.begin();
@@ -267,8 +1045,9 @@ void Strengthener::strengthen_add_without_constants(
     while (count_given_extra_subtraction < extra_subtraction) {
       assert(it != arguments_values.end() && i < num_arguments);
       int64_t value_i = *it;
-      strengthen_binary_bool_literal(lhs.arg(i), value_i,
-                                     value_i - minimal_subtraction - 1, op);
+      strengthen_binary_bool_literal(
+          lhs.arg(i), value_i,
+          to_int64_bound(value_i - minimal_subtraction - 1, op), op);
       count_given_extra_subtraction++;
       i++;
       it++;
@@ -276,46 +1055,45 @@ void Strengthener::strengthen_add_without_constants(
     while (i < num_arguments) {
       assert(it != arguments_values.end());
       int64_t value_i = *it;
-      strengthen_binary_bool_literal(lhs.arg(i), value_i,
-                                     value_i - minimal_subtraction, op);
+      strengthen_binary_bool_literal(
+          lhs.arg(i), value_i,
+          to_int64_bound(value_i - minimal_subtraction, op), op);
       i++;
       it++;
     }
   } else {
-    throw NoRuleForStrengthening();
+    throw NoRuleForStrengthening("+ " + op_to_string(op));
   }
 }
 
 void Strengthener::strengthen_mult_by_constant(const z3::expr &non_constant_arg,
                                                int64_t non_constant_arg_value,
-                                               int64_t constant_value,
+                                               int128_t constant_value,
                                                int64_t rhs_value,
                                                Z3_decl_kind op) {
   if (debug)
-    std::cout << "strengthening multiply by constant: " << constant_value << "*"
+    std::cout << "strengthening multiply by constant: "
+              << int128_to_string(constant_value) << "*"
               << non_constant_arg.to_string() << op_to_string(op) << rhs_value
               << "\n";
   if (constant_value == 0) {
     // case 0*expr op rhs, no need to add restrictions on expr
     return;
   }
-  // determine op
+  // determine op, and divide by the positive constant
+  int128_t numerator = rhs_value;
   if (constant_value < 0) {
     op = reverse_bool_op(op);
+    numerator = -numerator;
+    constant_value = -constant_value;
   }
-  int64_t new_rhs_value = rhs_value / constant_value;
-  // fix rounding
-  bool rounded_down = ((rhs_value >= 0) ^ (constant_value < 0)) &&
-                      (rhs_value % constant_value != 0);  // same sign
-  bool rounded_up = !((rhs_value >= 0) ^ (constant_value < 0)) &&
-                    (rhs_value % constant_value != 0);  // opposite signs
-  bool needs_rounding_up = (is_op_ge(op) or is_op_gt(op));
-  bool needs_rounding_down = (is_op_le(op) or is_op_lt(op));
-  if (rounded_down && needs_rounding_up) new_rhs_value++;
-  if (rounded_up && needs_rounding_down) new_rhs_value--;
+  // rounded towards the side that op allows
+  const int128_t new_rhs_value = is_op_ge(op)
+                                     ? -floor_div(-numerator, constant_value)
+                                     : floor_div(numerator, constant_value);
   // recursive call
   strengthen_binary_bool_literal(non_constant_arg, non_constant_arg_value,
-                                 new_rhs_value, op);
+                                 to_int64_bound(new_rhs_value, op), op);
 }
 
 void Strengthener::strengthen_mult_without_constants(
@@ -362,7 +1140,7 @@ void Strengthener::strengthen_mult_without_constants(
       it++;
     }
   } else {
-    throw NoRuleForStrengthening();
+    throw NoRuleForStrengthening("* " + op_to_string(op));
   }
 }
 
@@ -371,5 +1149,8 @@ void Strengthener::print_interval_map() {
   for (auto const &pair : i_map) {
     std::cout << pair.first << ":" << pair.second << ",";
   }
+  for (auto const &pair : r_map) {
+    std::cout << pair.first << ":" << pair.second << ",";
+  }
   std::cout << "\n";
 }
@@ -2,10 +2,14 @@
 #define STRENGTHENER_H
 
 #include <list>
+#include <string>
 #include <unordered_set>
+#include <vector>
 
 #include "interval.h"
 #include "intervalmap.h"
+#include "linear.h"
+#include "real_interval.h"
 #include "z3++.h"
 
 class Strengthener {
@@ -20,15 +24,36 @@ class Strengthener {
 
  public:
   IntervalMap i_map;
+  RealIntervalMap r_map;
+  // literals whose ite terms were replaced by the branch active in the model
+  unsigned long ite_rewrites = 0;
 
   Strengthener(z3::context& con, z3::model& mod, bool deb)
       : c(con), model(mod), debug(deb){};
-  class NoRuleForStrengthening : std::exception {};
+  class NoRuleForStrengthening : std::exception {
+   public:
+    const std::string rule;  // what had no rule, for statistics
+    explicit NoRuleForStrengthening(std::string _rule = "unknown")
+        : rule(std::move(_rule)) {}
+  };
   void strengthen_literal(
       const z3::expr& literal);  // _strengthen_conjunct in python
+  /*
+   * Pins every Int, Real or bit-vector variable and array access in the
+   * literal to its value in the model, for a literal that has no
+   * strengthening rule.
+   */
+  void pin_literal(const z3::expr& literal);
   void print_interval_map();
 
  private:
+  /*
+   * Replaces every outermost ite term of e by the branch the model takes,
+   * and collects the condition (or its negation) that makes it so.
+   */
+  z3::expr remove_ite(const z3::expr& e, std::vector<z3::expr>& guards);
+  /* strengthens a guard, which may be any boolean combination of literals */
+  void strengthen_guard(const z3::expr& guard);
   void strengthen_binary_bool_literal(const z3::expr& lhs, int64_t lhs_value,
                                       int64_t rhs_value, Z3_decl_kind op);
   void strengthen_add(const z3::expr& lhs, int64_t lhs_value,
@@ -42,13 +67,67 @@ class Strengthener {
                        int64_t rhs_value);
   void strengthen_mult_by_constant(const z3::expr& non_constant_arg,
                                    int64_t non_constant_arg_value,
-                                   int64_t constant_value, int64_t rhs_value,
+                                   int128_t constant_value, int64_t rhs_value,
                                    Z3_decl_kind op);
   void strengthen_mult_without_constants(const z3::expr& lhs, int64_t lhs_value,
                                          std::list<int64_t>& arguments_values,
                                          Z3_decl_kind op, int64_t rhs_value);
   void strengthen_sub(const z3::expr& lhs, std::list<int64_t>& arguments_values,
                       Z3_decl_kind op, int64_t rhs_value);
+  /* div, mod and rem with the SMT-LIB semantics: a = b*div(a,b) + mod(a,b)
+   * where 0 <= mod(a,b) < |b|, and rem(a,b) is mod(a,b) negated for b < 0 */
+  void strengthen_div(const z3::expr& lhs, std::list<int64_t>& arguments_values,
+                      Z3_decl_kind op, int64_t rhs_value);
+  void strengthen_div_by_constant(const z3::expr& dividend,
+                                  int64_t dividend_value, int64_t divisor,
+                                  Z3_decl_kind op, int64_t rhs_value);
+  void strengthen_division_by_zero(const z3::expr& dividend,
+                                   int64_t dividend_value,
+                                   const z3::expr& divisor);
+  void strengthen_mod(const z3::expr& lhs, std::list<int64_t>& arguments_values,
+                      Z3_decl_kind op, int64_t rhs_value);
+  void strengthen_mod_by_constant(const z3::expr& dividend,
+                                  int64_t dividend_value, int64_t divisor,
+                                  Z3_decl_kind op, int64_t rhs_value);
+  /*
+   * Real comparisons, with the rules of the Int ones but exact division and
+   * strict bounds kept strict.
+   */
+  void strengthen_real_literal(const z3::expr& literal);
+  void strengthen_real(const z3::expr& term, const Rational& value,
+                       Z3_decl_kind op, const Rational& bound);
+  void strengthen_real_add(const z3::expr& term, const Rational& value,
+                           Z3_decl_kind op, const Rational& bound);
+  void strengthen_to_real(const z3::expr& term, Z3_decl_kind op,
+                          const Rational& bound);
+  void add_real_interval(const z3::expr& var, Z3_decl_kind op,
+                         const Rational& bound);
+  /* throws NoRuleForStrengthening if the value doesn't fit in int128 */
+  int128_t model_eval_to_int128(const z3::expr& e);
+  /* throws NoRuleForStrengthening if the value doesn't fit in a Rational */
+  Rational model_eval_to_rational(const z3::expr& e);
+  /*
+   * Bit-vector comparisons, possibly negated. Bounds are kept on the unsigned
+   * value; every term stays on the side of the wraparound (and, for signed
+   * comparisons, in the sign half) of the seed, where the operations are
+   * monotone.
+   */
+  void strengthen_bv_literal(const z3::expr& literal, bool negated);
+  /* bounds term in [low, high], in the signed or unsigned order */
+  void strengthen_bv_order_range(const z3::expr& term, int128_t low,
+                                 int128_t high, bool is_signed);
+  /* bounds the unsigned value of term in [low, high], which has the seed */
+  void strengthen_bv_range(const z3::expr& term, int128_t low, int128_t high);
+  void strengthen_bv_add(const z3::expr& term, int128_t low, int128_t high);
+  void strengthen_bv_mul(const z3::expr& term, int128_t low, int128_t high);
+  void strengthen_bv_udiv(const z3::expr& term, int128_t low, int128_t high);
+  void strengthen_bv_urem(const z3::expr& term, int128_t low, int128_t high);
+  void strengthen_bv_concat(const z3::expr& term, int128_t low, int128_t high);
+  void strengthen_bv_extract(const z3::expr& term, int128_t low,
+                             int128_t high);
+  void strengthen_bv_sign_extend(const z3::expr& term, int128_t low,
+                                 int128_t high);
+  void add_bv_interval(const z3::expr& var, int128_t low, int128_t high);
   void add_interval(const z3::expr& lhs, int64_t rhs_value, Z3_decl_kind op);
   void add_interval_wrapper(const z3::expr& lhs, int64_t rhs_value,
                             Z3_decl_kind op);
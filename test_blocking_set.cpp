@@ -0,0 +1,164 @@
+#include <cassert>
+#include <cstdint>
+#include <string>
+
+#include "blocking_set.h"
+
+/* whether the active clauses block every point that satisfies point */
+static bool blocked(const BlockingSet& set, z3::solver& solver,
+                    const z3::expr& point) {
+  solver.push();
+  solver.add(point);
+  const z3::check_result res = solver.check(set.assumptions());
+  solver.pop();
+  return res == z3::unsat;
+}
+
+/* adds n boxes over fresh variables, which nothing subsumes or merges */
+static void pad(BlockingSet& set, z3::context& c, unsigned int n) {
+  static unsigned int next = 0;
+  for (unsigned int k = 0; k < n; k++) {
+    const std::string name = "pad" + std::to_string(next++);
+    IntervalMap box;
+    box[c.int_const(name.c_str())] = Interval(0, 0);
+    set.add(box, z3::expr(c));
+  }
+}
+
+static void test_subsumption(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::solver solver(c);
+  BlockingSet set(c, solver, 100);
+  set.start();
+  IntervalMap box;
+  box[x] = Interval(0, 10);
+  set.add(box, z3::expr(c));
+  box[x] = Interval(2, 5);
+  set.add(box, z3::expr(c));
+  assert(set.size() == 1);
+  assert(set.to_json()["subsumed"].asUInt64() == 1);
+  box[x] = Interval(-5, 20);
+  set.add(box, z3::expr(c));
+  assert(set.size() == 1);
+  assert(set.to_json()["subsumed"].asUInt64() == 2);
+  assert(blocked(set, solver, x == -5) && blocked(set, solver, x == 20));
+  assert(!blocked(set, solver, x == 21));
+  // a box with extra bounds is kept as is
+  box[x] = Interval(3, 4);
+  set.add(box, y > 0);
+  assert(set.size() == 2);
+  // the top interval blocks nothing, so a box of it only isn't even added
+  box[x] = Interval();
+  set.add(box, z3::expr(c));
+  assert(set.size() == 2);
+  assert(set.to_json()["added"].asUInt64() == 4);
+}
+
+static void test_adjacent_merge(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::solver solver(c);
+  BlockingSet set(c, solver, 100);
+  set.start();
+  // 16 boxes side by side along x merge into one
+  for (int64_t k = 0; k < 16; k++) {
+    IntervalMap box;
+    box[x] = Interval(10 * k, 10 * k + 9);
+    box[y] = Interval(0, 5);
+    set.add(box, z3::expr(c));
+  }
+  assert(set.size() == 1);
+  assert(set.to_json()["merged"].asUInt64() == 15);
+  assert(blocked(set, solver, x == 0 && y == 5));
+  assert(blocked(set, solver, x == 159 && y == 0));
+  assert(!blocked(set, solver, x == 160 && y == 0));
+  assert(!blocked(set, solver, x == 0 && y == 6));
+
+  // boxes with a gap between them, or that differ in two intervals, don't
+  z3::solver other_solver(c);
+  BlockingSet other(c, other_solver, 100);
+  other.start();
+  IntervalMap box;
+  box[x] = Interval(0, 9);
+  box[y] = Interval(0, 5);
+  other.add(box, z3::expr(c));
+  box[x] = Interval(11, 20);
+  other.add(box, z3::expr(c));
+  box[y] = Interval(6, 8);
+  box[x] = Interval(0, 20);
+  other.add(box, z3::expr(c));
+  pad(other, c, 13);
+  assert(other.to_json()["merged"].asUInt64() == 0);
+  assert(!blocked(other, other_solver, x == 10 && y == 0));
+}
+
+static void test_merge_to_free(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::expr b = c.bool_const("b");
+  z3::solver solver(c);
+  BlockingSet set(c, solver, 100);
+  set.start();
+  // b and !b together leave b free
+  IntervalMap box;
+  box[b] = Interval(1, 1);
+  box[x] = Interval(0, 5);
+  set.add(box, z3::expr(c));
+  box[b] = Interval(0, 0);
+  set.add(box, z3::expr(c));
+  // x <= -1 and x >= 0 together leave x unbounded
+  IntervalMap halves;
+  halves[x] = Interval(INT64_MIN, -1);
+  halves[y] = Interval(7, 7);
+  set.add(halves, z3::expr(c));
+  halves[x] = Interval(0, INT64_MAX);
+  set.add(halves, z3::expr(c));
+  pad(set, c, 12);
+  assert(set.to_json()["merged"].asUInt64() == 2);
+  assert(set.size() == 14);
+  assert(blocked(set, solver, b && x == 0));
+  assert(blocked(set, solver, !b && x == 5));
+  assert(!blocked(set, solver, x == 6 && y == 0));
+  assert(blocked(set, solver, x == c.int_val(INT64_MIN) && y == 7));
+  assert(blocked(set, solver, x == c.int_val(INT64_MAX) && y == 7));
+}
+
+static void test_retire(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::solver solver(c);
+  solver.add(x >= 0 && x <= 30);
+  BlockingSet set(c, solver, 2);
+  set.start();
+  for (int64_t k = 0; k < 3; k++) {
+    IntervalMap box;
+    box[x] = Interval(20 * k, 20 * k + 5);
+    set.add(box, z3::expr(c));
+  }
+  // the oldest box is retired over max_active
+  assert(set.size() == 2);
+  assert(set.to_json()["retired"].asUInt64() == 1);
+  assert(!blocked(set, solver, x == 0) && blocked(set, solver, x == 20));
+  // [0, 30] subsumes [20, 25], and the retired clauses are dropped
+  IntervalMap box;
+  box[x] = Interval(0, 30);
+  set.add(box, z3::expr(c));
+  assert(set.size() == 2);
+  assert(set.to_json()["rebuilds"].asUInt64() == 1);
+  // everything is blocked, by the box in the core
+  assert(solver.check(set.assumptions()) == z3::unsat);
+  assert(set.retire_core());
+  assert(set.size() == 1);
+  assert(solver.check(set.assumptions()) == z3::sat);
+  assert(!blocked(set, solver, x == 20));
+}
+
+int main() {
+  z3::context c;
+  test_subsumption(c);
+  test_adjacent_merge(c);
+  test_merge_to_free(c);
+  test_retire(c);
+  std::cout << "TEST SUCCESSFUL\n";
+  return 0;
+}
@@ -0,0 +1,107 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "box_registry.h"
+
+static IntervalMap box_of(const z3::expr& x, int64_t low, int64_t high) {
+  IntervalMap box;
+  box[x] = Interval(low, high);
+  return box;
+}
+
+/* whether count out of trials is within 5% of trials * p */
+static bool close_to(unsigned long count, unsigned long trials, double p) {
+  return std::fabs((double)count - trials * p) <= 0.05 * trials * p;
+}
+
+static void test_add(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  BoxRegistry registry(2);
+  IntervalMap unbounded;
+  unbounded[x] = Interval(0, 10);
+  unbounded[y] = Interval();
+  assert(!registry.add(unbounded, {}));
+  assert(registry.add(box_of(x, 0, 9), {}));
+  assert(!registry.add(box_of(x, 0, 9), {}));
+  assert(registry.add(box_of(x, 0, 29), {}));
+  // full: a smaller box is dropped, a larger one replaces the smallest
+  assert(!registry.add(box_of(x, 0, 4), {}));
+  assert(registry.add(box_of(x, 100, 119), {}));
+  assert(registry.size() == 2);
+  assert(registry.get_total_volume() == 50);
+}
+
+static void test_accept(z3::context& c) {
+  constexpr unsigned long TRIALS = 30000;
+  z3::expr x = c.int_const("x");
+  BoxRegistry registry(10);
+  registry.add(box_of(x, 0, 9), {});
+  registry.add(box_of(x, 5, 14), {});
+  registry.add(box_of(x, 5, 19), {});
+  std::mt19937 g(0);
+  const std::vector<std::string> names{"x"};
+  // x is in 1, 3, 2 and 1 of the boxes
+  const int64_t points[] = {2, 7, 12, 17};
+  const double expected[] = {1.0, 1.0 / 3, 1.0 / 2, 1.0};
+  unsigned long rejected = 0;
+  for (unsigned int i = 0; i < 4; i++) {
+    Model sample(names);
+    sample.addIntAssignment("x", points[i]);
+    unsigned long accepted = 0;
+    for (unsigned long n = 0; n < TRIALS; n++) {
+      if (registry.accept(sample, g)) accepted++;
+    }
+    assert(close_to(accepted, TRIALS, expected[i]));
+    rejected += TRIALS - accepted;
+  }
+  assert(registry.get_rejected() == rejected);
+}
+
+static void test_volume_weighting(z3::context& c) {
+  constexpr unsigned long TRIALS = 60000;
+  z3::expr x = c.int_const("x");
+  BoxRegistry registry(10);
+  registry.add(box_of(x, 0, 9), {});
+  registry.add(box_of(x, 0, 29), {});
+  std::mt19937 g(0);
+  unsigned long large = 0;
+  for (unsigned long n = 0; n < TRIALS; n++) {
+    if (registry.choose(g).volume == 30) large++;
+  }
+  assert(close_to(large, TRIALS, 0.75));
+
+  // choosing a box by volume, a point of it uniformly, and accepting by the
+  // overlap samples the union of the boxes uniformly
+  BoxRegistry overlapping(10);
+  overlapping.add(box_of(x, 0, 9), {});
+  overlapping.add(box_of(x, 5, 14), {});
+  const std::vector<std::string> names{"x"};
+  std::vector<unsigned long> counts(15, 0);
+  unsigned long accepted = 0;
+  for (unsigned long n = 0; n < TRIALS; n++) {
+    const Interval& interval = overlapping.choose(g).i_map.at(x);
+    const int64_t value = std::uniform_int_distribution<int64_t>(
+        interval.get_low(), interval.get_high())(g);
+    Model sample(names);
+    sample.addIntAssignment("x", value);
+    if (!overlapping.accept(sample, g)) continue;
+    counts[value]++;
+    accepted++;
+  }
+  for (const unsigned long count : counts) {
+    assert(close_to(count, accepted, 1.0 / 15));
+  }
+}
+
+int main() {
+  z3::context c;
+  test_add(c);
+  test_accept(c);
+  test_volume_weighting(c);
+  std::cout << "TEST SUCCESSFUL\n";
+  return 0;
+}
@@ -0,0 +1,349 @@
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "coverage.h"
+
+/*
+ * WireCoverageStatistics of scripts/calc_metric.py, over the evaluation of
+ * z3: every Bool and Int wire of the formula counts, and a sample covers the
+ * wires that the recursive evaluation of the script reaches. Bit-vector
+ * wires, which the script doesn't handle, count their width.
+ */
+static uint64_t mask(unsigned int width) {
+  return width == 64 ? ~(uint64_t)0 : ((uint64_t)1 << width) - 1;
+}
+
+/* the value as samples write bit-vectors: hex, a digit per 4 bits */
+static std::string hex(uint64_t value, unsigned int width) {
+  static const char digits[] = "0123456789abcdef";
+  std::string result;
+  for (int i = (width + 3) / 4 - 1; i >= 0; i--) {
+    result += digits[(value >> (4 * i)) & 15];
+  }
+  return result;
+}
+
+class CalcMetric {
+ public:
+  explicit CalcMetric(const z3::expr& formula) : formula(formula) {
+    register_wires(formula);
+  }
+
+  void add_sample(const z3::model& m) { evaluate(m, formula); }
+
+  [[nodiscard]] uint64_t covered() const {
+    uint64_t result = 0;
+    for (const auto& wire : wires) {
+      const uint64_t both = wire.second.one & wire.second.zero;
+      result += __builtin_popcountll(both & wire.second.mask);
+    }
+    return result;
+  }
+
+  [[nodiscard]] uint64_t total() const {
+    uint64_t result = 0;
+    for (const auto& wire : wires) {
+      result += __builtin_popcountll(wire.second.mask);
+    }
+    return result;
+  }
+
+ private:
+  struct Wire {
+    uint64_t mask;
+    uint64_t one = 0;
+    uint64_t zero = 0;
+  };
+  const z3::expr formula;
+  std::map<unsigned int, Wire> wires;
+
+  void register_wires(const z3::expr& e) {
+    if (wires.count(e.id())) return;
+    if (e.is_bool()) wires[e.id()] = Wire{1};
+    if (e.is_int()) wires[e.id()] = Wire{~(uint64_t)0};
+    if (e.is_bv()) wires[e.id()] = Wire{mask(e.get_sort().bv_size())};
+    for (unsigned int i = 0; i < e.num_args(); i++) register_wires(e.arg(i));
+  }
+
+  void evaluate(const z3::model& m, const z3::expr& e) {
+    const z3::expr value = m.eval(e, true);
+    const auto it = wires.find(e.id());
+    if (it != wires.end()) {
+      uint64_t bits;
+      if (e.is_bool()) {
+        bits = value.is_true();
+      } else if (e.is_bv()) {
+        bits = value.get_numeral_uint64();
+      } else {
+        bits = (uint64_t)value.get_numeral_int64();
+      }
+      it->second.one |= bits;
+      it->second.zero |= ~bits;
+    }
+    // all and any stop at the first false and true argument
+    if (e.is_and() || e.is_or()) {
+      for (unsigned int i = 0; i < e.num_args(); i++) {
+        evaluate(m, e.arg(i));
+        if (m.eval(e.arg(i), true).is_true() == e.is_or()) break;
+      }
+    } else if (e.is_ite()) {
+      evaluate(m, e.arg(0));
+      evaluate(m, m.eval(e.arg(0), true).is_true() ? e.arg(1) : e.arg(2));
+    } else {
+      for (unsigned int i = 0; i < e.num_args(); i++) evaluate(m, e.arg(i));
+    }
+  }
+};
+
+static void test_short_circuit(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  // wires: the and, x > 0, x < 3 and the Ints x, 0 and 3
+  WireCoverage coverage(x > 0 && x < 3);
+  assert(coverage.get_total() == 3 + 3 * 64);
+  // x < 3 isn't reached when x is -1: only true when x is 5
+  coverage.add_sample("x:-1;");
+  assert(coverage.add_sample("x:5;"));
+  // x > 0 both ways, and the bits of 5 that -1 has as 1 too
+  assert(coverage.get_covered() == 1 + 62);
+  assert(!coverage.add_sample("x:-1;"));
+  assert(coverage.add_sample("x:1;"));
+  assert(coverage.get_covered() == 1 + 1 + 1 + 63);
+  assert(coverage.get_num_samples() == 4);
+}
+
+static void test_calc_metric(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::expr z = c.int_const("z");
+  z3::expr b = c.bool_const("b");
+  const z3::expr sum = x + y;
+  const z3::expr formula =
+      (sum <= 5 || b) && (!(z3::ite(b, x, 2 * z) == y - 1) || !(z > sum)) &&
+      (x - z >= -3 * y || (b && z < 7)) && z3::ite(x >= y, sum, -z) < 9;
+  WireCoverage coverage(formula);
+  CalcMetric reference(formula);
+  assert(coverage.get_total() == reference.total());
+
+  std::mt19937 g(0);
+  std::uniform_int_distribution<int64_t> value(-10, 10);
+  for (unsigned int n = 0; n < 300; n++) {
+    z3::model m(c);
+    std::string sample;
+    for (const auto& var : {x, y, z}) {
+      const int64_t v = value(g);
+      z3::func_decl decl = var.decl();
+      z3::expr numeral = c.int_val(v);
+      m.add_const_interp(decl, numeral);
+      sample += var.decl().name().str() + ':' + std::to_string(v) + ';';
+    }
+    const bool v = value(g) > 0;
+    z3::func_decl decl = b.decl();
+    z3::expr numeral = c.bool_val(v);
+    m.add_const_interp(decl, numeral);
+    sample += "b:" + std::to_string(v) + ';';
+
+    coverage.add_sample(sample);
+    reference.add_sample(m);
+    assert(coverage.get_covered() == reference.covered());
+  }
+  assert(coverage.get_covered() > 0);
+}
+
+static void test_bv(z3::context& c) {
+  z3::expr u = c.bv_const("u", 8);
+  z3::expr v = c.bv_const("v", 8);
+  z3::expr w = c.bv_const("w", 64);
+  const z3::expr sum = u + v;
+  const z3::expr wide = z3::zext(u, 56) * w + z3::sext(v, 56);
+  // a xor evaluates all of its arguments, so every wire is reached
+  const z3::expr formula =
+      z3::ule(sum * 3, v - u) ^ z3::ult(z3::udiv(u, v), z3::urem(u, v)) ^
+      (u / v <= z3::srem(u, v)) ^ (z3::smod(u, v) < -v) ^
+      z3::uge(z3::shl(u, v) | z3::lshr(u, v), z3::ashr(u, v) & ~v) ^
+      z3::ugt((u ^ v).extract(6, 1), z3::concat(u, v).extract(11, 6)) ^
+      (z3::ashr(wide, 3) >= w - z3::sext(sum, 56)) ^
+      (z3::concat(u.extract(3, 0), v) > z3::zext(sum, 4)) ^
+      (z3::lshr(w, z3::zext(v, 56)) == wide);
+  assert(WireCoverage(formula).get_total() == CalcMetric(formula).total());
+
+  // the edges of the ranges, and values in between
+  const std::vector<uint64_t> edges{0, 1, 2, 0x7f, 0x80, 0x81, 0xfe, 0xff};
+  std::mt19937_64 g(0);
+  const auto draw = [&g, &edges](unsigned int width) {
+    if (g() % 2) return g() & mask(width);
+    const uint64_t edge = edges[g() % edges.size()];
+    return width == 8 ? edge : (edge << 56) | (edge & 1);
+  };
+  // two samples cover the bits in which they differ, so a wrong value shows
+  // where the bits of many samples would hide it
+  for (unsigned int n = 0; n < 500; n++) {
+    WireCoverage coverage(formula);
+    CalcMetric reference(formula);
+    for (unsigned int k = 0; k < 2; k++) {
+      z3::model m(c);
+      std::string sample;
+      for (const auto& var : {u, v, w}) {
+        const unsigned int width = var.get_sort().bv_size();
+        const uint64_t value = draw(width);
+        z3::func_decl decl = var.decl();
+        z3::expr numeral = c.bv_val(value, width);
+        m.add_const_interp(decl, numeral);
+        sample += decl.name().str() + ':' + hex(value, width) + ';';
+      }
+      coverage.add_sample(sample);
+      reference.add_sample(m);
+    }
+    assert(coverage.get_covered() == reference.covered());
+  }
+}
+
+static z3::expr to_int(const z3::expr& e) {
+  return z3::expr(e.ctx(), Z3_mk_real2int(e.ctx(), e));
+}
+
+static void test_real(z3::context& c) {
+  z3::expr r = c.real_const("r");
+  z3::expr s = c.real_const("s");
+  z3::expr x = c.int_const("x");
+  const z3::expr third = c.real_val(1, 3);
+  // Real wires don't count, the Bool and Int wires above them do
+  const z3::expr formula =
+      (r + s * third <= z3::to_real(x)) ^ (r / (s * s + 1) > -third) ^
+      (z3::ite(r < s, r - s, -s) == third * 2) ^ (to_int(r * 3) > x) ^
+      z3::is_int(r + s) ^ (to_int(s) + x < 4);
+  WireCoverage empty(formula);
+  assert(empty.get_total() == CalcMetric(formula).total());
+  // the atoms, the xors, r < s, and x, 4, the to_ints and their sum
+  assert(empty.get_total() == 6 + 5 + 1 + 5 * 64);
+
+  std::mt19937 g(0);
+  std::uniform_int_distribution<int64_t> numerator(-12, 12);
+  std::uniform_int_distribution<int64_t> denominator(1, 6);
+  for (unsigned int n = 0; n < 300; n++) {
+    WireCoverage coverage(formula);
+    CalcMetric reference(formula);
+    for (unsigned int k = 0; k < 2; k++) {
+      z3::model m(c);
+      std::string sample;
+      for (const auto& var : {r, s}) {
+        const Rational value(numerator(g), denominator(g));
+        z3::func_decl decl = var.decl();
+        z3::expr numeral = c.real_val(value.to_string().c_str());
+        m.add_const_interp(decl, numeral);
+        sample += decl.name().str() + ':' + value.to_string() + ';';
+      }
+      const int64_t value = numerator(g);
+      z3::func_decl decl = x.decl();
+      z3::expr numeral = c.int_val(value);
+      m.add_const_interp(decl, numeral);
+      sample += "x:" + std::to_string(value) + ';';
+      coverage.add_sample(sample);
+      reference.add_sample(m);
+    }
+    assert(coverage.get_covered() == reference.covered());
+  }
+  // a value that doesn't fit leaves what is above it unevaluated
+  WireCoverage coverage(r < s);
+  coverage.add_sample("r:1/3;s:1;");
+  coverage.add_sample("r:99999999999999999999;s:0;");
+  assert(coverage.get_covered() == 0);
+  coverage.add_sample("r:2;s:1;");
+  assert(coverage.get_covered() == 1);
+}
+
+static void test_uf(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::expr b = c.bool_const("b");
+  z3::expr u = c.bv_const("u", 8);
+  z3::func_decl f = c.function("f", c.int_sort(), c.int_sort());
+  z3::func_decl g = c.function("g", c.int_sort(), c.bool_sort(), c.bool_sort());
+  z3::func_decl h = c.function("h", c.bv_sort(8), c.bv_sort(8));
+  const z3::expr formula = (f(x) > f(f(y))) ^ g(x + 1, b) ^ !g(y, !b) ^
+                           z3::ule(h(u) + h(u + 1), u) ^ (f(x) == y);
+  assert(WireCoverage(formula).get_total() == CalcMetric(formula).total());
+
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int64_t> small(-3, 3);
+  // a small value of sort, and how samples write it
+  const auto draw = [&](const z3::sort& sort, std::string& text) {
+    if (sort.is_bool()) {
+      const bool value = gen() % 2;
+      text = std::to_string(value);
+      return c.bool_val(value);
+    }
+    if (sort.is_bv()) {
+      const uint64_t value = (uint64_t)small(gen) & 0xff;
+      text = hex(value, 8);
+      return c.bv_val(value, 8);
+    }
+    const int64_t value = small(gen);
+    text = std::to_string(value);
+    return c.int_val(value);
+  };
+  // a table of a few entries
+  const auto table = [&](z3::model& m, z3::func_decl& decl) {
+    std::string entries;
+    std::string default_value;
+    z3::expr else_value = draw(decl.range(), default_value);
+    z3::func_interp interp = m.add_func_interp(decl, else_value);
+    const unsigned int n = gen() % 4;
+    std::set<std::string> keys;
+    for (unsigned int j = 0; j < n; j++) {
+      z3::expr_vector args(c);
+      std::string key;
+      for (unsigned int k = 0; k < decl.arity(); k++) {
+        std::string arg;
+        args.push_back(draw(decl.domain(k), arg));
+        key += arg + ':';
+      }
+      if (!keys.insert(key).second) continue;
+      std::string value;
+      z3::expr value_expr = draw(decl.range(), value);
+      interp.add_entry(args, value_expr);
+      entries += key + value + ',';
+    }
+    return decl.name().str() + ":(" + std::to_string(keys.size()) + ';' +
+           default_value + ';' + entries + ");";
+  };
+  for (unsigned int n = 0; n < 300; n++) {
+    WireCoverage coverage(formula);
+    CalcMetric reference(formula);
+    for (unsigned int k = 0; k < 2; k++) {
+      z3::model m(c);
+      std::string sample;
+      for (const auto& var : {x, y, b, u}) {
+        std::string value;
+        z3::expr numeral = draw(var.get_sort(), value);
+        z3::func_decl decl = var.decl();
+        m.add_const_interp(decl, numeral);
+        sample += decl.name().str() + ':' + value + ';';
+      }
+      sample += table(m, f) + table(m, g) + table(m, h);
+      coverage.add_sample(sample);
+      reference.add_sample(m);
+    }
+    assert(coverage.get_covered() == reference.covered());
+  }
+  // a function missing from the sample is the constant 0
+  WireCoverage coverage(f(x) == 0);
+  coverage.add_sample("x:1;");
+  coverage.add_sample("x:1;f:(1;0;1:5,);");
+  assert(coverage.get_covered() == 1 + 2);
+}
+
+int main() {
+  z3::context c;
+  test_short_circuit(c);
+  test_calc_metric(c);
+  test_bv(c);
+  test_real(c);
+  test_uf(c);
+  std::cout << "TEST SUCCESSFUL\n";
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "disjunct_policy.h"
+
+static constexpr unsigned long MAX_EPOCH_SAMPLES = 100;
+
+static MeGA::SamplerConfig config() {
+  return MeGA::SamplerConfig(
+      false, false, false, false, false, false, 0, MAX_EPOCH_SAMPLES, 60, 60,
+      0, false, true, 0, 0, false, 0, MeGA::EPOCH_POLICY_LEGACY, false, false,
+      MeGA::STRENGTHEN_LEGACY, false, MeGA::SEED_MODE_MAXSMT, false, 0, 1,
+      MeGA::DISJUNCT_POLICY_UCB, false, false);
+}
+
+/* the pulls of every child of the reported disjunction */
+static std::vector<uint64_t> pulls(const DisjunctPolicy& policy,
+                                   const z3::expr& disjunction) {
+  std::vector<uint64_t> result(disjunction.num_args(), 0);
+  const Json::Value json = policy.to_json();
+  for (const auto& reported : json["preferences"]) {
+    for (const auto& choice : reported["disjuncts"]) {
+      for (unsigned int child = 0; child < disjunction.num_args(); child++) {
+        if (choice["disjunct"].asString() == disjunction.arg(child).to_string())
+          result[child] = choice["pulls"].asUInt64();
+      }
+    }
+  }
+  return result;
+}
+
+static void test_ucb(z3::context& c) {
+  const MeGA::SamplerConfig ucb_config = config();
+  const auto policy = DisjunctPolicy::create(ucb_config);
+  assert(policy->name() == "ucb");
+  z3::expr_vector children(c);
+  children.push_back(c.bool_const("a"));
+  children.push_back(c.bool_const("b"));
+  children.push_back(c.bool_const("c"));
+  const z3::expr disjunction = z3::mk_or(children);
+  const std::vector<unsigned int> all{0, 1, 2};
+  std::mt19937 g(0);
+  // a single satisfied child is no choice, and learns nothing
+  assert(policy->choose(disjunction, {1}, g) == 1);
+  policy->reward(10.0, MAX_EPOCH_SAMPLES);
+  assert(policy->to_json()["learned disjunctions"].asUInt64() == 0);
+  // a discarded choice isn't credited
+  policy->choose(disjunction, all, g);
+  policy->discard();
+  policy->reward(10.0, MAX_EPOCH_SAMPLES);
+  assert(policy->to_json()["learned disjunctions"].asUInt64() == 0);
+
+  // fixed rewards: 2 fills its epochs with the largest boxes, 1 fills them
+  // with smaller boxes, 0 samples little
+  auto reward = [&](unsigned int child) {
+    switch (child) {
+      case 0: policy->reward(2.0, 3); break;
+      case 1: policy->reward(5.0, MAX_EPOCH_SAMPLES); break;
+      default: policy->reward(20.0, MAX_EPOCH_SAMPLES);
+    }
+  };
+  // every child is tried once first
+  std::vector<bool> tried(3, false);
+  for (unsigned int n = 0; n < 3; n++) {
+    const unsigned int child = policy->choose(disjunction, all, g);
+    assert(!tried[child]);
+    tried[child] = true;
+    reward(child);
+  }
+  // with equal bonuses, the best average goes next, and the volume tells
+  // apart the two children that fill their epochs
+  assert(policy->choose(disjunction, all, g) == 2);
+  reward(2);
+  for (unsigned int n = 0; n < 300; n++)
+    reward(policy->choose(disjunction, all, g));
+  const std::vector<uint64_t> counts = pulls(*policy, disjunction);
+  assert(counts[0] + counts[1] + counts[2] == 304);
+  assert(counts[2] > counts[1] && counts[1] > counts[0]);
+  assert(counts[2] > 200);
+  // only satisfied children are chosen
+  for (unsigned int n = 0; n < 10; n++)
+    assert(policy->choose(disjunction, {0, 1}, g) != 2);
+}
+
+int main() {
+  z3::context c;
+  test_ucb(c);
+  std::cout << "TEST SUCCESSFUL\n";
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include <cassert>
+#include <cstdint>
+
+#include "equality_eliminator.h"
+#include "z3_utils.h"
+
+static z3::params simplify_params(z3::context& c) {
+  z3::params params(c);
+  params.set("arith_lhs", true);
+  return params;
+}
+
+static bool mentions(const z3::expr& formula, const z3::expr& var) {
+  z3::expr_vector vars(formula.ctx());
+  collect_vars(formula, vars);
+  for (const auto& v : vars) {
+    if (v.id() == var.id()) return true;
+  }
+  return false;
+}
+
+/*
+ * Eliminates from formula, solves the rest, and checks that the model with
+ * the eliminated variables put back satisfies formula.
+ */
+static EqualityEliminator check_elimination(z3::context& c,
+                                            const z3::expr& formula) {
+  EqualityEliminator eliminator;
+  const z3::expr reduced = eliminator.eliminate(formula, simplify_params(c));
+  z3::solver solver(c);
+  solver.add(reduced);
+  const auto res = solver.check();
+  assert(res == z3::sat);
+  z3::model model = solver.get_model();
+  eliminator.reconstruct(model);
+  assert(model.eval(formula, true).is_true());
+  return eliminator;
+}
+
+static void test_unit_coefficients(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::expr z = c.int_const("z");
+  // coefficient 1: x = 3y + 2z - 5
+  const z3::expr plus = x - 3 * y - 2 * z == -5 && y + z <= 10 && z >= 3;
+  EqualityEliminator eliminator;
+  assert(!mentions(eliminator.eliminate(plus, simplify_params(c)), x));
+  assert(eliminator.size() == 1);
+  check_elimination(c, plus);
+  // coefficient -1: y = 2x - 3, the only variable that can be defined
+  const z3::expr minus = 2 * x - y == 3 && x + y >= 7;
+  EqualityEliminator negated;
+  const z3::expr reduced = negated.eliminate(minus, simplify_params(c));
+  assert(negated.size() == 1);
+  assert(mentions(reduced, x) && !mentions(reduced, y));
+  check_elimination(c, minus);
+  // -x + 3y = 4 with both sides mixed: x = 3y - 4
+  const z3::expr mixed = 3 * y == x + 4 && x > 10;
+  EqualityEliminator mixed_eliminator = check_elimination(c, mixed);
+  assert(mixed_eliminator.size() == 1);
+}
+
+static void test_not_definitions(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::expr z = c.int_const("z");
+  EqualityEliminator eliminator;
+  // no coefficient of magnitude 1, or not linear
+  eliminator.eliminate(2 * x + 4 * y == 6 && x * y == z * z && x >= 0,
+                       simplify_params(c));
+  assert(eliminator.empty());
+  eliminator.eliminate(x + y <= 3 && x != y, simplify_params(c));
+  assert(eliminator.empty());
+}
+
+static void test_reconstruct(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::expr z = c.int_const("z");
+  // a chain, x = 3y + 1 = 6z + 7 in the end
+  const z3::expr chain = x == 3 * y + 1 && y == 2 * z + 2 && z >= 0;
+  EqualityEliminator eliminator = check_elimination(c, chain);
+  assert(eliminator.size() == 2);
+  std::vector<std::string> names;
+  Model sample(names);
+  sample.addIntAssignment("z", 10);
+  assert(eliminator.reconstruct(sample));
+  assert(sample.evalIntVar("x").first == 67);
+  assert(sample.evalIntVar("y").first == 22);
+  // a value that overflows int64 fails
+  Model at_limit(names);
+  at_limit.addIntAssignment("z", INT64_MAX / 2);
+  assert(!eliminator.reconstruct(at_limit));
+  // variables of the definitions that the sample lacks are drawn, over all
+  // of int64, so x = -z only overflows for INT64_MIN
+  EqualityEliminator negation = check_elimination(c, x == -z && z >= 0);
+  Model empty(names);
+  assert(negation.reconstruct(empty));
+  const auto z_value = empty.evalIntVar("z");
+  assert(z_value.second);
+  assert(empty.evalIntVar("x").first == -z_value.first);
+}
+
+int main() {
+  z3::context c;
+  test_unit_coefficients(c);
+  test_not_definitions(c);
+  test_reconstruct(c);
+  std::cout << "TEST SUCCESSFUL\n";
+  return 0;
+}
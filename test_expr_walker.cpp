@@ -0,0 +1,81 @@
+#include <cassert>
+#include <vector>
+
+#include "expr_walker.h"
+#include "z3_utils.h"
+
+static std::vector<unsigned int> visit_order(ExprWalker& walker,
+                                             const z3::expr& root) {
+  std::vector<unsigned int> order;
+  walker.walk(root, [&order](const z3::expr& e) {
+    order.push_back(e.id());
+    return true;
+  });
+  return order;
+}
+
+static void test_shared_nodes(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  // 2^64 paths to x, through 65 distinct terms
+  z3::expr e = x;
+  for (unsigned int i = 0; i < 64; i++) e = e + e;
+  ExprWalker walker;
+  std::vector<unsigned int> order = visit_order(walker, e);
+  assert(order.size() == 65);
+  assert(order.front() == e.id() && order.back() == x.id());
+  // another root only visits what the first one didn't
+  order = visit_order(walker, e * 2);
+  assert(order.size() == 2);
+  order = visit_order(walker, e);
+  assert(order.empty());
+
+  z3::expr a = c.constant("a", c.array_sort(c.int_sort(), c.int_sort()));
+  const z3::expr select = z3::select(a, x);
+  assert(count_selects(select + select * select) == 1);
+  z3::expr_vector vars(c);
+  collect_vars(e * x + e, vars);
+  assert(vars.size() == 1 && vars[0].id() == x.id());
+}
+
+static void test_order(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::expr z = c.int_const("z");
+  const z3::expr sum = x + y;
+  const z3::expr difference = x - z;
+  const z3::expr product = sum * difference;
+  // pre-order, children in order, x only the first time
+  ExprWalker walker;
+  const std::vector<unsigned int> expected{
+      product.id(), sum.id(), x.id(), y.id(), difference.id(), z.id()};
+  assert(visit_order(walker, product) == expected);
+}
+
+static void test_descend(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::expr b = c.bool_const("b");
+  // walks the branch of the ite that b takes only
+  const z3::expr ite = z3::ite(b, x + 1, y - 1);
+  ExprWalker walker;
+  std::vector<unsigned int> order;
+  walker.walk(ite, [&](const z3::expr& e) {
+    order.push_back(e.id());
+    if (e.id() != ite.id()) return true;
+    walker.descend(e.arg(2));
+    return false;
+  });
+  const z3::expr& branch = ite.arg(2);
+  const std::vector<unsigned int> expected{ite.id(), branch.id(), y.id(),
+                                           branch.arg(1).id()};
+  assert(order == expected);
+}
+
+int main() {
+  z3::context c;
+  test_shared_nodes(c);
+  test_order(c);
+  test_descend(c);
+  std::cout << "TEST SUCCESSFUL\n";
+  return 0;
+}
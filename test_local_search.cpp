@@ -0,0 +1,84 @@
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "local_search.h"
+
+/* whether point, in the order of the variables of search, satisfies formula */
+static bool satisfies(z3::context& c, const LocalSearch& search,
+                      const std::vector<int64_t>& point,
+                      const z3::expr& formula) {
+  z3::model m(c);
+  for (size_t i = 0; i < point.size(); i++) {
+    z3::func_decl decl = search.get_vars()[i].decl();
+    z3::expr value = c.int_val(point[i]);
+    m.add_const_interp(decl, value);
+  }
+  return m.eval(formula, true).is_true();
+}
+
+/* point with x and y at their values, in the order of the variables */
+static std::vector<int64_t> point_of(const LocalSearch& search,
+                                     const z3::expr& x, int64_t x_value,
+                                     int64_t y_value) {
+  const bool x_first = search.get_vars()[0].id() == x.id();
+  return x_first ? std::vector<int64_t>{x_value, y_value}
+                 : std::vector<int64_t>{y_value, x_value};
+}
+
+static void test_search(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  const z3::expr formula = x >= 0 && x <= 10 && y >= 0 && y <= 10 &&
+                           x + y <= 15 && (x <= 2 || y >= 3);
+  LocalSearch search;
+  assert(search.compile(formula));
+  assert(search.get_vars().size() == 2);
+  std::mt19937 g(0);
+  const std::atomic<bool> stop{false};
+  // a model is left as is
+  std::vector<int64_t> point = point_of(search, x, 3, 4);
+  assert(search.search(point, g, stop));
+  assert(point == point_of(search, x, 3, 4));
+  // x one past its bound: the only critical move puts it back on it
+  point = point_of(search, x, 11, 4);
+  assert(search.search(point, g, stop));
+  assert(point == point_of(search, x, 10, 4));
+  // from a perturbation of a model, another model
+  for (unsigned int n = 0; n < 100; n++) {
+    point = point_of(search, x, 3, 4);
+    LocalSearch::perturb(point, g);
+    assert(search.search(point, g, stop));
+    assert(satisfies(c, search, point, formula));
+  }
+  // a stopped search gives up on a point that isn't a model
+  const std::atomic<bool> stopped{true};
+  point = point_of(search, x, 11, 4);
+  assert(!search.search(point, g, stopped));
+}
+
+static void test_compile(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  LocalSearch non_linear;
+  assert(!non_linear.compile(x * y <= 3 && x >= 0));
+  LocalSearch never;
+  assert(!never.compile(x >= 0 && (c.bool_val(false) || c.int_val(1) > 2)));
+  // x != y is x < y or x > y
+  LocalSearch distinct;
+  assert(distinct.compile(x != y && x >= 0 && x <= 0 && y >= -1 && y <= 1));
+  std::vector<int64_t> point{0, 0};
+  std::mt19937 g(0);
+  const std::atomic<bool> stop{false};
+  assert(distinct.search(point, g, stop));
+  assert(point[0] != point[1]);
+}
+
+int main() {
+  z3::context c;
+  test_search(c);
+  test_compile(c);
+  std::cout << "TEST SUCCESSFUL\n";
+  return 0;
+}
@@ -2,15 +2,19 @@
 // Created by batchen on 06/02/2022.
 //
 
+#include <cassert>
+#include <cstdint>
+
 #include "z3++.h"
 #include "model.h"
 
 int main()
 {
-    Model new_m = Model();
+    std::vector<std::string> var_names;
+    Model new_m(var_names);
     z3::context c;
     bool res;
-    std::pair<int,bool> p;
+    std::pair<int64_t, bool> p;
     z3::expr e1(c);
     p = new_m.evalArrayVar("a",0);
     assert(!p.second);
@@ -118,7 +122,7 @@ int main()
     assert(!p.second);
     p = new_m.evalIntExpr(c.int_const("w"), true, true);
     assert(p.second);
-    int w_val = p.first;
+    int64_t w_val = p.first;
     p = new_m.evalIntVar("w");
     assert(p.second);
     assert(p.first == w_val);
@@ -127,12 +131,66 @@ int main()
     assert(!p.second);
     p = new_m.evalIntExpr(e1, true, true);
     assert(p.second);
-    int e1_val = p.first;
+    int64_t e1_val = p.first;
     p = new_m.evalIntExpr(e1, true, true);
     assert(p.second);
     assert(e1_val == p.first);
     e1 = z3::select(c.constant("a",c.array_sort(c.int_sort(), c.int_sort())), 80);
     p = new_m.evalIntExpr(e1, true, true);
     assert(p.second);
+
+    // int64 boundaries: values that fit are exact, values that don't fail
+    res = new_m.addIntAssignment("max", INT64_MAX);
+    assert(res);
+    res = new_m.addIntAssignment("min", INT64_MIN);
+    assert(res);
+    z3::expr max = c.int_const("max");
+    z3::expr min = c.int_const("min");
+    p = new_m.evalIntExpr(max, true);
+    assert(p.second);
+    assert(p.first == INT64_MAX);
+    p = new_m.evalIntExpr(min, true);
+    assert(p.second);
+    assert(p.first == INT64_MIN);
+    p = new_m.evalIntExpr(c.int_val(INT64_MAX), true);
+    assert(p.second);
+    assert(p.first == INT64_MAX);
+    p = new_m.evalIntExpr(c.int_val(INT64_MIN), true);
+    assert(p.second);
+    assert(p.first == INT64_MIN);
+    p = new_m.evalIntExpr(c.int_val("4294967296"), true);
+    assert(p.second);
+    assert(p.first == 4294967296);
+    p = new_m.evalIntExpr(c.int_val("9223372036854775808"), true);
+    assert(!p.second);
+    p = new_m.evalIntExpr(max + 1, true);
+    assert(!p.second);
+    p = new_m.evalIntExpr(min - 1, true);
+    assert(!p.second);
+    p = new_m.evalIntExpr(-min, true);
+    assert(!p.second);
+    p = new_m.evalIntExpr(min * -1, true);
+    assert(!p.second);
+    p = new_m.evalIntExpr(max * 2, true);
+    assert(!p.second);
+    p = new_m.evalIntExpr(z3::operator/(min, -1), true);
+    assert(!p.second);
+    // a sum is exact even if a partial sum overflows
+    z3::expr_vector summands(c);
+    summands.push_back(max);
+    summands.push_back(max);
+    summands.push_back(-max);
+    p = new_m.evalIntExpr(z3::sum(summands), true);
+    assert(p.second);
+    assert(p.first == INT64_MAX);
+    p = new_m.evalIntExpr(min + max, true);
+    assert(p.second);
+    assert(p.first == -1);
+    p = new_m.evalIntExpr(-max, true);
+    assert(p.second);
+    assert(p.first == -INT64_MAX);
+    p = new_m.evalIntExpr(max - 1 + 1, true);
+    assert(p.second);
+    assert(p.first == INT64_MAX);
     std::cout << "TEST SUCCESSFUL\n";
 }
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include <cassert>
+#include <cstdint>
+#include <random>
+
+#include "octagon.h"
+
+static LinearConstraint constraint(
+    std::vector<std::pair<z3::expr, int128_t>> terms, int128_t bound,
+    bool is_eq = false) {
+  LinearConstraint result;
+  result.terms = std::move(terms);
+  result.bound = bound;
+  result.is_eq = is_eq;
+  return result;
+}
+
+static unsigned int index_of(const Octagon& octagon, const z3::expr& var) {
+  const auto& vars = octagon.get_vars();
+  for (unsigned int i = 0; i < vars.size(); i++) {
+    if (vars[i].id() == var.id()) return i;
+  }
+  assert(false);
+  return 0;
+}
+
+static void test_closure(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::expr z = c.int_const("z");
+  // x - y <= 2 and y - z <= 3 imply x - z <= 5, so x <= 5 with z = 0
+  Octagon octagon;
+  assert(octagon.add_constraint(constraint({{x, 1}, {y, -1}}, 2)));
+  assert(octagon.add_constraint(constraint({{y, 1}, {z, -1}}, 3)));
+  assert(octagon.add_constraint(constraint({{x, -1}}, 4)));
+  octagon.add_bounds(z, Interval(0, 0));
+  assert(octagon.num_relational() == 2);
+  assert(octagon.close());
+  const Interval x_bounds = octagon.get_bounds(index_of(octagon, x));
+  assert(x_bounds.get_low() == -4 && x_bounds.get_high() == 5);
+  const Interval y_bounds = octagon.get_bounds(index_of(octagon, y));
+  assert(y_bounds.get_low() == -6 && y_bounds.get_high() == 3);
+  const Interval z_bounds = octagon.get_bounds(index_of(octagon, z));
+  assert(z_bounds.get_low() == 0 && z_bounds.get_high() == 0);
+}
+
+static void test_tightening(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  // 2x <= -3 is x <= -2 over the integers, not x <= -1.5
+  Octagon octagon;
+  assert(octagon.add_constraint(constraint({{x, 1}, {y, 1}}, -3)));
+  assert(octagon.add_constraint(constraint({{x, 1}, {y, -1}}, 0)));
+  assert(octagon.close());
+  assert(octagon.get_bounds(index_of(octagon, x)).get_high() == -2);
+  assert(octagon.get_bounds(index_of(octagon, x)).is_low_minf());
+  // x + y = 3 and x = y only have the rational solution x = y = 1.5
+  Octagon no_integers;
+  assert(no_integers.add_constraint(constraint({{x, 1}, {y, 1}}, 3, true)));
+  assert(no_integers.add_constraint(constraint({{x, 1}, {y, -1}}, 0, true)));
+  assert(!no_integers.close());
+  Octagon empty;
+  empty.add_bounds(x, Interval(3, INT64_MAX));
+  assert(empty.add_constraint(constraint({{x, 1}}, 2)));
+  assert(!empty.close());
+  // coefficients of the same magnitude are divided out, rounding down
+  Octagon scaled;
+  assert(scaled.add_constraint(constraint({{x, 2}, {y, -2}}, 5)));
+  assert(scaled.add_constraint(constraint({{y, 3}}, 7)));
+  scaled.add_bounds(y, Interval(0, INT64_MAX));
+  assert(scaled.close());
+  assert(scaled.get_bounds(index_of(scaled, y)).get_high() == 2);
+  assert(scaled.get_bounds(index_of(scaled, x)).get_high() == 4);
+}
+
+static void test_not_octagonal(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::expr z = c.int_const("z");
+  Octagon octagon;
+  assert(!octagon.add_constraint(constraint({{x, 2}, {y, 3}}, 5)));
+  assert(!octagon.add_constraint(constraint({{x, 1}, {y, 1}, {z, 1}}, 1)));
+  assert(!octagon.add_constraint(constraint({{x, 2}}, 5, true)));
+  assert(!octagon.add_constraint(constraint({}, 5)));
+  assert(octagon.num_relational() == 0);
+}
+
+static void test_sample(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::expr z = c.int_const("z");
+  Octagon octagon;
+  assert(octagon.add_constraint(constraint({{x, 1}, {y, 1}}, 10)));
+  assert(octagon.add_constraint(constraint({{x, -1}, {y, 1}}, 2)));
+  assert(octagon.add_constraint(constraint({{y, 1}, {z, -1}}, 0)));
+  assert(octagon.add_constraint(constraint({{x, -1}, {z, -1}}, 0)));
+  octagon.add_bounds(x, Interval(-20, 20));
+  octagon.add_bounds(y, Interval(-5, INT64_MAX));
+  octagon.add_bounds(z, Interval(INT64_MIN, 8));
+  assert(octagon.close());
+  const z3::expr formula = octagon.to_expr(c);
+  z3::expr_vector vars(c);
+  for (const auto& var : octagon.get_vars()) vars.push_back(var);
+  std::mt19937 g(0);
+  std::vector<int64_t> point;
+  unsigned int drawn = 0;
+  for (unsigned int n = 0; n < 500; n++) {
+    if (!octagon.sample(g, point)) continue;
+    drawn++;
+    z3::expr_vector values(c);
+    for (unsigned int i = 0; i < point.size(); i++) {
+      assert(octagon.get_bounds(i).is_in_range(point[i]));
+      values.push_back(c.int_val(point[i]));
+    }
+    z3::expr at_point = formula;
+    assert(at_point.substitute(vars, values).simplify().is_true());
+  }
+  assert(drawn > 0);
+}
+
+int main() {
+  z3::context c;
+  test_closure(c);
+  test_tightening(c);
+  test_not_octagonal(c);
+  test_sample(c);
+  std::cout << "TEST SUCCESSFUL\n";
+  return 0;
+}
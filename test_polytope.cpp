@@ -0,0 +1,107 @@
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <set>
+
+#include "polytope.h"
+
+static LinearConstraint constraint(
+    std::vector<std::pair<z3::expr, int128_t>> terms, int128_t bound,
+    bool is_eq = false) {
+  LinearConstraint result;
+  result.terms = std::move(terms);
+  result.bound = bound;
+  result.is_eq = is_eq;
+  return result;
+}
+
+/* the point in the order of the variables of polytope */
+static std::vector<int64_t> point_of(
+    const Polytope& polytope,
+    const std::vector<std::pair<z3::expr, int64_t>>& values) {
+  std::vector<int64_t> point;
+  for (const auto& var : polytope.get_vars()) {
+    for (const auto& value : values) {
+      if (value.first.id() == var.id()) point.push_back(value.second);
+    }
+  }
+  assert(point.size() == polytope.get_vars().size());
+  return point;
+}
+
+static void test_walk(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::expr z = c.int_const("z");
+  z3::expr u = c.int_const("u");
+  z3::expr v = c.int_const("v");
+  Polytope polytope;
+  polytope.add_constraint(constraint({{x, 2}, {y, 3}, {z, -1}}, 12));
+  polytope.add_constraint(constraint({{x, -1}, {y, 5}}, 7));
+  polytope.add_constraint(constraint({{u, 1}, {v, 1}}, 4, true));
+  polytope.add_bounds(x, Interval(-2, INT64_MAX));
+  polytope.add_bounds(y, Interval(-1, INT64_MAX));
+  polytope.add_bounds(z, Interval(0, 3));
+  assert(polytope.num_rows() == 8);
+  const std::vector<int64_t> seed =
+      point_of(polytope, {{x, 0}, {y, 0}, {z, 0}, {u, 1}, {v, 3}});
+  assert(polytope.start(seed));
+
+  const z3::expr formula = polytope.to_expr(c);
+  z3::expr_vector vars(c);
+  for (const auto& var : polytope.get_vars()) vars.push_back(var);
+  std::vector<std::set<int64_t>> visited(vars.size());
+  std::mt19937 g(0);
+  std::vector<int64_t> point;
+  for (unsigned int n = 0; n < 1000; n++) {
+    assert(polytope.sample(g, point));
+    z3::expr_vector values(c);
+    for (unsigned int i = 0; i < point.size(); i++) {
+      values.push_back(c.int_val(point[i]));
+      visited[i].insert(point[i]);
+    }
+    z3::expr at_point = formula;
+    assert(at_point.substitute(vars, values).simplify().is_true());
+  }
+  for (unsigned int i = 0; i < vars.size(); i++) {
+    // the walk moves every variable but those of the equality
+    const bool fixed = vars[i].id() == u.id() || vars[i].id() == v.id();
+    assert(fixed ? visited[i].size() == 1 : visited[i].size() > 1);
+  }
+}
+
+static void test_start(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  Polytope polytope;
+  polytope.add_constraint(constraint({{x, 1}, {y, -1}}, 0));
+  polytope.add_constraint(constraint({{x, 1}, {y, 1}}, 5, true));
+  assert(!polytope.start(point_of(polytope, {{x, 3}, {y, 2}})));
+  assert(!polytope.start(point_of(polytope, {{x, 1}, {y, 3}})));
+  assert(polytope.start(point_of(polytope, {{x, 2}, {y, 3}})));
+}
+
+static void test_bounding_box(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::expr z = c.int_const("z");
+  Polytope polytope;
+  polytope.add_constraint(constraint({{x, 2}, {y, 3}}, 12));
+  polytope.add_constraint(constraint({{z, 1}, {x, -1}}, 0));
+  polytope.add_bounds(x, Interval(0, INT64_MAX));
+  polytope.add_bounds(y, Interval(0, INT64_MAX));
+  IntervalMap i_map;
+  polytope.bounding_box(i_map);
+  assert(i_map[x].get_low() == 0 && i_map[x].get_high() == 6);
+  assert(i_map[y].get_low() == 0 && i_map[y].get_high() == 4);
+  assert(i_map[z].is_low_minf() && i_map[z].get_high() == 6);
+}
+
+int main() {
+  z3::context c;
+  test_walk(c);
+  test_start(c);
+  test_bounding_box(c);
+  std::cout << "TEST SUCCESSFUL\n";
+  return 0;
+}
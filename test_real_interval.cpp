@@ -0,0 +1,128 @@
+#include <cassert>
+#include <cstdint>
+#include <random>
+
+#include "real_interval.h"
+
+/* true if computing the Rational throws RationalOverflow */
+template <typename Compute>
+static bool overflows(Compute compute) {
+  try {
+    compute();
+  } catch (const RationalOverflow&) {
+    return true;
+  }
+  return false;
+}
+
+static void test_rational() {
+  const Rational half(1, 2);
+  const Rational r(6, -4);
+  assert(r.get_num() == -3 && r.get_den() == 2);
+  assert(r.to_string() == "-3/2");
+  assert(r.floor() == -2 && r.ceil() == -1);
+  assert(r + half == Rational(-1));
+  assert(r * r == Rational(9, 4));
+  assert(r / half == Rational(-3));
+  assert(r < half && half > r && r <= r && !(half <= r));
+  assert(Rational(INT64_MIN).floor() == INT64_MIN);
+  assert(Rational(INT64_MAX, 2).ceil() == (int128_t)INT64_MAX / 2 + 1);
+  // results that don't fit in int64 throw
+  assert(overflows([] { return Rational((int128_t)INT64_MIN, -1); }));
+  assert(overflows([] { return -Rational(INT64_MIN); }));
+  assert(overflows([] { return Rational(INT64_MAX) + Rational(1); }));
+  assert(overflows([] { return Rational(INT64_MIN) - Rational(1); }));
+  assert(overflows([] { return Rational(INT64_MIN) * Rational(-1); }));
+  assert(overflows([] { return Rational(1, INT64_MAX) * Rational(1, 2); }));
+  assert(overflows([] { return Rational(INT64_MAX) / Rational(1, 2); }));
+  // unless they reduce to a fraction that does
+  assert(!overflows([] { return Rational(-(int128_t)INT64_MIN, 2); }));
+  assert(!overflows([] { return Rational(INT64_MAX) - Rational(1); }));
+  assert(Rational(INT64_MAX, INT64_MAX) == Rational(1));
+}
+
+static void test_numerals(z3::context& c) {
+  Rational value;
+  assert(numeral_to_rational(c.real_val("-1/3"), value));
+  assert(value == Rational(-1, 3));
+  assert(numeral_to_rational(c.int_val(INT64_MIN), value));
+  assert(value == Rational(INT64_MIN));
+  assert(!numeral_to_rational(c.int_val("9223372036854775808"), value));
+  assert(!numeral_to_rational(c.real_val("1/9223372036854775808"), value));
+  assert(!numeral_to_rational(c.int_const("x"), value));
+}
+
+static void test_bounds() {
+  RealInterval interval;
+  assert(interval.is_in_range(Rational(INT64_MIN)));
+  interval.set_lower_bound(Rational(1), false);
+  interval.set_upper_bound(Rational(2), false);
+  assert(interval.is_in_range(Rational(1)) && interval.is_in_range(2));
+  assert(interval.is_in_range(Rational(3, 2)));
+  assert(!interval.is_in_range(Rational(0)) && !interval.is_in_range(3));
+  // a strict bound excludes its value, and at the same value is tighter
+  interval.set_lower_bound(Rational(1), true);
+  assert(interval.is_low_strict() && !interval.is_in_range(Rational(1)));
+  interval.set_lower_bound(Rational(1), false);
+  assert(interval.is_low_strict());
+  interval.set_lower_bound(Rational(1, 2), false);
+  assert(interval.is_low_strict() && interval.get_low() == Rational(1));
+  interval.set_upper_bound(Rational(2), true);
+  assert(interval.is_high_strict() && !interval.is_in_range(Rational(2)));
+  assert(interval.is_in_range(Rational(3, 2)));
+  interval.set_upper_bound(Rational(3, 2), false);
+  assert(!interval.is_high_strict() && interval.is_in_range(Rational(3, 2)));
+
+  RealInterval point;
+  point.set_lower_bound(Rational(1, 3), false);
+  point.set_upper_bound(Rational(1, 3), false);
+  assert(!point.is_bottom() && point.is_in_range(Rational(1, 3)));
+  RealInterval half_open(point);
+  half_open.set_upper_bound(Rational(1, 3), true);
+  assert(half_open.is_bottom());
+  half_open = point;
+  half_open.set_lower_bound(Rational(1, 3), true);
+  assert(half_open.is_bottom());
+  RealInterval empty;
+  empty.set_lower_bound(Rational(2), false);
+  empty.set_upper_bound(Rational(1), false);
+  assert(empty.is_bottom());
+}
+
+static void test_random_in_range() {
+  std::mt19937 g(0);
+  Rational value;
+  RealInterval open;
+  open.set_lower_bound(Rational(0), true);
+  open.set_upper_bound(Rational(1), true);
+  for (unsigned int n = 0; n < 1000; n++) {
+    assert(open.random_in_range(g, value));
+    assert(open.is_in_range(value));
+  }
+  RealInterval point;
+  point.set_lower_bound(Rational(1, 3), false);
+  point.set_upper_bound(Rational(1, 3), false);
+  assert(point.random_in_range(g, value) && value == Rational(1, 3));
+  point.set_upper_bound(Rational(1, 3), true);
+  assert(!point.random_in_range(g, value));
+  // only INT64_MAX is above INT64_MAX - 1 and fits
+  RealInterval top;
+  top.set_lower_bound(Rational(INT64_MAX - 1), true);
+  for (unsigned int n = 0; n < 100; n++) {
+    assert(top.random_in_range(g, value));
+    assert(value == Rational(INT64_MAX));
+  }
+  RealInterval bottom;
+  bottom.set_upper_bound(Rational(INT64_MIN), false);
+  assert(bottom.random_in_range(g, value) && value == Rational(INT64_MIN));
+}
+
+int main() {
+  z3::context c;
+  test_rational();
+  test_numerals(c);
+  test_bounds();
+  test_random_in_range();
+  std::cout << "TEST SUCCESSFUL\n";
+  return 0;
+}
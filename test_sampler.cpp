@@ -0,0 +1,118 @@
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "sampler.h"
+
+static const char* const FORMULA =
+    "(declare-fun x () Int)\n"
+    "(declare-fun y () Int)\n"
+    "(declare-fun r () Real)\n"
+    "(declare-fun b () Bool)\n"
+    "(declare-fun f (Int) Int)\n"
+    "(declare-fun g (Int Int) Real)\n"
+    "(assert (> (f x) 10))\n"
+    "(assert (< (f y) (- 7)))\n"
+    "(assert (and (>= x 0) (<= x 100) (>= y 0) (<= y 100)))\n"
+    "(assert (<= (+ (f x) (f (+ y 1))) 50))\n"
+    "(assert (= (* 3 (g x y)) (- 1.0)))\n"
+    "(assert (> (g y x) (/ 1.0 3.0)))\n"
+    "(assert (= (* 2 r) 3.0))\n"
+    "(assert (= b (> (f 5) 2)))\n";
+
+static MeGA::SamplerConfig config() {
+  return MeGA::SamplerConfig(
+      false, false, false, false, false, false, 0, 0, 60, 60, 0, false, true,
+      0, 0, false, 0, MeGA::EPOCH_POLICY_LEGACY, false, false,
+      MeGA::STRENGTHEN_LEGACY, false, MeGA::SEED_MODE_MAXSMT, false, 0, 1,
+      MeGA::DISJUNCT_POLICY_UNIFORM, false, false);
+}
+
+/* a numeral of sort, from how samples write it */
+static z3::expr value_of(z3::context& c, const z3::sort& sort,
+                         const std::string& value) {
+  if (sort.is_bool()) return c.bool_val(value == "1");
+  if (sort.is_real()) return c.real_val(value.c_str());
+  return c.int_val(value.c_str());
+}
+
+/* the next field of text up to one of delimiters, from position */
+static std::string field(const std::string& text, size_t& position,
+                         const char* delimiters) {
+  const size_t end = text.find_first_of(delimiters, position);
+  assert(end != std::string::npos);
+  const std::string result = text.substr(position, end - position);
+  position = end + 1;
+  return result;
+}
+
+/*
+ * Rebuilds the model that sample writes, over the declarations of the
+ * model that it was written from.
+ */
+static z3::model read_sample(z3::context& c, const z3::model& m,
+                             const std::string& sample) {
+  z3::model result(c);
+  size_t position = 0;
+  while (position < sample.size()) {
+    const std::string name = field(sample, position, ":");
+    z3::func_decl decl(c);
+    for (unsigned int i = 0; i < m.size(); i++) {
+      if (m[i].name().str() == name) decl = m[i];
+    }
+    assert(static_cast<Z3_func_decl>(decl));
+    if (decl.arity() == 0) {
+      z3::expr value = value_of(c, decl.range(), field(sample, position, ";"));
+      result.add_const_interp(decl, value);
+      continue;
+    }
+    // f:(#entries;default;arg1:arg2:value,...);
+    assert(sample[position] == '(');
+    position++;
+    const unsigned long entries = std::stoul(field(sample, position, ";"));
+    z3::expr else_value =
+        value_of(c, decl.range(), field(sample, position, ";"));
+    z3::func_interp table = result.add_func_interp(decl, else_value);
+    for (unsigned long j = 0; j < entries; j++) {
+      z3::expr_vector args(c);
+      for (unsigned int k = 0; k < decl.arity(); k++) {
+        args.push_back(
+            value_of(c, decl.domain(k), field(sample, position, ":")));
+      }
+      z3::expr value =
+          value_of(c, decl.range(), field(sample, position, ","));
+      table.add_entry(args, value);
+    }
+    assert(sample.compare(position, 2, ");") == 0);
+    position += 2;
+  }
+  return result;
+}
+
+static void test_round_trip(z3::context& c) {
+  const std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / "megasampler_test_sampler";
+  std::filesystem::create_directories(dir);
+  const std::string input = (dir / "uf.smt2").string();
+  std::ofstream(input) << FORMULA;
+  Sampler sampler(&c, input, (dir / "out").string(), config());
+
+  const z3::expr formula = z3::mk_and(c.parse_file(input.c_str()));
+  z3::solver solver(c);
+  solver.add(formula);
+  assert(solver.check() == z3::sat);
+  const z3::model m = solver.get_model();
+  const std::string sample = sampler.model_to_string(m);
+  // the tables of f and g, and the values of r and b, read back as written
+  const z3::model read = read_sample(c, m, sample);
+  assert(read.eval(formula, true).is_true());
+  std::filesystem::remove_all(dir);
+}
+
+int main() {
+  z3::context c;
+  test_round_trip(c);
+  std::cout << "TEST SUCCESSFUL\n";
+  return 0;
+}
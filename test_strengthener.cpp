@@ -1,66 +1,439 @@
+#include <cassert>
+#include <cstdint>
+#include <random>
 
+#include "linear.h"
 #include "strengthener.h"
+#include "volume_strengthener.h"
+#include "z3_utils.h"
 
-int main() {
-  std::cout << "Hello strengthener!!\n";
-  z3::context c;
+/* a model of assertions, which must be satisfiable */
+static z3::model solve(z3::context& c, const z3::expr& assertions) {
+  z3::solver solver(c);
+  solver.add(assertions);
+  const auto res = solver.check();
+  assert(res == z3::sat);
+  return solver.get_model();
+}
+
+/*
+ * Checks that the box of the Int and bit-vector variables of literal contains
+ * the seed, and that literal holds on it: on the corners of the box clipped
+ * to a window around the seed, and on random points of that window.
+ * Variables without an interval are unbounded. Bit-vectors are checked on
+ * their unsigned values, which the box holds as bv_to_box makes them.
+ */
+static void check_box(z3::context& c, z3::model& m, const z3::expr& literal,
+                      const IntervalMap& i_map) {
+  constexpr int128_t WINDOW = 40;
+  constexpr unsigned int POINTS = 300;
+  z3::expr_vector literal_vars(c), vars(c);
+  collect_vars(literal, literal_vars);
+  std::vector<int128_t> lows, highs;
+  for (const auto& var : literal_vars) {
+    if (!var.is_int() && !var.is_bv()) continue;
+    const auto it = i_map.find(var);
+    const Interval interval = it == i_map.end() ? Interval() : it->second;
+    int128_t seed, low, high;
+    if (var.is_bv()) {
+      const unsigned int width = var.get_sort().bv_size();
+      seed = model_eval_to_uint64(m, var);
+      assert(interval.is_in_range(bv_to_box(seed, width)));
+      low = width == 64 ? bv_from_box(interval.get_low(), width)
+                        : std::max<int64_t>(interval.get_low(), 0);
+      high = width == 64 ? bv_from_box(interval.get_high(), width)
+                         : std::min<int64_t>(interval.get_high(),
+                                             (INT64_C(1) << width) - 1);
+    } else {
+      seed = model_eval_to_int64(m, var);
+      assert(interval.is_in_range(seed));
+      low = interval.get_low();
+      high = interval.get_high();
+    }
+    vars.push_back(var);
+    lows.push_back(std::max<int128_t>(low, seed - WINDOW));
+    highs.push_back(std::min<int128_t>(high, seed + WINDOW));
+  }
+  std::mt19937 g(0);
+  for (unsigned int n = 0; n < POINTS; n++) {
+    z3::expr_vector values(c);
+    for (unsigned int i = 0; i < vars.size(); i++) {
+      int128_t value;
+      switch (g() % 3) {
+        case 0: value = lows[i]; break;
+        case 1: value = highs[i]; break;
+        default: value = lows[i] + g() % (highs[i] - lows[i] + 1);
+      }
+      if (vars[i].is_bv()) {
+        const unsigned int width = vars[i].get_sort().bv_size();
+        values.push_back(c.bv_val((uint64_t)value, width));
+      } else {
+        values.push_back(c.int_val((int64_t)value));
+      }
+    }
+    z3::expr point = literal;
+    const bool holds =
+        model_eval_to_bool(m, point.substitute(vars, values).simplify());
+    assert(holds);
+  }
+}
+
+/* strengthens literal in the model of assertions and checks the box */
+static IntervalMap strengthen(z3::context& c, const z3::expr& assertions,
+                              const z3::expr& literal) {
+  z3::model m = solve(c, assertions && literal);
+  Strengthener s(c, m, false);
+  s.strengthen_literal(literal);
+  check_box(c, m, literal, s.i_map);
+  return s.i_map;
+}
+
+/* the rule of the NoRuleForStrengthening literal throws, "" if none */
+static std::string failing_rule(z3::context& c, const z3::expr& assertions,
+                                const z3::expr& literal) {
+  z3::model m = solve(c, assertions && literal);
+  Strengthener s(c, m, false);
+  try {
+    s.strengthen_literal(literal);
+  } catch (const Strengthener::NoRuleForStrengthening& e) {
+    return e.rule;
+  }
+  return "";
+}
+
+static void test_rules(z3::context& c) {
   z3::expr x = c.int_const("x");
   z3::expr y = c.int_const("y");
   z3::expr z = c.int_const("z");
   z3::expr b1 = c.bool_const("b1");
   z3::expr b2 = c.bool_const("b2");
-//  z3::expr f = b1 == b2; // NoRuleForStrengthening
-//  z3::expr f = x*y*z > 5; // should work
-//  z3::expr f = (!(x != 5)); // should work
-//  z3::expr f = (x*y)-z < 9; // should work
-//  z3::expr f = !((x*y)-z < 9); // should work
-//  z3::expr f = !((x*0)-z <= 9); // should work
-//  z3::expr f = b1; // should work
-//  z3::expr f = !b2; // should work
-//  z3::expr f = 3*(x+4) != 20; // should work
-//  z3::expr f = 3*(x+4) != x; // assertion failure - rhs is not a number
-//  z3::expr f = (x+y)*z > 5; // should work
-//  z3::expr f = (x+y)+4+z+(-2) > 5; // should work
-//  z3::expr f = (-x)-y+2*z > 50; // should work
-//  z3::expr f = 3*x*5*y > 50; // should work
-  z3::expr f = 3-(4*x+y*z) < 80; // should work
-  z3::solver solver(c);
-  solver.add(f);
-  auto res = solver.check();
-  assert(res == z3::sat);
-  z3::model m = solver.get_model();
-  Strengthener s(c,m);
-  s.print_interval_map();
-  s.strengthen_literal(f);
-  s.print_interval_map();
-//  Interval i1;
-//  std::cout << "infinite interval: " << i1 << "\n";
-//  i1.set_lower_bound(45);
-//  i1.set_upper_bound(45);
-//  std::cout << "singelton interval: " << i1 << "\n";
-//  i1.set_lower_bound(90);
-//  std::cout << "empty interval: " << i1 << "\n";
-//  i1.set_lower_bound(90);
-//  std::cout << "empty interval: " << i1 << "\n";
-//  i1.set_upper_bound(900);
-//  std::cout << "empty interval: " << i1 << "\n";
-//  i1.set_lower_bound(-90);
-//  std::cout << "empty interval: " << i1 << "\n";
-//  Interval i2;
-//  std::cout << "infinite interval: " << i2 << "\n";
-//  i2.set_lower_bound(-400);
-//  std::cout << "from -400: " << i2 << "\n";
-//  i2.set_upper_bound(0);
-//  std::cout << "to 0: " << i2 << "\n";
-//  i2.set_upper_bound(60);
-//  std::cout << "no change" << i2 << "\n";
-//  i2.set_upper_bound(-60);
-//  std::cout << "to -60: " << i2 << "\n";
-//  i2.set_lower_bound(-4000);
-//  std::cout << "no change: " << i2 << "\n";
-//  i2.set_lower_bound(-120);
-//  std::cout << "from -120: " << i2 << "\n";
-//  i2.set_upper_bound(-500);
-//  std::cout << "empty: " << i2 << "\n";
+  const z3::expr literals[] = {
+      x * y * z > 5,        (!(x != 5)),          (x * y) - z < 9,
+      !((x * y) - z < 9),   !((x * 0) - z <= 9),  3 * (x + 4) != 20,
+      (x + y) * z > 5,      (x + y) + 4 + z + (-2) > 5,
+      (-x) - y + 2 * z > 50, 3 * x * 5 * y > 50,  3 - (4 * x + y * z) < 80,
+  };
+  for (const auto& literal : literals) strengthen(c, c.bool_val(true), literal);
+  assert(failing_rule(c, c.bool_val(true), b1 == b2) == "= on Bool");
+}
+
+static void test_int128_helpers() {
+  const int128_t min = INT64_MIN, max = INT64_MAX;
+  assert(floor_div(7, 2) == 3);
+  assert(floor_div(-7, 2) == -4);
+  assert(floor_div(-8, 2) == -4);
+  assert(floor_div(min, 1) == min);
+  assert(floor_div(min, max) == -2);
+  assert(floor_div(max, max) == 1);
+  assert(floor_div(min - 1, 2) == -(max + 1) / 2 - 1);
+  assert(clamp_to_int64(max + 1) == max);
+  assert(clamp_to_int64(min - 1) == min);
+  assert(clamp_to_int64(max) == max);
+  assert(clamp_to_int64(min) == min);
+  assert(clamp_to_int64(-5) == -5);
+  assert(int128_to_string(0) == "0");
+  assert(int128_to_string(max) == "9223372036854775807");
+  assert(int128_to_string(min) == "-9223372036854775808");
+  assert(int128_to_string(min - 1) == "-9223372036854775809");
+  assert(int128_to_string((int128_t)1 << 64) == "18446744073709551616");
+  const int128_t int128_min = (int128_t)((uint128_t)1 << 127);
+  assert(int128_to_string(int128_min) ==
+         "-170141183460469231731687303715884105728");
+}
+
+static void test_int64_boundaries(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  const z3::expr max = c.int_val(INT64_MAX);
+  const z3::expr min = c.int_val(INT64_MIN);
+  // a bound past the limit on the side op allows is no bound
+  IntervalMap i_map = strengthen(c, x == 0, x - 10 <= max);
+  assert(i_map[x].is_high_inf());
+  i_map = strengthen(c, x == 0, x + 10 >= min);
+  assert(i_map[x].is_low_minf());
+  // bounds right at the limit are kept
+  i_map = strengthen(c, x == 0, x + 1 <= max);
+  assert(i_map[x].get_high() == INT64_MAX - 1);
+  i_map = strengthen(c, x == 0, x - 1 >= min);
+  assert(i_map[x].get_low() == INT64_MIN + 1);
+  i_map = strengthen(c, x == 0, -x <= max);
+  assert(i_map[x].get_low() == -INT64_MAX);
+  // seeds at the limits
+  i_map = strengthen(c, x == max, x >= 5);
+  assert(i_map[x].get_low() == 5 && i_map[x].is_high_inf());
+  i_map = strengthen(c, x == min, x <= -5);
+  assert(i_map[x].is_low_minf() && i_map[x].get_high() == -5);
+  // the slack of 1 takes x past INT64_MAX
+  i_map = strengthen(c, x == max && y == -1, x + y <= max);
+  assert(i_map[x].is_high_inf() && i_map[y].get_high() == -1);
+  // seed values that don't fit in int64 have no rule
+  const z3::expr two_to_63 = c.int_val("9223372036854775808");
+  assert(failing_rule(c, x == two_to_63, x >= 0) == "int64 overflow");
+  assert(failing_rule(c, x == min - 1, x <= 0) == "int64 overflow");
+  assert(failing_rule(c, x == max && y == -1, x - y >= 0) ==
+         "int64 overflow");
+  const z3::expr two_to_40 = c.int_val("1099511627776");
+  assert(failing_rule(c, x == two_to_40 && y == two_to_40, x * y >= 0) ==
+         "int64 overflow");
+  // nor do values that don't even fit in int128
+  const z3::expr two_to_130 =
+      c.int_val("1361129467683753853853498429727072845824");
+  assert(failing_rule(c, x == two_to_130, x >= 0) == "int128 overflow");
+  // a pinned value that doesn't fit in int64 leaves nothing to sample
+  z3::model m = solve(c, x == two_to_63);
+  Strengthener s(c, m, false);
+  s.pin_literal(x >= 0);
+  assert(s.i_map[x].is_bottom());
+}
+
+static void test_div_mod(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  const z3::expr minus_three = c.int_val(-3);
+  const z3::expr max = c.int_val(INT64_MAX);
+  const z3::expr min = c.int_val(INT64_MIN);
+  // div(a, -3) = -div(a, 3)
+  IntervalMap i_map = strengthen(c, x == -7, x / minus_three >= 2);
+  assert(i_map[x].is_low_minf() && i_map[x].get_high() == -4);
+  i_map = strengthen(c, x == 0, x / minus_three <= 2);
+  assert(i_map[x].get_low() == -6 && i_map[x].is_high_inf());
+  i_map = strengthen(c, x == -5, x / minus_three == 2);
+  assert(i_map[x].get_low() == -6 && i_map[x].get_high() == -4);
+  // a negative divisor moves only where the quotient keeps its bound
+  i_map = strengthen(c, x == -10 && y == -3, x / y >= 2);
+  assert(i_map[y].get_high() <= -1);
+  i_map = strengthen(c, x == 10 && y == -3, x / y <= -2);
+  assert(i_map[x].get_low() >= 0 && i_map[y].get_high() <= -1);
+  i_map = strengthen(c, x == 10 && y == -3, x / y == -3);
+  assert(i_map[y].get_low() == -3 && i_map[y].get_high() == -3);
+  // division by zero is uninterpreted, so nothing moves
+  i_map = strengthen(c, x == 7 && y == 0, x / y == 5);
+  assert(i_map[x].get_low() == 7 && i_map[x].get_high() == 7);
+  assert(i_map[y].get_low() == 0 && i_map[y].get_high() == 0);
+  i_map = strengthen(c, x == 7 && y == 0, x / y >= 5);
+  assert(i_map[x].get_low() == 7 && i_map[x].get_high() == 7);
+  i_map = strengthen(c, x == 7 && y == 0, z3::mod(x, y) <= -2);
+  assert(i_map[x].get_low() == 7 && i_map[x].get_high() == 7);
+  assert(i_map[y].get_low() == 0 && i_map[y].get_high() == 0);
+  i_map = strengthen(c, x == 7 && y == 0, z3::rem(x, y) == 3);
+  assert(i_map[y].get_low() == 0 && i_map[y].get_high() == 0);
+  // rem(a, -3) = -mod(a, 3)
+  i_map = strengthen(c, x == 5, z3::rem(x, minus_three) <= -2);
+  assert(i_map[x].get_low() == 5 && i_map[x].get_high() == 5);
+  i_map = strengthen(c, x == 3, z3::rem(x, minus_three) >= -1);
+  assert(i_map[x].get_low() == 3 && i_map[x].get_high() == 4);
+  i_map = strengthen(c, x == 4 && y == -3, z3::rem(x, y) == -1);
+  assert(i_map[x].get_low() == 4 && i_map[x].get_high() == 4);
+  assert(i_map[y].get_low() == -3 && i_map[y].get_high() == -3);
+  assert(failing_rule(c, x == 5, z3::rem(x, minus_three) >= min) ==
+         "rem overflow");
+  // the divisor INT64_MIN has no positive counterpart
+  assert(failing_rule(c, x == 5 && y == min, z3::mod(x, y) >= 1) ==
+         "mod overflow");
+  assert(failing_rule(c, x == 5, z3::mod(x, min) >= 1) == "mod overflow");
+  // the block of INT64_MIN, mod(INT64_MIN, 3) = 1, starts below it
+  i_map = strengthen(c, x == min, z3::mod(x, 3) == 1);
+  assert(i_map[x].get_low() == INT64_MIN && i_map[x].get_high() == INT64_MIN);
+  i_map = strengthen(c, x == min, z3::mod(x, 3) >= 1);
+  assert(i_map[x].get_low() == INT64_MIN &&
+         i_map[x].get_high() == INT64_MIN + 1);
+  // mod(INT64_MAX, 3) = 1, and the block ends at it
+  i_map = strengthen(c, x == max, z3::mod(x, 3) <= 1);
+  assert(i_map[x].get_low() == INT64_MAX - 1 &&
+         i_map[x].get_high() == INT64_MAX);
+  i_map = strengthen(c, x == max, x / 3 >= 0);
+  assert(i_map[x].get_low() == 0 && i_map[x].is_high_inf());
+}
+
+/* the unsigned bounds of the box of a bit-vector variable */
+static std::pair<uint64_t, uint64_t> bv_bounds(IntervalMap& i_map,
+                                               const z3::expr& var) {
+  const unsigned int width = var.get_sort().bv_size();
+  const Interval& interval = i_map[var];
+  if (width == 64) {
+    return {bv_from_box(interval.get_low(), width),
+            bv_from_box(interval.get_high(), width)};
+  }
+  return {std::max<int64_t>(interval.get_low(), 0),
+          std::min<int64_t>(interval.get_high(), (INT64_C(1) << width) - 1)};
+}
+
+static void test_bv(z3::context& c) {
+  z3::expr x = c.bv_const("x", 8);
+  z3::expr y = c.bv_const("y", 8);
+  z3::expr w = c.bv_const("w", 64);
+  const auto bv = [&c](uint64_t value, unsigned int width = 8) {
+    return c.bv_val(value, width);
+  };
+  using bounds = std::pair<uint64_t, uint64_t>;
+  // sums wrap around at 0 and 2^w - 1, but the box keeps the lap of the seed
+  IntervalMap i_map = strengthen(c, x == 0xff, x + 1 == 0);
+  assert(bv_bounds(i_map, x) == bounds(0xff, 0xff));
+  i_map = strengthen(c, x == 0, z3::uge(x - 1, bv(0xf0)));
+  assert(bv_bounds(i_map, x) == bounds(0, 0));
+  i_map = strengthen(c, x == 0xf8, z3::ult(x + 8, bv(4)));
+  assert(bv_bounds(i_map, x) == bounds(0xf8, 0xfb));
+  strengthen(c, x == 0xff && y == 1, z3::ule(x + y, bv(3)));
+  i_map = strengthen(c, x == 0 && y == 0, z3::ule(x + y, bv(10)));
+  assert(bv_bounds(i_map, x) == bounds(0, 5));
+  strengthen(c, x == 0 && y == 0xff, z3::uge(x - y, bv(1)));
+  strengthen(c, x == 0x80, z3::ugt(-x, bv(0x7f)));
+  i_map = strengthen(c, w == c.bv_val(UINT64_MAX, 64),
+                     z3::ule(w + 1, bv(10, 64)));
+  assert(bv_bounds(i_map, w) == bounds(UINT64_MAX, UINT64_MAX));
+  i_map = strengthen(c, w == 0, z3::ule(w, bv(10, 64)));
+  assert(bv_bounds(i_map, w) == bounds(0, 10));
+  // the signed order at its minimum, 0x80, and where it wraps to the maximum
+  i_map = strengthen(c, x == 0x80, x < bv(0x90));
+  assert(bv_bounds(i_map, x) == bounds(0x80, 0x8f));
+  i_map = strengthen(c, x == 0x7f && y == 0x80, y < x);
+  assert(bv_bounds(i_map, x).second == 0x7f);
+  assert(bv_bounds(i_map, y).first == 0x80);
+  strengthen(c, x == 0x7f, x + 1 < bv(0));
+  strengthen(c, w == c.bv_val(INT64_MIN, 64), w <= bv(0, 64));
+  // multiplication by an even constant can't be inverted, the box stays on
+  // the lap of the seed
+  i_map = strengthen(c, x == 0x88, z3::ule(x * 2, bv(0x10)));
+  assert(bv_bounds(i_map, x) == bounds(0x80, 0x88));
+  strengthen(c, x == 0x82, x * 6 == bv(0x0c));
+  strengthen(c, x == 0xff, z3::uge(x * 4, bv(0xf0)));
+  strengthen(c, x == 0, z3::ule(x * 0x80, bv(0x7f)));
+  assert(failing_rule(c, x == 1 && y == 1, z3::ule(x * y, bv(2))) ==
+         "bvmul without constants");
+  // division and remainder, by zero too
+  i_map = strengthen(c, x == 0xff, z3::ule(z3::udiv(x, bv(3)), bv(0x55)));
+  assert(bv_bounds(i_map, x) == bounds(0, 0xff));
+  strengthen(c, x == 0xff && y == 0x10, z3::uge(z3::udiv(x, y), bv(0xf)));
+  i_map = strengthen(c, x == 0x20, z3::ule(z3::udiv(x, bv(0x10)), bv(0xe)));
+  assert(bv_bounds(i_map, x) == bounds(0, 0xef));
+  i_map = strengthen(c, x == 9 && y == 0, z3::udiv(x, y) == bv(0xff));
+  assert(bv_bounds(i_map, x) == bounds(9, 9));
+  assert(bv_bounds(i_map, y) == bounds(0, 0));
+  // urem(0xff, 7) = 3, and the block of the seed, 0xfc + [0, 6], ends past
+  // 0xff
+  i_map = strengthen(c, x == 0xff, z3::uge(z3::urem(x, bv(7)), bv(3)));
+  assert(bv_bounds(i_map, x) == bounds(0xff, 0xff));
+  i_map = strengthen(c, x == 0xfe, z3::ule(z3::urem(x, bv(7)), bv(3)));
+  assert(bv_bounds(i_map, x) == bounds(0xfc, 0xff));
+  i_map = strengthen(c, x == 0x13, z3::uge(z3::urem(x, bv(7)), bv(3)));
+  assert(bv_bounds(i_map, x) == bounds(0x11, 0x14));
+  strengthen(c, x == 0 && y == 0xff, z3::ult(z3::urem(x, y), bv(1)));
+  i_map = strengthen(c, x == 5 && y == 0, z3::urem(x, y) == bv(5));
+  assert(bv_bounds(i_map, x) == bounds(5, 5));
+  // concat pins its high part, extract its higher bits
+  i_map = strengthen(c, x == 0x12 && y == 0xff,
+                     z3::ule(z3::concat(x, y), bv(0x12ff, 16)));
+  assert(bv_bounds(i_map, x) == bounds(0x12, 0x12));
+  assert(bv_bounds(i_map, y) == bounds(0, 0xff));
+  i_map = strengthen(c, x == 0x12 && y == 0x90,
+                     z3::uge(z3::concat(x, y), bv(0x1280, 16)));
+  assert(bv_bounds(i_map, y) == bounds(0x80, 0xff));
+  i_map = strengthen(c, x == 0xcf, x.extract(5, 2) == bv(3, 4));
+  assert(bv_bounds(i_map, x) == bounds(0xcc, 0xcf));
+  i_map = strengthen(c, x == 0xff, x.extract(7, 4) == bv(0xf, 4));
+  assert(bv_bounds(i_map, x) == bounds(0xf0, 0xff));
+  i_map = strengthen(c, x == 0, z3::ult(x.extract(3, 0), bv(2, 4)));
+  assert(bv_bounds(i_map, x) == bounds(0, 1));
+  i_map = strengthen(c, w == c.bv_val(UINT64_MAX, 64),
+                     w.extract(63, 56) == bv(0xff));
+  assert(bv_bounds(i_map, w) ==
+         bounds(UINT64_MAX << 56, UINT64_MAX));
+  // sign_extend stays in the sign half of the seed
+  i_map = strengthen(c, x == 0x80, z3::sext(x, 8) < bv(0, 16));
+  assert(bv_bounds(i_map, x) == bounds(0x80, 0xff));
+  i_map = strengthen(c, x == 0x7f, z3::sext(x, 8) >= bv(0, 16));
+  assert(bv_bounds(i_map, x) == bounds(0, 0x7f));
+  i_map = strengthen(c, x == 0x80, z3::ule(z3::sext(x, 8), bv(0xff80, 16)));
+  assert(bv_bounds(i_map, x) == bounds(0x80, 0x80));
+  strengthen(c, x == 0, z3::uge(z3::zext(x, 56) + w, bv(1, 64)));
+}
+
+/* the number of points of the box of vars, which must all be bounded */
+static int128_t box_size(IntervalMap& i_map, const z3::expr_vector& vars) {
+  int128_t size = 1;
+  for (const auto& var : vars) {
+    const Interval& interval = i_map[var];
+    assert(!interval.is_low_minf() && !interval.is_high_inf());
+    size *= (int128_t)interval.get_high() - interval.get_low() + 1;
+  }
+  return size;
+}
+
+static void test_volume(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  z3::expr z = c.int_const("z");
+  z3::expr_vector implicant(c);
+  implicant.push_back(x >= 0);
+  implicant.push_back(y >= 0);
+  implicant.push_back(x + 2 * y <= 20);
+  implicant.push_back(3 * x + y <= 24);
+  implicant.push_back(y - x <= 5);
+  implicant.push_back(y * z <= 12);
+  z3::model m = solve(c, z3::mk_and(implicant) && x == 1 && y == 1 && z == 2);
+  VolumeStrengthener volume(c, m, false);
+  Strengthener legacy(c, m, false);
+  for (const auto& literal : implicant) {
+    volume.strengthen_literal(literal);
+    legacy.strengthen_literal(literal);
+  }
+  volume.compute_box();
+  // the box holds on every corner, and the non-linear literal is bounded by
+  // the legacy rules
+  check_box(c, m, z3::mk_and(implicant), volume.i_map);
+  assert(volume.i_map[z].get_low() == legacy.i_map[z].get_low() &&
+         volume.i_map[z].get_high() == legacy.i_map[z].get_high());
+  z3::expr_vector vars(c);
+  vars.push_back(x);
+  vars.push_back(y);
+  vars.push_back(z);
+  assert(box_size(volume.i_map, vars) >= box_size(legacy.i_map, vars));
+
+  // an equality pins its variables, whatever the slack of the others
+  z3::model pinned_model = solve(c, x == 3 && y == 4);
+  VolumeStrengthener pinned(c, pinned_model, false);
+  pinned.strengthen_literal(x + y == 7);
+  pinned.strengthen_literal(x - y <= 10);
+  pinned.compute_box();
+  assert(pinned.i_map[x].get_low() == 3 && pinned.i_map[x].get_high() == 3);
+  assert(pinned.i_map[y].get_low() == 4 && pinned.i_map[y].get_high() == 4);
+}
+
+static void test_ite(z3::context& c) {
+  z3::expr x = c.int_const("x");
+  z3::expr y = c.int_const("y");
+  // nested: both guards hold on the box, and the inner ite is removed when
+  // the branch of the outer one is strengthened
+  const z3::expr nested =
+      z3::ite(x > 5, z3::ite(y < 3, x + y, x - y), 2 * y) <= 20;
+  z3::model m = solve(c, nested && x == 7 && y == 1);
+  Strengthener s(c, m, false);
+  s.strengthen_literal(nested);
+  check_box(c, m, nested, s.i_map);
+  assert(s.ite_rewrites == 2);
+  assert(s.i_map[x].get_low() == 6 && s.i_map[y].get_high() == 2);
+
+  // under a negation: the negated condition !(x < 0 || y > 10) bounds both
+  const z3::expr negated = !(z3::ite(x < 0 || y > 10, y, x) > 4);
+  IntervalMap i_map = strengthen(c, x == 3 && y == 2, negated);
+  assert(i_map[x].get_low() == 0 && i_map[x].get_high() == 4);
+  assert(i_map[y].get_high() == 10);
+  // !(x > 0 && y > 0) only needs the conjunct that is false
+  const z3::expr conjunction = z3::ite(x > 0 && y > 0, x, x + 1) >= 1;
+  i_map = strengthen(c, x == 2 && y == -1, conjunction);
+  assert(i_map[x].get_low() == 0 && i_map[x].is_high_inf());
+  assert(i_map[y].is_low_minf() && i_map[y].get_high() == 0);
+}
+
+int main() {
+  z3::context c;
+  test_rules(c);
+  test_int128_helpers();
+  test_int64_boundaries(c);
+  test_div_mod(c);
+  test_bv(c);
+  test_volume(c);
+  test_ite(c);
+  std::cout << "TEST SUCCESSFUL\n";
   return 0;
 }
@@ -0,0 +1,170 @@
+#include "volume_strengthener.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <numeric>
+
+#include "linear.h"
+#include "z3_utils.h"
+
+static constexpr unsigned int MAX_ALLOCATION_ROUNDS = 16;
+
+void VolumeStrengthener::strengthen_literal(const z3::expr& literal) {
+  if (debug)
+    std::cout << "volume strengthening literal: " << literal.to_string()
+              << "\n";
+  assert(model_eval_to_bool(model, literal));
+  if (!add_linear_literal(literal)) legacy.strengthen_literal(literal);
+}
+
+/*
+ * Records a linear literal with the slack left by the seed. Returns false if
+ * the literal isn't linear, so it goes to the legacy rules.
+ */
+bool VolumeStrengthener::add_linear_literal(const z3::expr& literal) {
+  LinearConstraint constraint;
+  if (!to_linear_constraint(literal, model, constraint)) return false;
+
+  LinearLiteral lit;
+  lit.is_eq = constraint.is_eq;
+  int128_t seed_sum = 0;
+  std::vector<int64_t> values;
+  for (const auto& term : constraint.terms) {
+    const int64_t value = model_eval_to_int64(model, term.first);
+    // saturated values can't be represented in the box
+    if (value == INT64_MIN || value == INT64_MAX) return false;
+    int128_t product;
+    if (__builtin_mul_overflow(term.second, (int128_t)value, &product) ||
+        __builtin_add_overflow(seed_sum, product, &seed_sum))
+      return false;
+    values.push_back(value);
+  }
+  lit.slack = constraint.bound - seed_sum;
+  if (lit.is_eq ? lit.slack != 0 : lit.slack < 0) return false;
+  if (constraint.terms.empty()) return true;  // constant, nothing to bound
+
+  for (unsigned int i = 0; i < constraint.terms.size(); i++) {
+    const z3::expr& var = constraint.terms[i].first;
+    const auto res = var_index.emplace(var, vars.size());
+    if (res.second) {
+      vars.push_back(var);
+      var_values.push_back(values[i]);
+    }
+    lit.terms.emplace_back(res.first->second, constraint.terms[i].second);
+  }
+  literals.push_back(std::move(lit));
+  return true;
+}
+
+/*
+ * Every variable x_i gets a box [v_i - down_i, v_i + up_i] around its seed
+ * value v_i. A literal sum(c_i * x_i) <= k holds on the whole box iff the
+ * widths it charges, c_i * up_i for c_i > 0 and -c_i * down_i for c_i < 0,
+ * sum up to at most its slack. The slack of each literal is split evenly
+ * between the widths it charges, repeatedly, so slack that one width can't
+ * use (being bounded by another literal) goes to the others; what remains is
+ * given greedily to the narrowest sides. Equalities pin their variables.
+ */
+void VolumeStrengthener::compute_box() {
+  const unsigned int num_sides = 2 * vars.size();  // 2*i: down, 2*i+1: up
+  std::vector<std::vector<std::pair<unsigned int, int128_t>>> side_literals(
+      num_sides);
+  std::vector<bool> pinned(vars.size(), false);
+  std::vector<int128_t> residual(literals.size());
+  for (unsigned int k = 0; k < literals.size(); k++) {
+    const LinearLiteral& lit = literals[k];
+    residual[k] = lit.slack;
+    for (const auto& term : lit.terms) {
+      if (lit.is_eq) {
+        pinned[term.first] = true;
+      } else if (term.second > 0) {
+        side_literals[2 * term.first + 1].emplace_back(k, term.second);
+      } else {
+        side_literals[2 * term.first].emplace_back(k, -term.second);
+      }
+    }
+  }
+
+  // the box must not reach the INT64_MIN/INT64_MAX sentinels
+  std::vector<int128_t> cap(num_sides), width(num_sides, 0);
+  std::vector<bool> active(num_sides);
+  for (unsigned int j = 0; j < num_sides; j++) {
+    const int128_t value = var_values[j / 2];
+    cap[j] = (j % 2) ? (int128_t)INT64_MAX - 1 - value
+                     : value - ((int128_t)INT64_MIN + 1);
+    active[j] = !pinned[j / 2] && !side_literals[j].empty() && cap[j] > 0;
+  }
+  auto can_grow = [&](unsigned int j) {
+    if (width[j] >= cap[j]) return false;
+    for (const auto& kw : side_literals[j]) {
+      if (residual[kw.first] < kw.second) return false;
+    }
+    return true;
+  };
+  auto max_growth = [&](unsigned int j, const std::vector<int128_t>& shares) {
+    int128_t growth = cap[j] - width[j];
+    for (const auto& kw : side_literals[j]) {
+      growth = std::min(growth, residual[kw.first] / shares[kw.first] /
+                                    kw.second);
+    }
+    return growth;
+  };
+  auto grow = [&](unsigned int j, int128_t growth) {
+    width[j] += growth;
+    for (const auto& kw : side_literals[j]) {
+      residual[kw.first] -= growth * kw.second;
+      assert(residual[kw.first] >= 0);
+    }
+  };
+
+  std::vector<int128_t> shares(literals.size());
+  std::vector<int128_t> growths(num_sides);
+  for (unsigned int round = 0; round < MAX_ALLOCATION_ROUNDS; round++) {
+    std::fill(shares.begin(), shares.end(), 0);
+    for (unsigned int j = 0; j < num_sides; j++) {
+      if (!active[j]) continue;
+      for (const auto& kw : side_literals[j]) shares[kw.first]++;
+    }
+    bool grew = false;
+    for (unsigned int j = 0; j < num_sides; j++) {
+      growths[j] = active[j] ? max_growth(j, shares) : 0;
+    }
+    // each literal gives every side at most 1/shares of its residual, so
+    // applying all the growths together keeps the literal satisfied
+    for (unsigned int j = 0; j < num_sides; j++) {
+      if (growths[j] > 0) {
+        grow(j, growths[j]);
+        grew = true;
+      }
+    }
+    for (unsigned int j = 0; j < num_sides; j++) {
+      if (active[j]) active[j] = can_grow(j);
+    }
+    if (!grew) break;
+  }
+
+  std::vector<unsigned int> order(num_sides);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+    return width[a & ~1u] + width[a | 1u] < width[b & ~1u] + width[b | 1u];
+  });
+  const std::vector<int128_t> single(literals.size(), 1);
+  for (const unsigned int j : order) {
+    if (active[j] && can_grow(j)) grow(j, max_growth(j, single));
+  }
+
+  for (unsigned int i = 0; i < vars.size(); i++) {
+    Interval& interval = i_map[vars[i]];
+    const int64_t value = var_values[i];
+    if (pinned[i]) {
+      interval.set_lower_bound(value);
+      interval.set_upper_bound(value);
+      continue;
+    }
+    if (!side_literals[2 * i].empty())
+      interval.set_lower_bound((int64_t)(value - width[2 * i]));
+    if (!side_literals[2 * i + 1].empty())
+      interval.set_upper_bound((int64_t)(value + width[2 * i + 1]));
+  }
+}
@@ -0,0 +1,61 @@
+#ifndef VOLUME_STRENGTHENER_H
+#define VOLUME_STRENGTHENER_H
+
+#include <utility>
+#include <vector>
+
+#include "interval.h"
+#include "intervalmap.h"
+#include "linear.h"
+#include "strengthener.h"
+#include "z3++.h"
+
+/*
+ * Strengthens all the linear literals of an implicant together: each literal
+ * is normalized to sum(c_i * x_i) <= k (or = k), and the slack that the seed
+ * leaves in every literal is allocated to the box sides so as to maximize the
+ * log volume of the box, instead of splitting it evenly per literal.
+ * Literals that aren't linear over integer variables are handed to the
+ * legacy Strengthener and the two boxes are intersected.
+ */
+class VolumeStrengthener {
+  z3::context& c;
+  z3::model& model;
+  bool debug;
+  Strengthener legacy;
+
+  struct LinearLiteral {
+    std::vector<std::pair<unsigned int, int128_t>> terms;  // (var, coeff)
+    int128_t slack;  // k - sum(c_i * seed_i), >= 0
+    bool is_eq;
+  };
+  std::vector<z3::expr> vars;
+  std::unordered_map<z3::expr, unsigned int> var_index;
+  std::vector<int64_t> var_values;
+  std::vector<LinearLiteral> literals;
+
+ public:
+  IntervalMap& i_map;
+  RealIntervalMap& r_map;
+
+  VolumeStrengthener(z3::context& con, z3::model& mod, bool deb)
+      : c(con),
+        model(mod),
+        debug(deb),
+        legacy(con, mod, deb),
+        i_map(legacy.i_map),
+        r_map(legacy.r_map){};
+  void strengthen_literal(const z3::expr& literal);
+  /* allocates the slack of the linear literals, must be called last */
+  void compute_box();
+  void print_interval_map() { legacy.print_interval_map(); }
+  void pin_literal(const z3::expr& literal) { legacy.pin_literal(literal); }
+  [[nodiscard]] unsigned long get_ite_rewrites() const {
+    return legacy.ite_rewrites;
+  }
+
+ private:
+  bool add_linear_literal(const z3::expr& literal);
+};
+
+#endif  // VOLUME_STRENGTHENER_H
@@ -0,0 +1,70 @@
+#include "watchdog.h"
+
+#include <algorithm>
+
+std::atomic<bool> Watchdog::signaled{false};
+
+Watchdog::Watchdog(z3::context& c) : c(c), thread(&Watchdog::run, this) {}
+
+void Watchdog::arm(time_point _deadline) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    armed = true;
+    interrupted = false;
+    deadline = _deadline;
+  }
+  wakeup.notify_one();
+}
+
+void Watchdog::cancel() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    cancelled = true;
+  }
+  wakeup.notify_one();
+}
+
+void Watchdog::resume() {
+  std::lock_guard<std::mutex> lock(mutex);
+  cancelled = false;
+}
+
+bool Watchdog::disarm() {
+  bool was_interrupted;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    armed = false;
+    was_interrupted = interrupted;
+    interrupted = false;
+  }
+  if (was_interrupted) {
+    interrupts++;
+    z3::solver(c, z3::solver::simple()).check();  // clears a stray interrupt
+  }
+  return was_interrupted;
+}
+
+void Watchdog::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wakeup.notify_one();
+  if (thread.joinable()) thread.join();
+}
+
+void Watchdog::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!stopping) {
+    const time_point now = std::chrono::steady_clock::now();
+    if (armed && (signaled || cancelled || now >= deadline)) {
+      c.interrupt();
+      interrupted = true;
+      wakeup.wait_for(lock, INTERRUPT_PERIOD);
+    } else if (armed) {
+      wakeup.wait_until(lock, std::min(deadline, now + SIGNAL_PERIOD));
+    } else {
+      wakeup.wait(lock);  // a signal only matters once a check is armed
+    }
+  }
+}
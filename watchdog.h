@@ -0,0 +1,81 @@
+#ifndef MEGASAMPLER_WATCHDOG_H
+#define MEGASAMPLER_WATCHDOG_H
+
+#include <z3++.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/*
+ * A thread that interrupts the z3 context while a check runs past its
+ * deadline, or once a signal came (SIGHUP, the external timeout). z3 only
+ * looks at its timeout parameter now and then, and MAX-SMT may overrun it
+ * by minutes; an interrupt stops the check right away, so the sampler gets
+ * to its time checks and writes its statistics.
+ *
+ * z3 ignores an interrupt that comes before the check starts, so the
+ * interrupt is repeated until the check is disarmed. An interrupt that lands
+ * outside of a check would cancel the next z3 call, so disarm() clears it.
+ * Other threads that want a check to stop call cancel() rather than
+ * interrupting the context themselves: between checks z3 would throw.
+ */
+class Watchdog {
+ public:
+  typedef std::chrono::steady_clock::time_point time_point;
+
+  explicit Watchdog(z3::context& c);
+  ~Watchdog() { stop(); }
+  Watchdog(const Watchdog&) = delete;
+  Watchdog& operator=(const Watchdog&) = delete;
+
+  /* async-signal-safe: every check from now on is interrupted at once */
+  static void notify_signal() { signaled = true; }
+  /* interrupts the check in progress, if any, and every one until resume() */
+  void cancel();
+  void resume();
+  /* interrupts the check about to start if it runs past deadline */
+  void arm(time_point deadline);
+  /* called after the check returns; true if it was interrupted */
+  bool disarm();
+  /* ends the thread, before exit() */
+  void stop();
+  [[nodiscard]] unsigned long get_interrupts() const { return interrupts; }
+
+  /* arms the watchdog for the lifetime of the guard */
+  class Guard {
+   public:
+    Guard(Watchdog& watchdog, time_point deadline) : watchdog(watchdog) {
+      watchdog.arm(deadline);
+    }
+    ~Guard() { watchdog.disarm(); }
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+   private:
+    Watchdog& watchdog;
+  };
+
+ private:
+  static constexpr std::chrono::milliseconds SIGNAL_PERIOD{10};
+  static constexpr std::chrono::milliseconds INTERRUPT_PERIOD{1};
+  static std::atomic<bool> signaled;
+  z3::context& c;
+  std::mutex mutex;
+  std::condition_variable wakeup;
+  // guarded by mutex
+  bool armed = false;
+  bool interrupted = false;
+  bool cancelled = false;
+  bool stopping = false;
+  time_point deadline;
+
+  unsigned long interrupts = 0;  // checks interrupted
+  std::thread thread;
+
+  void run();
+};
+
+#endif  // MEGASAMPLER_WATCHDOG_H
@@ -4,6 +4,8 @@
 
 #include "z3_utils.h"
 
+#include "expr_walker.h"
+
 z3::expr negate_condition(const z3::expr& cond){
   if (cond.num_args() < 2){
     throw UnsupportedOperator();
@@ -163,6 +165,14 @@ Z3_decl_kind reverse_bool_op(Z3_decl_kind op){
     return Z3_OP_SLEQ;
   } else if (op == Z3_OP_SGT){
     return Z3_OP_SLT;
+  } else if (op == Z3_OP_ULEQ){
+    return Z3_OP_UGEQ;
+  } else if (op == Z3_OP_ULT){
+    return Z3_OP_UGT;
+  } else if (op == Z3_OP_UGEQ){
+    return Z3_OP_ULEQ;
+  } else if (op == Z3_OP_UGT){
+    return Z3_OP_ULT;
   } else if (op == Z3_OP_EQ){
     return Z3_OP_EQ;
   } else if (op == Z3_OP_DISTINCT){
@@ -172,20 +182,23 @@ Z3_decl_kind reverse_bool_op(Z3_decl_kind op){
   }
 }
 
-void get_arguments_values(const z3::expr& expr, const z3::model& model, std::list<int64_t>& arguments_values){
+bool get_arguments_values(const z3::expr& expr, const z3::model& model, std::list<int64_t>& arguments_values){
   for (unsigned int i=0; i<expr.num_args(); i++){
     const z3::expr& child = expr.arg(i);
-    int64_t value = model_eval_to_int64(model, child);
+    int64_t value;
+    if (!model.eval(child, true).is_numeral_i64(value)) return false;
     arguments_values.push_back(value);
   }
+  return true;
 }
 
 int count_selects(const z3::expr& e) {
-  if (!e.is_app()) return 0;
-  int count = (e.decl().decl_kind() == Z3_OP_SELECT);
-  for (unsigned int i = 0; i < e.num_args(); i++) {
-    count += count_selects(e.arg(i));
-  }
+  int count = 0;
+  ExprWalker walker;
+  walker.walk(e, [&count](const z3::expr& sub) {
+    count += sub.is_app() && sub.decl().decl_kind() == Z3_OP_SELECT;
+    return true;
+  });
   return count;
 }
 
@@ -193,14 +206,15 @@ bool is_array_eq(const z3::expr& e) {
   return e.is_eq() && e.arg(0).is_array();
 }
 
-void collect_vars(z3::expr& expr, z3::expr_vector& vars_collection){
-  if (expr.is_const() && !expr.is_numeral()){
-    vars_collection.push_back(expr);
-    return;
-  }
-  for (auto arg : expr){
-    collect_vars(arg, vars_collection);
-  }
+void collect_vars(const z3::expr& expr, z3::expr_vector& vars_collection){
+  ExprWalker walker;
+  walker.walk(expr, [&vars_collection](const z3::expr& e) {
+    if (e.is_const() && !e.is_numeral()) {
+      vars_collection.push_back(e);
+      return false;
+    }
+    return true;
+  });
 }
 
 int64_t to_integer(z3::expr expr) {
@@ -218,3 +232,19 @@ int64_t to_integer(z3::expr expr) {
   }
   return res;
 }
+
+uint64_t model_eval_to_uint64(const z3::model& model, const z3::expr& bv_expr) {
+  assert(bv_expr.is_bv() && bv_expr.get_sort().bv_size() <= 64);
+  return model.eval(bv_expr, true).get_numeral_uint64();
+}
+
+int64_t bv_to_box(uint64_t value, unsigned int width) {
+  if (width == 64) value ^= ((uint64_t)1) << 63;
+  return (int64_t)value;
+}
+
+uint64_t bv_from_box(int64_t value, unsigned int width) {
+  uint64_t res = (uint64_t)value;
+  if (width == 64) res ^= ((uint64_t)1) << 63;
+  return res;
+}
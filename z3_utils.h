@@ -45,11 +45,20 @@ z3::expr simplify_strict_to_nonstrict(const z3::expr& expr);
 std::string op_to_string(Z3_decl_kind op);
 bool is_numeral_constant(const z3::expr& expr);
 Z3_decl_kind reverse_bool_op(Z3_decl_kind op);
-void get_arguments_values(const z3::expr& expr, const z3::model& model, std::list<int64_t>& arguments_values);
+/* returns false if a value doesn't fit in int64 */
+bool get_arguments_values(const z3::expr& expr, const z3::model& model, std::list<int64_t>& arguments_values);
+/* distinct select terms in e */
 int count_selects(const z3::expr& e);
 bool is_array_eq(const z3::expr& e);
-void collect_vars(z3::expr& expr, z3::expr_vector& vars_collection);
+/* the distinct constants in expr */
+void collect_vars(const z3::expr& expr, z3::expr_vector& vars_collection);
 int64_t to_integer(z3::expr expr);
+/* unsigned value of a bit-vector of at most 64 bits in the model */
+uint64_t model_eval_to_uint64(const z3::model& model, const z3::expr& bv_expr);
+/* bit-vectors are kept in an IntervalMap by their unsigned value; 64-bit ones
+ * get the sign bit flipped, so that the order survives the cast to int64_t */
+int64_t bv_to_box(uint64_t value, unsigned int width);
+uint64_t bv_from_box(int64_t value, unsigned int width);
 
 
 #endif //MEGASAMPLER_Z3_UTILS_H